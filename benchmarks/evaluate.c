@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/utils/entities.h"
+#include "../src/utils/evaluate.h"
+
+#define NUMBER_OF_JOBS 100
+#define NUMBER_OF_CANDIDATES 16384
+#define REPETITIONS 20
+
+double now(void);
+void shuffle(int *sequence, int n);
+
+int main(int argc, char **argv) {
+  int n = NUMBER_OF_JOBS;
+  int candidates = NUMBER_OF_CANDIDATES;
+  if (argc > 1)
+    n = atoi(argv[1]);
+  if (argc > 2)
+    candidates = atoi(argv[2]);
+  if (n <= 1 || candidates <= 0) {
+    fprintf(stderr, "Usage: %s [jobs candidates]\n", argv[0]);
+    return -1;
+  }
+
+  srand(42);
+  int *p_js = malloc(sizeof(*p_js) * n);
+  int *r_js = malloc(sizeof(*r_js) * n);
+  int *sequences = malloc(sizeof(*sequences) * n * candidates);
+  long long *expected = malloc(sizeof(*expected) * candidates);
+  int *c_hs = malloc(sizeof(*c_hs) * n);
+  batch_t *batch = batch_init(n, candidates);
+  if (p_js == NULL || r_js == NULL || sequences == NULL || expected == NULL ||
+      c_hs == NULL || batch == NULL) {
+    perror("Could not allocate memory for benchmark");
+    return -1;
+  }
+  for (size_t j = 0; j < n; j++) {
+    p_js[j] = 1 + rand() % 50;
+    r_js[j] = 1 + rand() % 50;
+  }
+  instance_t instance = {.number_of_jobs = n,
+                         .processing_times = p_js,
+                         .release_dates = r_js,
+                         .orders = NULL,
+                         .model = NULL};
+
+  for (size_t k = 0; k < candidates; k++) {
+    int *sequence = sequences + k * n;
+    for (size_t h = 0; h < n; h++) {
+      sequence[h] = h;
+    }
+    shuffle(sequence, n);
+    batch_add(batch, sequence);
+  }
+
+  // Scalar loop: one permutation at a time
+  double start = now();
+  long long checksum = 0;
+  for (size_t i = 0; i < REPETITIONS; i++) {
+    for (size_t k = 0; k < candidates; k++) {
+      expected[k] = evaluate(&instance, sequences + k * n, NULL);
+      checksum += expected[k];
+    }
+  }
+  double scalar = now() - start;
+
+  // Batch: one permutation per SIMD lane
+  start = now();
+  for (size_t i = 0; i < REPETITIONS; i++) {
+    evaluate_batch(&instance, batch);
+  }
+  double batched = now() - start;
+
+  for (size_t k = 0; k < candidates; k++) {
+    if (batch->objectives[k] != expected[k]) {
+      fprintf(stderr, "Candidate %ld: batch %lld, scalar %lld\n", k,
+              batch->objectives[k], expected[k]);
+      return -1;
+    }
+  }
+
+  // Full neighbourhood of pairwise swaps: incremental deltas vs re-evaluation
+  long long objective = evaluate(&instance, sequences, c_hs);
+  long long moves = (long long)n * (n - 1) / 2;
+  start = now();
+  for (size_t a = 0; a < n; a++) {
+    for (size_t b = a + 1; b < n; b++) {
+      checksum += evaluate_swap_delta(&instance, sequences, c_hs, a, b);
+    }
+  }
+  double deltas = now() - start;
+  start = now();
+  for (size_t a = 0; a < n; a++) {
+    for (size_t b = a + 1; b < n; b++) {
+      int t = sequences[a];
+      sequences[a] = sequences[b];
+      sequences[b] = t;
+      checksum += evaluate(&instance, sequences, NULL) - objective;
+      sequences[b] = sequences[a];
+      sequences[a] = t;
+    }
+  }
+  double full = now() - start;
+
+  double evaluated = (double)candidates * REPETITIONS;
+  printf("Jobs: %d, candidates: %d, kernel: %s (checksum %lld)\n", n,
+         candidates, evaluate_kernel(), checksum);
+  printf("Scalar loop:\t%12.0f candidates/s\n", evaluated / scalar);
+  printf("Batch:\t\t%12.0f candidates/s (%.2fx)\n", evaluated / batched,
+         scalar / batched);
+  printf("Swap re-eval:\t%12.0f moves/s\n", moves / full);
+  printf("Swap delta:\t%12.0f moves/s (%.2fx)\n", moves / deltas,
+         full / deltas);
+
+  batch_free(batch);
+  free(p_js);
+  free(r_js);
+  free(sequences);
+  free(expected);
+  free(c_hs);
+  return 0;
+}
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void shuffle(int *sequence, int n) {
+  for (int i = n - 1; i > 0; i--) {
+    int k = rand() % (i + 1);
+    int t = sequence[i];
+    sequence[i] = sequence[k];
+    sequence[k] = t;
+  }
+}
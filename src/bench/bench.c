@@ -0,0 +1,335 @@
+#include "bench.h"
+#include "../run/backend/backend.h"
+#include "../run/model/model.h"
+#include "../run/run.h"
+#include "../utils/arena.h"
+#include "../utils/csv.h"
+#include "../utils/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Row used for the stages that are not tied to a formulation (load, env)
+#define SUITE_ROW NUMBER_OF_SOLVERS
+
+typedef struct {
+  long allocations;      // Buffers taken from the arena by the builds
+  long heap_allocations; // Arena chunks requested from malloc meanwhile
+  size_t peak;           // Largest build, bytes
+} arena_usage_t;
+
+typedef struct {
+  measure_t stages[NUMBER_OF_SOLVERS + 1][NUMBER_OF_STAGES];
+  arena_usage_t arena[NUMBER_OF_SOLVERS];
+  int solved[NUMBER_OF_SOLVERS];
+  int errors[NUMBER_OF_SOLVERS];
+  int instances;
+} report_t;
+
+int bench_file(const bench_options_t *options, const char *filename,
+               report_t *report, FILE *sol_fp);
+int bench_compare(const bench_options_t *options, const report_t *report,
+                  FILE *json_fp);
+int bench_save_baseline(const char *filename, const report_t *report);
+void json_measure(FILE *fp, const measure_t *measure);
+
+int bench(const bench_options_t *options) {
+  int result = 0;
+  report_t *report = malloc(sizeof(*report));
+  if (report == NULL) {
+    perror("Could not allocate memory for benchmark report");
+    return -1;
+  }
+  memset(report, 0, sizeof(*report));
+
+  if ((result = create_folder("output")) != 0) {
+    perror("Could not create folder output");
+    free(report);
+    return result;
+  }
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    // Solved without a model
+    if (solver == DynamicProgramming)
+      continue;
+    char *solver_folder = formatted_string("output/%d", solver);
+    if (solver_folder == NULL || create_folder(solver_folder) != 0) {
+      perror("Could not create solver folder");
+      free(solver_folder);
+      free(report);
+      return -1;
+    }
+    free(solver_folder);
+    solver_folder = NULL;
+  }
+
+  FILE *sol_fp = fopen("output/bench-solution.csv", "w");
+  if (sol_fp == NULL) {
+    perror("Could not open bench-solution.csv");
+    free(report);
+    return -1;
+  }
+  fprintf(sol_fp, "Solver,Instance,Status,Runtime,Solution,Heuristic\n");
+
+  for (size_t f = 0; f < options->suite_length && result == 0; f++) {
+    printf("Benchmarking %s\n", options->suite[f]);
+    result = bench_file(options, options->suite[f], report, sol_fp);
+  }
+  fclose(sol_fp);
+  if (result != 0) {
+    free(report);
+    return result;
+  }
+
+  FILE *json_fp = fopen(options->output, "w");
+  if (json_fp == NULL) {
+    perror_formatted("Could not open %s", options->output);
+    free(report);
+    return -1;
+  }
+  fprintf(json_fp, "{\n  \"suite\": [");
+  for (size_t f = 0; f < options->suite_length; f++) {
+    fprintf(json_fp, "%s\"%s\"", f == 0 ? "" : ", ", options->suite[f]);
+  }
+  fprintf(json_fp, "],\n  \"instances\": %d,\n  \"time_limit\": %.2f,\n",
+          report->instances, options->time_limit);
+  fprintf(json_fp, "  \"suite_stages\": {");
+  for (stage_t stage = Stage_Load; stage <= Stage_Environment; stage++) {
+    fprintf(json_fp, "%s\"%s\": ", stage == Stage_Load ? "" : ", ",
+            stage_name(stage));
+    json_measure(json_fp, &report->stages[SUITE_ROW][stage]);
+  }
+  fprintf(json_fp, "},\n  \"formulations\": [\n");
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    if (solver == DynamicProgramming)
+      continue;
+    fprintf(json_fp,
+            "    {\"solver\": %d, \"name\": \"%s\", \"solved\": %d, "
+            "\"errors\": %d, \"stages\": {",
+            solver, solver_name(solver), report->solved[solver],
+            report->errors[solver]);
+    for (stage_t stage = Stage_Build; stage <= Stage_Export; stage++) {
+      fprintf(json_fp, "%s\"%s\": ", stage == Stage_Build ? "" : ", ",
+              stage_name(stage));
+      json_measure(json_fp, &report->stages[solver][stage]);
+    }
+    const arena_usage_t *arena = &report->arena[solver];
+    fprintf(json_fp,
+            "}, \"arena\": {\"allocations\": %ld, \"heap_allocations\": %ld, "
+            "\"peak_bytes\": %zu}}%s\n",
+            arena->allocations, arena->heap_allocations, arena->peak,
+            solver + 1 == NUMBER_OF_SOLVERS ? "" : ",");
+  }
+  fprintf(json_fp, "  ],\n");
+  result = bench_compare(options, report, json_fp);
+  fprintf(json_fp, "}\n");
+  fclose(json_fp);
+  printf("Benchmark report saved in %s\n", options->output);
+
+  if (result >= 0 && options->save_baseline != NULL &&
+      bench_save_baseline(options->save_baseline, report) != 0)
+    result = -1;
+
+  free(report);
+  return result;
+}
+
+int bench_file(const bench_options_t *options, const char *filename,
+               report_t *report, FILE *sol_fp) {
+  int result = 0;
+  measure_t start, end;
+
+  vector_t *instances = vector_init();
+  if (instances == NULL)
+    return -1;
+  measure_now(&start);
+  if ((result = load_csv(filename, instances)) != 0)
+    return result;
+  measure_now(&end);
+  measure_add(&report->stages[SUITE_ROW][Stage_Load], &start, &end);
+
+  measure_now(&start);
+  simulation_t *sim = environment_init(instances);
+  if (sim == NULL)
+    return -1;
+  measure_now(&end);
+  measure_add(&report->stages[SUITE_ROW][Stage_Environment], &start, &end);
+
+  int length = sim->instances->length;
+  if (options->limit > 0 && options->limit < length)
+    length = options->limit;
+  report->instances += length;
+
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    if (solver == DynamicProgramming)
+      continue;
+    measure_t *stages = report->stages[solver];
+    for (size_t i = 0; i < length; i++) {
+      int heuristic_value = -1;
+      instance_t *instance = sim->instances->values[i];
+
+      // The builds only reach the heap when the arena has to grow
+      long allocations = sim->arena->allocations;
+      long heap_allocations = sim->arena->heap_allocations;
+      sim->arena->peak = 0;
+      measure_now(&start);
+      result = model_init(sim, i, solver, &heuristic_value);
+      if (result == 0 &&
+          (result = sim->backend->set_dbl_param(
+               instance->model, PARAM_TIME_LIMIT, options->time_limit)) != 0)
+        log_error(sim, result, "set_dbl_param(\"TimeLimit\")");
+      measure_now(&end);
+      measure_add(&stages[Stage_Build], &start, &end);
+      arena_usage_t *arena = &report->arena[solver];
+      arena->allocations += sim->arena->allocations - allocations;
+      arena->heap_allocations +=
+          sim->arena->heap_allocations - heap_allocations;
+      if (sim->arena->peak > arena->peak)
+        arena->peak = sim->arena->peak;
+      if (result != 0) {
+        report->errors[solver] += 1;
+        continue;
+      }
+
+      measure_now(&start);
+      save_model(sim, i, solver, "lp");
+      measure_now(&end);
+      measure_add(&stages[Stage_Write], &start, &end);
+
+      measure_now(&start);
+      solution_t *solution = model_optimize(sim, i, solver);
+      measure_now(&end);
+      measure_add(&stages[Stage_Optimize], &start, &end);
+      if (solution == NULL) {
+        report->errors[solver] += 1;
+      } else {
+        if (solution->status == STATUS_OPTIMAL)
+          report->solved[solver] += 1;
+
+        measure_now(&start);
+        fprintf(sol_fp, "%d,%ld,%d,%.2f,%.2f,%d\n", solver, i + 1,
+                solution->status, solution->runtime,
+                solution->objective_value, heuristic_value);
+        save_model(sim, i, solver, "sol");
+        measure_now(&end);
+        measure_add(&stages[Stage_Export], &start, &end);
+
+        free(solution->values);
+        solution->values = NULL;
+        free(solution);
+        solution = NULL;
+      }
+
+      if ((result = sim->backend->model_free(instance->model)) != 0)
+        log_error(sim, result, "model_free");
+      instance->model = NULL;
+      result = 0;
+    }
+  }
+
+  return simulation_free(sim);
+}
+
+int bench_compare(const bench_options_t *options, const report_t *report,
+                  FILE *json_fp) {
+  int regressions = 0;
+  fprintf(json_fp, "  \"baseline\": ");
+  if (options->baseline == NULL) {
+    fprintf(json_fp, "null,\n  \"regressions\": []\n");
+    return 0;
+  }
+  fprintf(json_fp, "\"%s\",\n  \"regressions\": [", options->baseline);
+
+  FILE *fp = fopen(options->baseline, "r");
+  if (fp == NULL) {
+    perror_formatted("Could not open %s", options->baseline);
+    fprintf(json_fp, "]\n");
+    return -1;
+  }
+  // Skipping first line
+  fscanf(fp, "%*[^\n]\n");
+
+  int solver = 0;
+  int stage = 0;
+  measure_t old;
+  while (fscanf(fp, "%d,%d,%lf,%lf,%ld\n", &solver, &stage, &old.wall,
+                &old.cpu, &old.peak_rss) == 5) {
+    if (solver == -1)
+      solver = SUITE_ROW;
+    if (solver < 0 || solver > SUITE_ROW || stage < 0 ||
+        stage >= NUMBER_OF_STAGES)
+      continue;
+    const measure_t *new = &report->stages[solver][stage];
+    const char *metrics[3] = {"wall", "cpu", "peak_rss"};
+    double olds[3] = {old.wall, old.cpu, old.peak_rss};
+    double news[3] = {new->wall, new->cpu, new->peak_rss};
+    for (size_t m = 0; m < 3; m++) {
+      // Timings under BENCH_MIN_WALL are mostly noise
+      if (m < 2 && olds[m] < BENCH_MIN_WALL)
+        continue;
+      if (olds[m] <= 0 || news[m] <= olds[m] * (1 + options->threshold))
+        continue;
+      const char *name =
+          solver == SUITE_ROW ? "Suite" : solver_name((solver_t)solver);
+      fprintf(stderr, "Regression: %s %s %s %.2f -> %.2f (+%.1f%%)\n", name,
+              stage_name(stage), metrics[m], olds[m], news[m],
+              (news[m] / olds[m] - 1) * 100);
+      fprintf(json_fp,
+              "%s\n    {\"solver\": \"%s\", \"stage\": \"%s\", \"metric\": "
+              "\"%s\", \"baseline\": %.4f, \"current\": %.4f}",
+              regressions == 0 ? "" : ",", name, stage_name(stage), metrics[m],
+              olds[m], news[m]);
+      regressions += 1;
+    }
+  }
+  fclose(fp);
+  fprintf(json_fp, "%s]\n", regressions == 0 ? "" : "\n  ");
+  if (regressions > 0)
+    printf("%d regressions above %.0f%% against %s\n", regressions,
+           options->threshold * 100, options->baseline);
+  return regressions > 0 ? 1 : 0;
+}
+
+int bench_save_baseline(const char *filename, const report_t *report) {
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL) {
+    perror_formatted("Could not open %s", filename);
+    return -1;
+  }
+  // Solver -1 holds the stages shared by every formulation
+  fprintf(fp, "Solver,Stage,Wall,Cpu,PeakRss\n");
+  for (int solver = 0; solver <= SUITE_ROW; solver++) {
+    for (int stage = 0; stage < NUMBER_OF_STAGES; stage++) {
+      const measure_t *measure = &report->stages[solver][stage];
+      if (measure->wall == 0 && measure->peak_rss == 0)
+        continue;
+      fprintf(fp, "%d,%d,%.4f,%.4f,%ld\n", solver == SUITE_ROW ? -1 : solver,
+              stage, measure->wall, measure->cpu, measure->peak_rss);
+    }
+  }
+  fclose(fp);
+  printf("Benchmark baseline saved in %s\n", filename);
+  return 0;
+}
+
+void json_measure(FILE *fp, const measure_t *measure) {
+  fprintf(fp, "{\"wall\": %.4f, \"cpu\": %.4f, \"peak_rss_kb\": %ld}",
+          measure->wall, measure->cpu, measure->peak_rss);
+}
+
+const char *stage_name(stage_t stage) {
+  switch (stage) {
+  case Stage_Load:
+    return "load";
+  case Stage_Environment:
+    return "environment";
+  case Stage_Build:
+    return "build";
+  case Stage_Write:
+    return "write";
+  case Stage_Optimize:
+    return "optimize";
+  case Stage_Export:
+    return "export";
+  }
+  return "unknown";
+}
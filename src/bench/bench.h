@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define BENCH_SUITE "results/instances.csv"
+#define BENCH_OUTPUT "output/bench.json"
+#define BENCH_TIME_LIMIT 10.0 // Seconds for every optimize stage
+#define BENCH_THRESHOLD 0.10  // Slowdown over the baseline flagged (10%)
+#define BENCH_MIN_WALL 0.05   // Faster stages are too noisy to be compared
+
+typedef enum {
+  Stage_Load,
+  Stage_Environment,
+  Stage_Build,
+  Stage_Write,
+  Stage_Optimize,
+  Stage_Export
+} stage_t;
+#define NUMBER_OF_STAGES 6
+
+typedef struct {
+  char **suite;             // Instance files to benchmark
+  int suite_length;         // Number of instance files
+  int limit;                // Instances used from every file (0: all of them)
+  double time_limit;        // Gurobi time limit of every solve
+  double threshold;         // Relative slowdown reported as a regression
+  const char *baseline;     // Baseline CSV to compare with (NULL: none)
+  const char *save_baseline; // Where to store this run as a baseline
+  const char *output;       // JSON report
+} bench_options_t;
+
+// Run every formulation on the suite, measuring wall time, CPU time and
+// peak RSS of every stage. Returns 1 when a regression is detected
+int bench(const bench_options_t *options);
+
+const char *stage_name(stage_t stage);
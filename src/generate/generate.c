@@ -1,6 +1,8 @@
 #include "generate.h"
 #include "../utils/utils.h"
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 
 int generate(const char *folder, const char *filename) {
@@ -45,6 +47,46 @@ int generate(const char *folder, const char *filename) {
   return 0;
 }
 
+instance_t *generate_instance(long seed, int jobs_ul, int processing_ul,
+                              int release_ul) {
+  plant_seeds(seed);
+  select_stream(0);
+  int number_of_jobs = uniform(1, jobs_ul);
+  instance_t *instance = malloc(sizeof(*instance));
+  int *p_js = malloc(sizeof(*p_js) * number_of_jobs);
+  int *r_js = malloc(sizeof(*r_js) * number_of_jobs);
+  if (instance == NULL || p_js == NULL || r_js == NULL) {
+    perror("Could not allocate memory for instance");
+    free(instance);
+    free(p_js);
+    free(r_js);
+    return NULL;
+  }
+  // Same streams as `generate`
+  for (size_t job = 0; job < number_of_jobs; job++) {
+    select_stream(1);
+    p_js[job] = uniform(1, processing_ul);
+    select_stream(2);
+    r_js[job] = uniform(1, release_ul);
+  }
+  instance->number_of_jobs = number_of_jobs;
+  instance->processing_times = p_js;
+  instance->release_dates = r_js;
+  instance->orders = NULL;
+  instance->model = NULL;
+  return instance;
+}
+
+long generate_seed(long base, long k) {
+  // SplitMix64: consecutive k give unrelated Lehmer states, close states
+  // would give close first draws
+  uint64_t z = (uint64_t)base * 0x9e3779b97f4a7c15ULL + (uint64_t)k + 1;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return 1 + (long)(z % (MODULUS - 1));
+}
+
 /*
  * From Discrete Event Simulation, Leemis Park
  */
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../utils/entities.h"
+
 #define ARRAY_SIZE 2
 #define NUMBER_OF_INSTANCES 5
 // Stream 0
@@ -13,6 +15,12 @@
   (int[ARRAY_SIZE + 1]) { 10, 25, 50 }
 
 int generate(const char *folder, const char *filename);
+// Instance of the class (jobs, processing times, release dates upper limits)
+// drawn from streams planted with `seed` alone: the same seed gives it again
+instance_t *generate_instance(long seed, int jobs_ul, int processing_ul,
+                              int release_ul);
+// Seed of the k-th instance of a sweep started from `base`, in (0, MODULUS)
+long generate_seed(long base, long k);
 
 // from rngs in Discrete Event Simulation, Leemis Park
 #define MODULUS 2147483647 /* DON'T CHANGE THIS VALUE                  */
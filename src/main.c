@@ -1,12 +1,41 @@
+#include "bench/bench.h"
 #include "generate/generate.h"
+#include "merge/merge.h"
+#include "online/online.h"
+#include "pipeline/pipeline.h"
+#include "relax/relax.h"
+#include "report/report.h"
+#include "run/block.h"
+#include "run/cache.h"
+#include "run/dp.h"
+#include "run/lns.h"
+#include "run/memory.h"
+#include "run/profile.h"
+#include "run/refine.h"
 #include "run/run.h"
+#include "run/status.h"
+#include "serve/serve.h"
+#include "stats/stats.h"
+#include "tune/tune.h"
+#include "utils/results.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 int print_help_screen();
 int generate_command(int argc, char **argv);
 int run_command(int argc, char **argv);
+int bench_command(int argc, char **argv);
+int stats_command(int argc, char **argv);
+int relax_command(int argc, char **argv);
+int online_command(int argc, char **argv);
+int serve_command(int argc, char **argv);
+int report_command(int argc, char **argv);
+int tune_command(int argc, char **argv);
+int pipeline_command(int argc, char **argv);
+int merge_command(int argc, char **argv);
 
 int main(int argc, char **argv) {
   if (argc > 1) {
@@ -14,6 +43,24 @@ int main(int argc, char **argv) {
       return print_help_screen();
     else if (!strcmp(argv[1], "generate"))
       return generate_command(argc, argv);
+    else if (!strcmp(argv[1], "bench"))
+      return bench_command(argc, argv);
+    else if (!strcmp(argv[1], "stats"))
+      return stats_command(argc, argv);
+    else if (!strcmp(argv[1], "relax"))
+      return relax_command(argc, argv);
+    else if (!strcmp(argv[1], "online"))
+      return online_command(argc, argv);
+    else if (!strcmp(argv[1], "serve"))
+      return serve_command(argc, argv);
+    else if (!strcmp(argv[1], "report"))
+      return report_command(argc, argv);
+    else if (!strcmp(argv[1], "tune"))
+      return tune_command(argc, argv);
+    else if (!strcmp(argv[1], "pipeline"))
+      return pipeline_command(argc, argv);
+    else if (!strcmp(argv[1], "merge"))
+      return merge_command(argc, argv);
   }
   return run_command(argc, argv);
 }
@@ -32,22 +79,440 @@ int generate_command(int argc, char **argv) {
 }
 
 int run_command(int argc, char **argv) {
-  int workers = 8;
+  run_options_t options = {.filename = "output/instances.csv",
+                           .budget = 0,
+                           .cache = CACHE_FOLDER,
+                           .transfer = 1,
+                           .workers = blocks_workers(),
+                           .refine = REFINE_MAX_VARS,
+                           .exact = 0,
+                           .lns = 0,
+                           .memory = memory_physical() * MEMORY_SHARE,
+                           .shard = 1,
+                           .shards = 1,
+                           .status = 1};
+  // `amod run ...` is `amod ...`
+  int first = argc > 1 && !strcmp(argv[1], "run") ? 2 : 1;
+  for (int i = first; i < argc; i++) {
+    if (!strcmp(argv[i], "--budget") && i + 1 < argc)
+      options.budget = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--cache") && i + 1 < argc)
+      options.cache = argv[++i];
+    else if (!strcmp(argv[i], "--no-cache"))
+      options.cache = NULL;
+    else if (!strcmp(argv[i], "--no-transfer"))
+      options.transfer = 0;
+    else if (!strcmp(argv[i], "--lns"))
+      options.lns = 1;
+    else if (!strcmp(argv[i], "--no-status"))
+      options.status = 0;
+    else if (!strcmp(argv[i], "--workers") && i + 1 < argc)
+      options.workers = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--refine") && i + 1 < argc)
+      options.refine = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--exact") && i + 1 < argc) {
+      options.exact = atoi(argv[++i]);
+      if (options.exact > DP_JOBS_LIMIT)
+        options.exact = DP_JOBS_LIMIT;
+    } else if (!strcmp(argv[i], "--memory") && i + 1 < argc)
+      options.memory = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--shard") && i + 1 < argc) {
+      if (sscanf(argv[++i], "%d/%d", &options.shard, &options.shards) != 2 ||
+          options.shard < 1 || options.shard > options.shards) {
+        fprintf(stderr, "Invalid shard %s, expected k/N with 1 <= k <= N\n",
+                argv[i]);
+        return -1;
+      }
+    } else
+      options.filename = argv[i];
+  }
+
+  printf("Running simulation with on instances from %s\n", options.filename);
+  return run(&options);
+}
+
+int bench_command(int argc, char **argv) {
+  char *default_suite[1] = {BENCH_SUITE};
+  bench_options_t options = {.suite = default_suite,
+                             .suite_length = 1,
+                             .limit = 0,
+                             .time_limit = BENCH_TIME_LIMIT,
+                             .threshold = BENCH_THRESHOLD,
+                             .baseline = NULL,
+                             .save_baseline = NULL,
+                             .output = BENCH_OUTPUT};
+  // Instance files are collected in place at the start of argv
+  char **suite = argv + 2;
+  int suite_length = 0;
+  for (int i = 2; i < argc; i++) {
+    int has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--baseline") && has_value)
+      options.baseline = argv[++i];
+    else if (!strcmp(argv[i], "--save-baseline") && has_value)
+      options.save_baseline = argv[++i];
+    else if (!strcmp(argv[i], "--threshold") && has_value)
+      options.threshold = atof(argv[++i]) / 100;
+    else if (!strcmp(argv[i], "--time-limit") && has_value)
+      options.time_limit = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--limit") && has_value)
+      options.limit = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--output") && has_value)
+      options.output = argv[++i];
+    else
+      suite[suite_length++] = argv[i];
+  }
+  if (suite_length > 0) {
+    options.suite = suite;
+    options.suite_length = suite_length;
+  }
+  int result = bench(&options);
+  if (result < 0)
+    perror("Error while running benchmark");
+  return result;
+}
+
+int stats_command(int argc, char **argv) {
   char *filename = "output/instances.csv";
-  if (argc == 3)
-    filename = argv[3];
+  int *targets = STATS_TARGETS;
+  int targets_size = STATS_TARGETS_SIZE;
+  if (argc > 2)
+    filename = argv[2];
+  // Comma separated list of sizes to extrapolate to
+  if (argc > 3) {
+    targets_size = 1;
+    for (char *c = argv[3]; *c != '\0'; c++) {
+      if (*c == ',')
+        targets_size += 1;
+    }
+    targets = malloc(sizeof(*targets) * targets_size);
+    if (targets == NULL) {
+      perror("Could not allocate memory for targets");
+      return -1;
+    }
+    char *token = strtok(argv[3], ",");
+    for (size_t t = 0; t < targets_size && token != NULL; t++) {
+      targets[t] = atoi(token);
+      token = strtok(NULL, ",");
+    }
+  }
 
-  printf("Running simulation with on instances from %s\n", filename);
-  return run(filename);
+  printf("Building models (without optimizing) of instances from %s\n",
+         filename);
+  int result = stats(filename, targets, targets_size);
+  if (result != 0)
+    perror("Error while collecting model statistics");
+  if (argc > 3)
+    free(targets);
+  return result;
+}
+
+int relax_command(int argc, char **argv) {
+  relax_options_t options = {.filename = "output/instances.csv",
+                             .method = -1,
+                             .time_limit = RELAX_TIME_LIMIT};
+  for (int i = 2; i < argc; i++) {
+    int has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--method") && has_value) {
+      if ((options.method = relax_method(argv[++i])) < -1) {
+        fprintf(stderr, "Unknown method %s, expected auto, dual, barrier or "
+                        "concurrent\n",
+                argv[i]);
+        return -1;
+      }
+    } else if (!strcmp(argv[i], "--time-limit") && has_value)
+      options.time_limit = atof(argv[++i]);
+    else
+      options.filename = argv[i];
+  }
+
+  printf("Solving the LP relaxations of instances from %s\n",
+         options.filename);
+  int result = relax(&options);
+  if (result != 0)
+    perror("Error while solving relaxations");
+  return result;
+}
+
+int online_command(int argc, char **argv) {
+  online_options_t options = {.filename = "output/instances.csv",
+                              .budget = ONLINE_BUDGET / 1000,
+                              .lead = 0,
+                              .exact = ONLINE_EXACT,
+                              .solver = Positional};
+  for (int i = 2; i < argc; i++) {
+    int has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--budget") && has_value)
+      options.budget = atof(argv[++i]) / 1000;
+    else if (!strcmp(argv[i], "--lead") && has_value)
+      options.lead = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--exact") && has_value) {
+      options.exact = atoi(argv[++i]);
+      if (options.exact > DP_JOBS_LIMIT)
+        options.exact = DP_JOBS_LIMIT;
+    } else if (!strcmp(argv[i], "--solver") && has_value) {
+      options.solver = atoi(argv[++i]);
+      if (options.solver < 0 || options.solver >= NUMBER_OF_SOLVERS ||
+          options.solver == DynamicProgramming) {
+        fprintf(stderr, "Unknown formulation %s\n", argv[i]);
+        return -1;
+      }
+      options.solver = solver_formulation(options.solver);
+    } else if (!strcmp(argv[i], "--no-model"))
+      options.solver = -1;
+    else
+      options.filename = argv[i];
+  }
+
+  printf("Replaying the instances from %s as arrivals\n", options.filename);
+  int result = online(&options);
+  if (result != 0)
+    perror("Error while replaying arrivals");
+  return result;
+}
+
+int serve_command(int argc, char **argv) {
+  serve_options_t options = {.socket = SERVE_SOCKET,
+                             .workers = blocks_workers(),
+                             .time_limit = SERVE_TIME_LIMIT,
+                             .exact = DP_MAX_JOBS,
+                             .memory = memory_physical() * MEMORY_SHARE};
+  for (int i = 2; i < argc; i++) {
+    int has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--socket") && has_value)
+      options.socket = argv[++i];
+    else if (!strcmp(argv[i], "--stdin"))
+      options.socket = NULL;
+    else if (!strcmp(argv[i], "--workers") && has_value)
+      options.workers = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--time-limit") && has_value) {
+      options.time_limit = atof(argv[++i]);
+      if (!isfinite(options.time_limit) || options.time_limit <= 0) {
+        fprintf(stderr, "Invalid time limit %s\n", argv[i]);
+        return -1;
+      }
+    } else if (!strcmp(argv[i], "--exact") && has_value) {
+      options.exact = atoi(argv[++i]);
+      if (options.exact > DP_JOBS_LIMIT)
+        options.exact = DP_JOBS_LIMIT;
+    } else if (!strcmp(argv[i], "--memory") && has_value) {
+      options.memory = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "Unknown option %s\n", argv[i]);
+      return -1;
+    }
+  }
+
+  int result = serve(&options);
+  if (result != 0)
+    perror("Error while serving requests");
+  return result;
+}
+
+int report_command(int argc, char **argv) {
+  report_options_t options = {.store = RESULTS_STORE,
+                              .imports = argv + 2,
+                              .imports_length = 0,
+                              .instances = REPORT_INSTANCES,
+                              .output = REPORT_OUTPUT};
+  // Imported files are collected in place at the start of argv
+  for (int i = 2; i < argc; i++) {
+    int has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--import") && has_value)
+      options.imports[options.imports_length++] = argv[++i];
+    else if (!strcmp(argv[i], "--instances") && has_value)
+      options.instances = argv[++i];
+    else if (!strcmp(argv[i], "--output") && has_value)
+      options.output = argv[++i];
+    else
+      options.store = argv[i];
+  }
+  int result = report(&options);
+  if (result != 0)
+    perror("Error while reporting results");
+  return result;
+}
+
+int tune_command(int argc, char **argv) {
+  tune_options_t options = {.filename = "output/instances.csv",
+                            .samples = TUNE_SAMPLES,
+                            .seeds = TUNE_SEEDS,
+                            .time_limit = TUNE_TIME_LIMIT,
+                            .profiles = PROFILE_FILE};
+  for (int i = 2; i < argc; i++) {
+    int has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--samples") && has_value)
+      options.samples = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seeds") && has_value)
+      options.seeds = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--time-limit") && has_value)
+      options.time_limit = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--profiles") && has_value)
+      options.profiles = argv[++i];
+    else
+      options.filename = argv[i];
+  }
+  int result = tune(&options);
+  if (result != 0)
+    perror("Error while tuning");
+  return result;
+}
+
+int pipeline_command(int argc, char **argv) {
+  pipeline_options_t options = {.seed = time(NULL),
+                                .instances = NUMBER_OF_INSTANCES,
+                                .workers = blocks_workers(),
+                                .queue = 0,
+                                .time_limit = PIPELINE_TIME_LIMIT,
+                                .seeds = PIPELINE_SEEDS};
+  int regenerate = 0;
+  for (int i = 2; i < argc; i++) {
+    int has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--seed") && has_value)
+      options.seed = atol(argv[++i]);
+    else if (!strcmp(argv[i], "--instances") && has_value)
+      options.instances = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--workers") && has_value)
+      options.workers = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--queue") && has_value)
+      options.queue = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--time-limit") && has_value)
+      options.time_limit = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--seeds") && has_value)
+      options.seeds = argv[++i];
+    else if (!strcmp(argv[i], "--regenerate") && has_value)
+      regenerate = atoi(argv[++i]);
+  }
+  if (regenerate > 0)
+    return pipeline_regenerate(options.seeds, regenerate, stdout);
+  if (options.queue <= 0 && options.workers > 0)
+    options.queue = PIPELINE_QUEUE * options.workers;
+  int result = pipeline(&options);
+  if (result != 0)
+    perror("Error while running the pipeline");
+  return result;
+}
+
+int merge_command(int argc, char **argv) {
+  int shards = argc > 2 ? atoi(argv[2]) : 0;
+  if (shards < 1) {
+    fprintf(stderr, "Usage: amod merge N\n");
+    return -1;
+  }
+  int result = merge(shards);
+  if (result != 0)
+    perror("Error while merging shards");
+  return result;
 }
 
 int print_help_screen() {
   printf("AMOD Project\n\n");
   printf("Usage:\n");
-  printf(
-      "\tamod [filename]\t\t\tRun simulation (default: output/instances.csv\n");
+  printf("\tamod [run] [filename]\t\tRun simulation (default: "
+         "output/instances.csv)\n");
+  printf("\t\t--budget seconds\tTotal time of the run, split among the "
+         "solves (default: 300 every solve)\n");
+  printf("\t\t--cache folder\t\tSolution cache (default: " CACHE_FOLDER
+         ")\n");
+  printf("\t\t--no-cache\t\tSolve everything, without cached starts\n");
+  printf("\t\t--no-transfer\t\tSolves do not start from the best schedule "
+         "of the previous formulations\n");
+  printf("\t\t--workers n\t\tThreads solving the idle-gap blocks, 0 to "
+         "solve whole instances (default: processors)\n");
+  printf("\t\t--refine variables	Larger time indexed models are solved "
+         "coarse then refined, 0 to never refine (default: %d)\n",
+         REFINE_MAX_VARS);
+  printf("\t\t--exact n\t\tInstances and blocks of up to n jobs (at most "
+         "%d) skip the models, status %d (default: 0, always build them)\n",
+         DP_JOBS_LIMIT, STATUS_EXACT);
+  printf("\t\t--lns\t\t\tPositional models of %d jobs or more are "
+         "searched by neighbourhoods on --workers threads\n",
+         LNS_MIN_JOBS);
+  printf("\t\t--memory GB		Memory of the models solved at once, 0 for no "
+         "limit (default: 80%% of the physical memory)\n");
+  printf("\t\t--no-status\t\tNo live metrics in " STATUS_FILE " and "
+         STATUS_SOCKET "\n");
   printf("\tamod help\t\t\tShow help screen\n");
   printf("\tamod generate [folder filename]\tGenerate instances in filename "
          "(default: output instances.csv)\n");
+  printf("\tamod bench [options] [files]\tBenchmark every stage of every "
+         "formulation (default: " BENCH_SUITE ")\n");
+  printf("\t\t--baseline file\t\tCompare with a saved baseline\n");
+  printf("\t\t--save-baseline file\tSave this run as a baseline\n");
+  printf("\t\t--threshold percent\tRegression threshold (default: 10)\n");
+  printf("\t\t--time-limit seconds\tTime limit of every solve (default: "
+         "10)\n");
+  printf("\t\t--limit n\t\tInstances used from every file\n");
+  printf("\t\t--output file\t\tJSON report (default: " BENCH_OUTPUT
+         ")\n");
+  printf("\tamod stats [filename [n,...]]\tBuild every model without "
+         "optimizing, extrapolating sizes to n jobs (default: 200,500,1000)"
+         "\n");
+  printf("\tamod relax [options] [filename]\tSolve only the LP relaxation "
+         "of every model, comparing the root bounds\n");
+  printf("\t\t--method name\t\tauto, dual, barrier or concurrent "
+         "(default: auto)\n");
+  printf("\t\t--time-limit seconds\tTime limit of every LP (default: "
+         "300)\n");
+  printf("\tamod online [options] [filename]\tReplay every instance as jobs "
+         "arriving over time, re-optimizing the uncommitted jobs\n");
+  printf("\t\t--budget ms\t\tTime of every re-optimization (default: "
+         "%g)\n",
+         ONLINE_BUDGET);
+  printf("\t\t--lead t\t\tJobs are known t before their release date "
+         "(default: 0)\n");
+  printf("\t\t--exact n\t\tSuffixes of up to n jobs are solved exactly "
+         "(default: %d)\n",
+         ONLINE_EXACT);
+  printf("\t\t--solver k\t\tFormulation of the larger suffixes (default: "
+         "1, positional)\n");
+  printf("\t\t--no-model\t\tOnly heuristics for the larger suffixes\n");
+  printf("\tamod serve [options]\t\tSolve the instances of requests with "
+         "warm environments until stopped\n");
+  printf("\t\t--socket path\t\tUnix socket of the requests (default: "
+         SERVE_SOCKET ")\n");
+  printf("\t\t--stdin\t\t\tRequests on stdin, answers on stdout\n");
+  printf("\t\t--workers n\t\tThreads solving the requests (default: "
+         "processors)\n");
+  printf("\t\t--time-limit seconds\tTime limit of the requests without "
+         "one (default: %g)\n",
+         SERVE_TIME_LIMIT);
+  printf("\t\t--exact n\t\tInstances of up to n jobs skip the models "
+         "(default: %d)\n",
+         DP_MAX_JOBS);
+  printf("\t\t--memory GB		Memory of the models solved at once, 0 for no "
+         "limit (default: 80%% of the physical memory)\n");
+  printf("\tamod report [options] [store]\tAggregate the results store "
+         "(default: " RESULTS_STORE ")\n");
+  printf("\t\t--import file\t\tAppend a solution CSV to the store "
+         "first\n");
+  printf("\t\t--instances file\tInstances of the imported solutions "
+         "(default: " REPORT_INSTANCES ")\n");
+  printf("\t\t--output prefix\t\tCSV reports (default: " REPORT_OUTPUT
+         ")\n");
+  printf("\tamod tune [options] [filename]\tTune the solver parameters of "
+         "every formulation and size class\n");
+  printf("\t\t--samples n\t\tInstances tuned on (and held out) by class "
+         "(default: 5)\n");
+  printf("\t\t--seeds n\t\tSeeds of every solve (default: 3)\n");
+  printf("\t\t--time-limit seconds\tTime limit of every solve (default: "
+         "10)\n");
+  printf("\t\t--profiles file\t\tProfiles applied by every run (default: "
+         PROFILE_FILE ")\n");
+  printf("\tamod pipeline [options]\t\tGenerate and solve at once, saving "
+         "only the seeds\n");
+  printf("\t\t--seed s\t\tBase seed of the sweep (default: time)\n");
+  printf("\t\t--instances k\t\tInstances of every class (default: %d)\n",
+         NUMBER_OF_INSTANCES);
+  printf("\t\t--workers n\t\tThreads solving the instances (default: "
+         "processors)\n");
+  printf("\t\t--queue n\t\tInstances generated ahead at most (default: "
+         "%d per worker)\n",
+         PIPELINE_QUEUE);
+  printf("\t\t--time-limit seconds\tTime limit of every solve (default: "
+         "300)\n");
+  printf("\t\t--regenerate k\t\tPrint instance k of the seeds as "
+         "instances.csv\n");
+  printf("\t\t--seeds file\t\tSeeds of the instances (default: " PIPELINE_SEEDS
+         ")\n");
   return 0;
 }
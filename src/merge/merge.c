@@ -0,0 +1,199 @@
+#include "merge.h"
+#include "../run/run.h"
+#include "../utils/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MERGE_LINE 256 // Initial line buffer, schedules are longer
+
+typedef struct {
+  int solver;
+  int instance;
+  double objective; // -1 without a solution
+  int shard;        // Rows of earlier shards win ties
+  char *line;
+} row_t;
+
+typedef struct {
+  int length;
+  int allocated_length;
+  row_t *rows;
+} rows_t;
+
+int merge_read(const char *name, int shard, int shards, int column,
+               rows_t *rows);
+char *merge_line(FILE *fp);
+int merge_write(const char *name, const char *header, rows_t *rows,
+                int solutions);
+void merge_free(rows_t *rows);
+int merge_compare(const void *a, const void *b);
+
+int merge(int shards) {
+  int result = 0;
+  rows_t solutions = {0, 0, NULL}, errors = {0, 0, NULL};
+  rows_t schedules = {0, 0, NULL};
+  // Column of the sum C_j of the rows, errors have none
+  for (int k = 1; k <= shards && result == 0; k++) {
+    if ((result = merge_read("solution", k, shards, 4, &solutions)) == 0 &&
+        (result = merge_read("schedule", k, shards, 2, &schedules)) == 0)
+      result = merge_read("error", k, shards, -1, &errors);
+  }
+  int solved = 0, failed = 0;
+  if (result == 0 &&
+      (solved = merge_write(
+           "output/solution.csv",
+           "Solver,Instance,Status,Runtime,Solution,Heuristic", &solutions,
+           1)) < 0)
+    result = -1;
+  if (result == 0 && merge_write("output/schedule.csv", RUN_SCHEDULE_HEADER,
+                                 &schedules, 1) < 0)
+    result = -1;
+  if (result == 0 &&
+      (failed = merge_write("output/error.csv", "Solver,Instance,Function",
+                            &errors, 0)) < 0)
+    result = -1;
+  if (result == 0)
+    printf("Merged %d shards: %d solutions, %d errors\n", shards, solved,
+           failed);
+  merge_free(&solutions);
+  merge_free(&schedules);
+  merge_free(&errors);
+  return result;
+}
+
+int merge_read(const char *name, int shard, int shards, int column,
+               rows_t *rows) {
+  char *filename = formatted_string(RUN_SHARD_OUTPUT, name, shard, shards);
+  if (filename == NULL)
+    return -1;
+  FILE *fp = fopen(filename, "r");
+  if (fp == NULL) {
+    // Every shard must be done before merging
+    perror_formatted("Could not open %s", filename);
+    free(filename);
+    return -1;
+  }
+  free(filename);
+
+  // Skipping first line
+  char *line = merge_line(fp);
+  if (line == NULL) {
+    fclose(fp);
+    return 0;
+  }
+  free(line);
+  while ((line = merge_line(fp)) != NULL) {
+    if (rows->length == rows->allocated_length) {
+      int allocated_length = rows->allocated_length + VECTOR_DEFAULT_SIZE * 32;
+      row_t *grown = realloc(rows->rows, sizeof(*grown) * allocated_length);
+      if (grown == NULL) {
+        perror("Could not allocate memory for merged rows");
+        free(line);
+        fclose(fp);
+        return -1;
+      }
+      rows->rows = grown;
+      rows->allocated_length = allocated_length;
+    }
+    row_t *row = &rows->rows[rows->length];
+    row->objective = -1;
+    row->shard = shard;
+    if (sscanf(line, "%d,%d", &row->solver, &row->instance) < 2) {
+      free(line);
+      continue;
+    }
+    const char *field = line;
+    for (int k = 0; k < column && field != NULL; k++) {
+      field = strchr(field, ',');
+      field = field != NULL ? field + 1 : NULL;
+    }
+    if (column >= 0 && field != NULL)
+      row->objective = atof(field);
+    row->line = line;
+    rows->length += 1;
+  }
+  fclose(fp);
+  return 0;
+}
+
+char *merge_line(FILE *fp) {
+  size_t size = MERGE_LINE, length = 0;
+  char *line = malloc(size);
+  if (line == NULL) {
+    perror("Could not allocate memory for merged line");
+    return NULL;
+  }
+  while (fgets(line + length, size - length, fp) != NULL) {
+    length += strlen(line + length);
+    if (length > 0 && line[length - 1] == '\n') {
+      line[length - 1] = '\0';
+      return line;
+    }
+    char *grown = realloc(line, size * 2);
+    if (grown == NULL) {
+      perror("Could not allocate memory for merged line");
+      free(line);
+      return NULL;
+    }
+    line = grown;
+    size *= 2;
+  }
+  // Last line without a newline
+  if (length > 0)
+    return line;
+  free(line);
+  return NULL;
+}
+
+int merge_write(const char *name, const char *header, rows_t *rows,
+                int solutions) {
+  FILE *fp = fopen(name, "w");
+  if (fp == NULL) {
+    perror_formatted("Could not open %s", name);
+    return -1;
+  }
+  fprintf(fp, "%s\n", header);
+  // Best row of every pair first
+  if (rows->length > 1)
+    qsort(rows->rows, rows->length, sizeof(*rows->rows), merge_compare);
+  int length = 0;
+  for (size_t k = 0; k < rows->length; k++) {
+    const row_t *row = &rows->rows[k];
+    if (k > 0) {
+      const row_t *previous = &rows->rows[k - 1];
+      if (previous->solver == row->solver &&
+          previous->instance == row->instance &&
+          (solutions || !strcmp(previous->line, row->line)))
+        continue;
+    }
+    fprintf(fp, "%s\n", row->line);
+    length += 1;
+  }
+  fclose(fp);
+  return length;
+}
+
+void merge_free(rows_t *rows) {
+  for (size_t k = 0; k < rows->length; k++) {
+    free(rows->rows[k].line);
+  }
+  free(rows->rows);
+  rows->rows = NULL;
+}
+
+int merge_compare(const void *a, const void *b) {
+  const row_t *row_a = a, *row_b = b;
+  if (row_a->solver != row_b->solver)
+    return row_a->solver - row_b->solver;
+  if (row_a->instance != row_b->instance)
+    return row_a->instance - row_b->instance;
+  // Solved before unsolved, then the lowest sum C_j
+  if ((row_a->objective >= 0) != (row_b->objective >= 0))
+    return row_a->objective >= 0 ? -1 : 1;
+  if (row_a->objective != row_b->objective)
+    return row_a->objective < row_b->objective ? -1 : 1;
+  if (row_a->shard != row_b->shard)
+    return row_a->shard - row_b->shard;
+  return strcmp(row_a->line, row_b->line);
+}
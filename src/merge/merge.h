@@ -0,0 +1,7 @@
+#pragma once
+
+// Combine the solution, schedule and error files of the `shards` shards of a
+// run (output/<name>.shard-<k>-<N>.csv) into output/<name>.csv, in the order
+// of a run without shards. A pair solved by several shards keeps its best
+// row, repeated errors are kept once
+int merge(int shards);
@@ -0,0 +1,462 @@
+#include "online.h"
+#include "../run/backend/backend.h"
+#include "../run/dominance.h"
+#include "../run/dp.h"
+#include "../run/model/model.h"
+#include "../run/run.h"
+#include "../utils/csv.h"
+#include "../utils/evaluate.h"
+#include "../utils/utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const double PERCENTILES[ONLINE_PERCENTILES] = {0.5, 0.9, 0.99};
+static const char *METHOD_NAMES[NUMBER_OF_ONLINE_METHODS] = {
+    "warm", "heuristic", "exact", "model"};
+
+// Machine of an instance being replayed
+typedef struct {
+  simulation_t sim;     // The suffix as instance 0, environment of the run
+  instance_t *instance;
+  instance_t *suffix;   // Planned jobs, released when the machine is free
+  int *done;            // Committed jobs in processing order
+  int committed;
+  int *plan;            // Known jobs not started yet in planned order
+  int planned;
+  long long free_at;    // Completion of the committed jobs
+  int *best;            // Suffix sequences (its own job indexes)
+  int *candidate;
+  int *c_hs;
+} online_state_t;
+
+void online_commit(online_state_t *state, long long t);
+int online_plan(online_state_t *state, const online_options_t *options,
+                long long t, int first, double deadline,
+                online_method_t *method, long long *value);
+void online_insert(online_state_t *state, int from, int *sequence);
+long long online_search(online_state_t *state, int *sequence, long long value,
+                        double deadline);
+int online_model(online_state_t *state, solver_t solver, double limit,
+                 long long value, int *sequence);
+void online_move(int *sequence, int from, int to);
+void online_latencies(double *latencies, int length, double *mean,
+                      double *percentiles, double *max);
+int online_compare(const void *a, const void *b);
+
+int online(const online_options_t *options) {
+  int result = 0;
+
+  vector_t *instances = vector_init();
+  if (instances == NULL)
+    return -1;
+  if ((result = load_csv(options->filename, instances)) != 0)
+    return result;
+  if ((result = create_folder("output")) != 0) {
+    perror("Could not create folder output");
+    return result;
+  }
+
+  simulation_t *sim = environment_init(instances);
+  if (sim == NULL)
+    return -1;
+
+  // One latency per arrival at most
+  int total = 0;
+  for (size_t i = 0; i < sim->instances->length; i++) {
+    total += ((instance_t *)sim->instances->values[i])->number_of_jobs;
+  }
+  double *latencies = malloc(sizeof(*latencies) * (total > 0 ? total : 1));
+  FILE *fp = fopen(ONLINE_OUTPUT ".csv", "w");
+  FILE *arrivals_fp = fopen(ONLINE_OUTPUT "-arrivals.csv", "w");
+  if (latencies == NULL || fp == NULL || arrivals_fp == NULL) {
+    perror("Could not open " ONLINE_OUTPUT ".csv");
+    result = -1;
+  } else {
+    fprintf(fp, "Instance,Jobs,Arrivals,Objective,Offline,MeanLatency,"
+                "P50Latency,P90Latency,P99Latency,MaxLatency,Warm,"
+                "Heuristic,Exact,Model\n");
+    fprintf(arrivals_fp, "Instance,Time,Arrived,Committed,Suffix,Method,"
+                         "SuffixObjective,Latency\n");
+  }
+
+  int length = 0;
+  for (size_t i = 0; i < sim->instances->length && result == 0; i++) {
+    online_stats_t stats;
+    if ((result = online_replay(sim, i, options, arrivals_fp,
+                                latencies + length, &stats)) != 0)
+      break;
+    length += stats.arrivals;
+    fprintf(fp, "%d,%d,%d,%lld,%lld,%.4f,%.4f,%.4f,%.4f,%.4f,%d,%d,%d,%d\n",
+            stats.instance, stats.number_of_jobs, stats.arrivals,
+            stats.objective, stats.offline, stats.mean, stats.percentiles[0],
+            stats.percentiles[1], stats.percentiles[2], stats.max,
+            stats.methods[OnlineWarm], stats.methods[OnlineHeuristic],
+            stats.methods[OnlineExact], stats.methods[OnlineModel]);
+  }
+
+  if (result == 0) {
+    double mean, percentiles[ONLINE_PERCENTILES], max;
+    online_latencies(latencies, length, &mean, percentiles, &max);
+    printf("Latency of %d arrivals (ms): mean %.3f, p50 %.3f, p90 %.3f, "
+           "p99 %.3f, max %.3f\n",
+           length, mean, percentiles[0], percentiles[1], percentiles[2],
+           max);
+    printf("Online schedules saved in %s.csv, arrivals in "
+           "%s-arrivals.csv\n",
+           ONLINE_OUTPUT, ONLINE_OUTPUT);
+  }
+
+  if (fp != NULL)
+    fclose(fp);
+  if (arrivals_fp != NULL)
+    fclose(arrivals_fp);
+  free(latencies);
+  if (simulation_free(sim) != 0)
+    return -1;
+  return result;
+}
+
+const char *online_method_name(online_method_t method) {
+  return METHOD_NAMES[method];
+}
+
+int online_replay(simulation_t *sim, size_t i, const online_options_t *options,
+                  FILE *fp, double *latencies, online_stats_t *stats) {
+  int result = 0;
+  instance_t *instance = sim->instances->values[i];
+  int n = instance->number_of_jobs;
+  memset(stats, 0, sizeof(*stats));
+  stats->instance = i + 1;
+  stats->number_of_jobs = n;
+  stats->offline = -1;
+  if (n == 0)
+    return 0;
+
+  online_state_t state = {.sim = *sim, .instance = instance};
+  state.sim.progress = NULL;
+  state.sim.instances = NULL;
+  state.suffix = malloc(sizeof(*state.suffix));
+  int *times = malloc(sizeof(*times) * n);
+  int *arrivals = malloc(sizeof(*arrivals) * n);
+  state.done = malloc(sizeof(*state.done) * n);
+  state.plan = malloc(sizeof(*state.plan) * n);
+  state.best = malloc(sizeof(*state.best) * n);
+  state.candidate = malloc(sizeof(*state.candidate) * n);
+  state.c_hs = malloc(sizeof(*state.c_hs) * n);
+  if (state.suffix != NULL) {
+    state.suffix->number_of_jobs = 0;
+    state.suffix->processing_times =
+        malloc(sizeof(*state.suffix->processing_times) * n);
+    state.suffix->release_dates =
+        malloc(sizeof(*state.suffix->release_dates) * n);
+    state.suffix->orders = NULL;
+    state.suffix->model = NULL;
+  }
+  if (state.suffix == NULL || times == NULL || arrivals == NULL ||
+      state.done == NULL || state.plan == NULL || state.best == NULL ||
+      state.candidate == NULL || state.c_hs == NULL ||
+      state.suffix->processing_times == NULL ||
+      state.suffix->release_dates == NULL ||
+      (state.sim.instances = vector_init()) == NULL) {
+    perror("Could not allocate memory for the online replay");
+    result = -1;
+  } else if (vector_add(state.sim.instances, (void **)&state.suffix) != 0) {
+    vector_free(state.sim.instances);
+    state.sim.instances = NULL;
+    result = -1;
+  }
+
+  // Jobs by the time they become known
+  for (size_t j = 0; j < n && result == 0; j++) {
+    int known = instance->release_dates[j] - options->lead;
+    times[j] = known > 0 ? known : 0;
+    arrivals[j] = j;
+  }
+  if (result == 0)
+    result = radix_sort(times, arrivals, n);
+
+  for (size_t k = 0; k < n && result == 0;) {
+    long long t = times[arrivals[k]];
+    measure_t start, end;
+    measure_now(&start);
+    online_commit(&state, t);
+    int first = state.planned, arrived = 0;
+    for (; k < n && times[arrivals[k]] == t; k++, arrived++) {
+      state.plan[state.planned++] = arrivals[k];
+    }
+    online_method_t method = OnlineWarm;
+    long long value = 0;
+    if ((result = online_plan(&state, options, t, first,
+                              start.wall + options->budget, &method,
+                              &value)) != 0)
+      break;
+    measure_now(&end);
+    double latency = (end.wall - start.wall) * 1000;
+    latencies[stats->arrivals++] = latency;
+    stats->methods[method] += 1;
+    fprintf(fp, "%d,%lld,%d,%d,%d,%s,%lld,%.4f\n", stats->instance, t,
+            arrived, state.committed, state.planned,
+            online_method_name(method), value, latency);
+  }
+
+  if (result == 0) {
+    // No more arrivals: the last plan is carried out
+    memcpy(state.done + state.committed, state.plan,
+           sizeof(*state.done) * state.planned);
+    stats->objective = evaluate(instance, state.done, NULL);
+    online_latencies(latencies, stats->arrivals, &stats->mean,
+                     stats->percentiles, &stats->max);
+    // How much knowing the future would have saved
+    if (n <= DP_MAX_JOBS) {
+      solution_t *solution =
+          dp_solve(instance, DynamicProgramming, TIME_LIMIT, 1, state.best);
+      if (solution != NULL) {
+        stats->offline = solution->objective_value;
+        free(solution->values);
+        free(solution);
+      }
+    }
+  }
+
+  if (state.suffix != NULL) {
+    instance_orders_free(state.suffix);
+    free(state.suffix->processing_times);
+    free(state.suffix->release_dates);
+  }
+  // Frees the suffix too
+  if (state.sim.instances != NULL)
+    vector_free(state.sim.instances);
+  else
+    free(state.suffix);
+  free(times);
+  free(arrivals);
+  free(state.done);
+  free(state.plan);
+  free(state.best);
+  free(state.candidate);
+  free(state.c_hs);
+  return result;
+}
+
+void online_commit(online_state_t *state, long long t) {
+  const instance_t *instance = state->instance;
+  // The planned jobs starting before `t` are running or done
+  long long time = state->free_at;
+  int started = 0;
+  for (; started < state->planned; started++) {
+    int j = state->plan[started];
+    long long start =
+        time > instance->release_dates[j] ? time : instance->release_dates[j];
+    if (start >= t)
+      break;
+    state->done[state->committed++] = j;
+    time = start + instance->processing_times[j];
+  }
+  state->free_at = time;
+  state->planned -= started;
+  memmove(state->plan, state->plan + started,
+          sizeof(*state->plan) * state->planned);
+}
+
+int online_plan(online_state_t *state, const online_options_t *options,
+                long long t, int first, double deadline,
+                online_method_t *method, long long *value) {
+  const instance_t *instance = state->instance;
+  instance_t *suffix = state->suffix;
+  int m = state->planned;
+  int *best = state->best;
+  int *candidate = state->candidate;
+
+  // Nothing starts before the machine is free, nor before now
+  long long begin = state->free_at > t ? state->free_at : t;
+  instance_orders_free(suffix);
+  for (size_t h = 0; h < m; h++) {
+    int j = state->plan[h];
+    suffix->processing_times[h] = instance->processing_times[j];
+    suffix->release_dates[h] = instance->release_dates[j] > begin
+                                   ? instance->release_dates[j]
+                                   : begin;
+    best[h] = h;
+  }
+  // Warm start: the previous plan, every new job at its cheapest place
+  // among the jobs placed before it
+  for (size_t from = first; from < m; from++) {
+    suffix->number_of_jobs = from + 1;
+    online_insert(state, from, best);
+  }
+  suffix->number_of_jobs = m;
+  *method = OnlineWarm;
+  *value = evaluate(suffix, best, NULL);
+
+  // Simple orders, then insertion moves while the budget lasts
+  const orders_t *orders = instance_orders(suffix);
+  if (orders == NULL)
+    return -1;
+  const int *candidates[4] = {best, orders->by_release, orders->by_processing,
+                              orders->by_completion};
+  for (size_t c = 0; c < 4; c++) {
+    memcpy(candidate, candidates[c], sizeof(*candidate) * m);
+    if (dominance_repair(suffix, candidate) != 0)
+      return -1;
+    long long candidate_value = evaluate(suffix, candidate, NULL);
+    if (candidate_value < *value) {
+      memcpy(best, candidate, sizeof(*best) * m);
+      *value = candidate_value;
+      *method = OnlineHeuristic;
+    }
+  }
+  long long searched = online_search(state, best, *value, deadline);
+  if (searched < *value) {
+    *value = searched;
+    *method = OnlineHeuristic;
+  }
+
+  // Exact or model only with the time left
+  measure_t now;
+  measure_now(&now);
+  double left = deadline - now.wall;
+  long long found = -1;
+  online_method_t found_method = OnlineExact;
+  if (m >= 2 && m <= options->exact && left > 0) {
+    solution_t *solution =
+        dp_solve(suffix, DynamicProgramming, left, 1, candidate);
+    if (solution != NULL) {
+      found = solution->objective_value;
+      free(solution->values);
+      free(solution);
+    }
+  } else if (options->solver >= 0 && m >= 2 && m <= ONLINE_MODEL_JOBS &&
+             left >= ONLINE_MODEL_MIN) {
+    found_method = OnlineModel;
+    if (online_model(state, options->solver, left, *value, candidate) == 0)
+      found = evaluate(suffix, candidate, NULL);
+  }
+  if (found >= 0 && found < *value) {
+    memcpy(best, candidate, sizeof(*best) * m);
+    *value = found;
+    *method = found_method;
+  }
+
+  // Back to the jobs of the instance
+  memcpy(candidate, state->plan, sizeof(*candidate) * m);
+  for (size_t h = 0; h < m; h++) {
+    state->plan[h] = candidate[best[h]];
+  }
+  return 0;
+}
+
+void online_insert(online_state_t *state, int from, int *sequence) {
+  instance_t *suffix = state->suffix;
+  evaluate(suffix, sequence, state->c_hs);
+  long long best_delta = 0;
+  int best_to = from;
+  for (size_t to = 0; to < from; to++) {
+    long long delta =
+        evaluate_insert_delta(suffix, sequence, state->c_hs, from, to);
+    if (delta < best_delta) {
+      best_delta = delta;
+      best_to = to;
+    }
+  }
+  online_move(sequence, from, best_to);
+}
+
+long long online_search(online_state_t *state, int *sequence, long long value,
+                        double deadline) {
+  instance_t *suffix = state->suffix;
+  int m = suffix->number_of_jobs;
+  // First improving move, until none is left
+  int improved = 1;
+  evaluate(suffix, sequence, state->c_hs);
+  while (improved) {
+    improved = 0;
+    for (size_t from = 0; from < m && !improved; from++) {
+      measure_t now;
+      measure_now(&now);
+      if (now.wall >= deadline)
+        return value;
+      for (size_t to = 0; to < m; to++) {
+        if (to == from)
+          continue;
+        long long delta =
+            evaluate_insert_delta(suffix, sequence, state->c_hs, from, to);
+        if (delta < 0) {
+          online_move(sequence, from, to);
+          value = evaluate(suffix, sequence, state->c_hs);
+          improved = 1;
+          break;
+        }
+      }
+    }
+  }
+  return value;
+}
+
+int online_model(online_state_t *state, solver_t solver, double limit,
+                 long long value, int *sequence) {
+  int result = 0;
+  simulation_t *sim = &state->sim;
+  const backend_t *backend = sim->backend;
+  instance_t *suffix = state->suffix;
+  int solution_count = 0;
+  // The start is the best schedule so far, the model only looks for better
+  if ((result = model_init(sim, 0, solver, NULL)) != 0 ||
+      (result = model_set_start(sim, suffix, solver, sequence)) != 0 ||
+      (result = backend->set_dbl_param(suffix->model, PARAM_CUTOFF,
+                                       value - 0.5)) != 0 ||
+      (result = backend->set_dbl_param(suffix->model, PARAM_TIME_LIMIT,
+                                       limit)) != 0 ||
+      (result = backend->optimize(suffix->model)) != 0 ||
+      (result = backend->get_int_attr(suffix->model, ATTR_SOL_COUNT,
+                                      &solution_count)) != 0)
+    log_error(sim, result, "online_model");
+  if (result == 0 && solution_count > 0)
+    result = model_sequence(sim, suffix, solver, sequence);
+  else if (result == 0)
+    result = 1;
+  if (suffix->model != NULL)
+    backend->model_free(suffix->model);
+  suffix->model = NULL;
+  return result;
+}
+
+void online_move(int *sequence, int from, int to) {
+  int job = sequence[from];
+  if (from < to)
+    memmove(sequence + from, sequence + from + 1,
+            sizeof(*sequence) * (to - from));
+  else
+    memmove(sequence + to + 1, sequence + to,
+            sizeof(*sequence) * (from - to));
+  sequence[to] = job;
+}
+
+void online_latencies(double *latencies, int length, double *mean,
+                      double *percentiles, double *max) {
+  *mean = 0;
+  *max = 0;
+  for (size_t p = 0; p < ONLINE_PERCENTILES; p++) {
+    percentiles[p] = 0;
+  }
+  if (length == 0)
+    return;
+  // Sorted in place, the order of the arrivals is in the arrivals file
+  qsort(latencies, length, sizeof(*latencies), online_compare);
+  for (size_t k = 0; k < length; k++) {
+    *mean += latencies[k] / length;
+  }
+  // Nearest rank
+  for (size_t p = 0; p < ONLINE_PERCENTILES; p++) {
+    int rank = ceil(PERCENTILES[p] * length);
+    percentiles[p] = latencies[rank > 0 ? rank - 1 : 0];
+  }
+  *max = latencies[length - 1];
+}
+
+int online_compare(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
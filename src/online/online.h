@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../utils/entities.h"
+#include <stdio.h>
+
+#define ONLINE_OUTPUT "output/online"
+#define ONLINE_BUDGET 10.0     // Milliseconds of every re-optimization
+#define ONLINE_EXACT 16        // Default suffixes solved exactly: the layers
+                               // of the dynamic program fit the budget
+#define ONLINE_MODEL_MIN 0.005 // Seconds left for a model to be worth building
+#define ONLINE_MODEL_JOBS 100  // Larger suffixes are never given to a model
+#define ONLINE_PERCENTILES 3   // p50, p90 and p99 of the latencies
+
+// How the plan of an arrival was found
+typedef enum {
+  OnlineWarm,      // Previous plan with the new jobs inserted
+  OnlineHeuristic, // Simple orders and insertion moves
+  OnlineExact,     // Dynamic program (run/dp.h)
+  OnlineModel      // Model started from the best of the above
+} online_method_t;
+#define NUMBER_OF_ONLINE_METHODS 4
+
+typedef struct {
+  const char *filename; // Instances replayed as arrivals
+  double budget;        // Seconds of every re-optimization
+  int lead;             // Jobs are known `lead` time units before r_j
+  int exact;            // Suffixes of at most `exact` jobs are solved by
+                        // dynamic programming, 0: never
+  int solver;           // Formulation of the larger suffixes, -1: none
+} online_options_t;
+
+typedef struct {
+  int instance;
+  int number_of_jobs;
+  int arrivals;
+  long long objective;
+  long long offline; // Optimum knowing every job from the start, -1: unknown
+  double mean;       // Latencies, milliseconds
+  double percentiles[ONLINE_PERCENTILES];
+  double max;
+  int methods[NUMBER_OF_ONLINE_METHODS];
+} online_stats_t;
+
+// Replay every instance of `filename` as jobs arriving over time: job j is
+// known at max(0, r_j - lead). At every arrival the jobs the machine has
+// started are committed, the new jobs are inserted at their cheapest place
+// of the previous plan and only the uncommitted suffix is re-optimized
+// within `budget`: the simple orders and insertion moves first, then the
+// dynamic program or the model from the best of them while time is left.
+// Every arrival goes to output/online-arrivals.csv, the sum C_j and the
+// latency percentiles of every instance to output/online.csv
+int online(const online_options_t *options);
+// Replay instance `i` of `sim`, every arrival as a line of `fp` and its
+// latency in `latencies` (one per arrival at most)
+int online_replay(simulation_t *sim, size_t i, const online_options_t *options,
+                  FILE *fp, double *latencies, online_stats_t *stats);
+// Name of `method` ("warm", "heuristic", "exact", "model")
+const char *online_method_name(online_method_t method);
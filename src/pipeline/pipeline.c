@@ -0,0 +1,287 @@
+#include "pipeline.h"
+#include "../generate/generate.h"
+#include "../run/backend/backend.h"
+#include "../run/block.h"
+#include "../run/cache.h"
+#include "../run/dp.h"
+#include "../run/model/model.h"
+#include "../run/run.h"
+#include "../utils/queue.h"
+#include "../utils/results.h"
+#include "../utils/utils.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Instance between the generator and the workers
+typedef struct {
+  instance_t *instance;
+  int number; // Number of the instance (starting from 1)
+} pipeline_item_t;
+
+typedef struct {
+  queue_t *queue;
+  simulation_t sim; // Own backend environment, the instance being solved
+  double time_limit;
+  int threads;                  // Backend threads of every model
+  pthread_mutex_t *output_lock; // Guards `sol_fp` and `error_fp`
+  FILE *sol_fp;
+  FILE *error_fp;
+  results_t *results; // Own appender of the store
+  int solved;
+} worker_t;
+
+void *pipeline_worker(void *data);
+void pipeline_solve(worker_t *worker, int number);
+void pipeline_instance_free(instance_t *instance);
+void pipeline_item_free(void *item);
+
+int pipeline(const pipeline_options_t *options) {
+  int result = 0;
+  int workers = options->workers > 0 ? options->workers : 1;
+  if ((result = create_folder("output")) != 0) {
+    perror("Could not create folder output");
+    return result;
+  }
+  FILE *seeds_fp = fopen(options->seeds, "w");
+  FILE *sol_fp = fopen("output/solution.csv", "w");
+  FILE *error_fp = fopen("output/error.csv", "w");
+  if (seeds_fp == NULL || sol_fp == NULL || error_fp == NULL) {
+    perror("Could not open the pipeline outputs");
+    return -1;
+  }
+  fprintf(seeds_fp, "Instance,Seed,Jobs,ProcessingTime,ReleaseDate\n");
+  fprintf(sol_fp, "Solver,Instance,Status,Runtime,Solution,Heuristic\n");
+  fprintf(error_fp, "Solver,Instance,Function\n");
+
+  vector_t *instances = vector_init();
+  if (instances == NULL)
+    return -1;
+  simulation_t *sim = environment_init(instances);
+  if (sim == NULL)
+    return -1;
+
+  queue_t queue;
+  pthread_mutex_t output_lock;
+  worker_t *pool_workers = malloc(sizeof(*pool_workers) * workers);
+  pthread_t *threads = malloc(sizeof(*threads) * workers);
+  if (pool_workers == NULL || threads == NULL) {
+    perror("Could not allocate memory for workers");
+    return -1;
+  }
+  if (queue_init(&queue, options->queue > 0 ? options->queue : 1,
+                 sizeof(pipeline_item_t)) != 0 ||
+      pthread_mutex_init(&output_lock, NULL) != 0)
+    return -1;
+
+  // Concurrent models share the processors
+  int processors = blocks_workers();
+  int started = 0;
+  for (size_t w = 0; w < workers; w++) {
+    worker_t *worker = &pool_workers[w];
+    instance_t *none = NULL;
+    worker->queue = &queue;
+    worker->sim = *sim;
+    worker->time_limit = options->time_limit;
+    worker->threads =
+        workers > 1 ? (processors > workers ? processors / workers : 1) : 0;
+    worker->output_lock = &output_lock;
+    worker->sol_fp = sol_fp;
+    worker->error_fp = error_fp;
+    worker->solved = 0;
+    worker->sim.instances = vector_init();
+    worker->results = results_open(RESULTS_STORE);
+    if (worker->sim.instances == NULL || worker->results == NULL ||
+        vector_add(worker->sim.instances, (void **)&none) != 0 ||
+        simulation_worker_init(&worker->sim) != 0)
+      break;
+    if (pthread_create(&threads[w], NULL, pipeline_worker, worker) != 0) {
+      simulation_worker_free(&worker->sim);
+      break;
+    }
+    started += 1;
+  }
+  if (started == 0) {
+    fprintf(stderr, "Could not start the pipeline workers\n");
+    result = -1;
+  }
+
+  // Generated in the order of `generate`, every instance from its own seed
+  int values = ARRAY_SIZE + 1; // Upper limits of every parameter
+  long k = 0;
+  long total = (long)options->instances * values * values * values;
+  for (; k < total && result == 0; k++) {
+    long class = k / options->instances;
+    int jobs_ul = NUMBER_OF_JOBS_UL[class / (values * values)];
+    int processing_ul = PROCESSING_TIMES_UL[class / values % values];
+    int release_ul = RELEASE_DATES_UL[class % values];
+    long seed = generate_seed(options->seed, k);
+    instance_t *instance =
+        generate_instance(seed, jobs_ul, processing_ul, release_ul);
+    if (instance == NULL) {
+      result = -1;
+      break;
+    }
+    fprintf(seeds_fp, "%ld,%ld,%d,%d,%d\n", k + 1, seed, jobs_ul,
+            processing_ul, release_ul);
+    pipeline_item_t item = {.instance = instance, .number = k + 1};
+    queue_push(&queue, &item);
+  }
+  queue_close(&queue);
+
+  int solved = 0;
+  for (size_t w = 0; w < started; w++) {
+    pthread_join(threads[w], NULL);
+    simulation_worker_free(&pool_workers[w].sim);
+    solved += pool_workers[w].solved;
+  }
+  // The worker that failed to start is set up too
+  for (size_t w = 0; w <= started && w < workers; w++) {
+    if (pool_workers[w].sim.instances != NULL)
+      vector_free(pool_workers[w].sim.instances);
+    if (pool_workers[w].results != NULL &&
+        results_close(pool_workers[w].results) != 0)
+      result = -1;
+  }
+  printf("Generated %ld instances, solved %d (seeds in %s)\n", k, solved,
+         options->seeds);
+
+  queue_free(&queue, pipeline_item_free);
+  pthread_mutex_destroy(&output_lock);
+  free(pool_workers);
+  free(threads);
+  fclose(seeds_fp);
+  fclose(sol_fp);
+  fclose(error_fp);
+  if (simulation_free(sim) != 0)
+    result = -1;
+  return result;
+}
+
+int pipeline_regenerate(const char *seeds, int number, FILE *fp) {
+  FILE *seeds_fp = fopen(seeds, "r");
+  if (seeds_fp == NULL) {
+    perror_formatted("Could not open %s", seeds);
+    return -1;
+  }
+  // Skipping first line
+  fscanf(seeds_fp, "%*[^\n]\n");
+  int instance_number = 0, jobs_ul = 0, processing_ul = 0, release_ul = 0;
+  long seed = 0;
+  int found = 0;
+  while (!found && fscanf(seeds_fp, "%d,%ld,%d,%d,%d\n", &instance_number,
+                          &seed, &jobs_ul, &processing_ul, &release_ul) == 5) {
+    found = instance_number == number;
+  }
+  fclose(seeds_fp);
+  if (!found) {
+    fprintf(stderr, "No instance %d in %s\n", number, seeds);
+    return -1;
+  }
+
+  instance_t *instance =
+      generate_instance(seed, jobs_ul, processing_ul, release_ul);
+  if (instance == NULL)
+    return -1;
+  fprintf(fp, "Instance,ProcessingTime,ReleaseDate\n");
+  for (size_t j = 0; j < instance->number_of_jobs; j++) {
+    fprintf(fp, "%d,%d,%d\n", number, instance->processing_times[j],
+            instance->release_dates[j]);
+  }
+  pipeline_instance_free(instance);
+  return 0;
+}
+
+void *pipeline_worker(void *data) {
+  worker_t *worker = data;
+  pipeline_item_t item;
+  while (queue_pop(worker->queue, &item)) {
+    worker->sim.instances->values[0] = item.instance;
+    pipeline_solve(worker, item.number);
+    worker->sim.instances->values[0] = NULL;
+    pipeline_instance_free(item.instance);
+    worker->solved += 1;
+  }
+  return NULL;
+}
+
+void pipeline_solve(worker_t *worker, int number) {
+  simulation_t *sim = &worker->sim;
+  const backend_t *backend = sim->backend;
+  instance_t *instance = sim->instances->values[0];
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    int result = 0;
+    int heuristic_value = -1;
+    solution_t *solution = NULL;
+    if (solver == DynamicProgramming) {
+      if (instance->number_of_jobs > DP_MAX_JOBS)
+        continue;
+      int *sequence = malloc(sizeof(*sequence) * instance->number_of_jobs);
+      if (sequence != NULL)
+        solution = dp_solve(instance, solver, worker->time_limit, 1, sequence);
+      free(sequence);
+    } else if ((result = model_init(sim, 0, solver, &heuristic_value)) == 0 &&
+        (result = backend->set_dbl_param(instance->model, PARAM_TIME_LIMIT,
+                                         worker->time_limit)) == 0 &&
+        (worker->threads == 0 ||
+         (result = backend->set_int_param(instance->model, PARAM_THREADS,
+                                          worker->threads)) == 0))
+      solution = model_optimize(sim, 0, solver);
+
+    pthread_mutex_lock(worker->output_lock);
+    if (solution == NULL) {
+      fprintf(worker->error_fp, "%d,%d,%s\n", solver, number,
+              solver == DynamicProgramming ? "Dynamic"
+              : result != 0                ? "Init"
+                                           : "Optimize");
+    } else {
+      solution->heuristic_value = heuristic_value;
+      fprintf(worker->sol_fp, "%d,%d,%d,%.2f,%.2f,%.2f\n", solver, number,
+              solution->status, solution->runtime, solution->objective_value,
+              solution->heuristic_value);
+    }
+    pthread_mutex_unlock(worker->output_lock);
+
+    if (solution != NULL) {
+      long variables = -1, nonzeros = -1;
+      if (solver != DynamicProgramming)
+        model_counts(instance, solver, &variables, &nonzeros);
+      result_t record = {.solver = solver,
+                         .instance = number,
+                         .status = solution->status,
+                         .runtime = solution->runtime,
+                         .objective_value = solution->objective_value,
+                         .bound = solution->bound,
+                         .gap = solution->gap,
+                         .heuristic_value = solution->heuristic_value,
+                         .variables = variables,
+                         .nonzeros = nonzeros,
+                         .memory = solution->memory,
+                         .key = cache_hash(instance)};
+      results_features(instance, &record);
+      if (results_append(worker->results, &record) != 0 ||
+          results_flush(worker->results) != 0) {
+        pthread_mutex_lock(worker->output_lock);
+        fprintf(worker->error_fp, "%d,%d,Results\n", solver, number);
+        pthread_mutex_unlock(worker->output_lock);
+      }
+      free(solution->values);
+      free(solution);
+    }
+    if (instance->model != NULL &&
+        (result = backend->model_free(instance->model)) != 0)
+      log_error(sim, result, "model_free");
+    instance->model = NULL;
+  }
+}
+
+void pipeline_item_free(void *item) {
+  pipeline_instance_free(((pipeline_item_t *)item)->instance);
+}
+
+void pipeline_instance_free(instance_t *instance) {
+  instance_orders_free(instance);
+  free(instance->processing_times);
+  free(instance->release_dates);
+  free(instance);
+}
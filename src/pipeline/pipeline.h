@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../utils/entities.h"
+#include <stdio.h>
+
+#define PIPELINE_SEEDS "output/seeds.csv"
+#define PIPELINE_QUEUE 2            // Instances generated ahead of every worker
+#define PIPELINE_TIME_LIMIT 60.0 * 5 // Seconds of every solve, as `run`
+
+typedef struct {
+  long seed;         // Base seed of the sweep
+  int instances;     // Instances of every class of generate.h
+  int workers;       // Threads solving the instances
+  int queue;         // Instances waiting for a worker at most
+  double time_limit; // Seconds of every solve
+  const char *seeds; // Seed and class of every instance
+} pipeline_options_t;
+
+// Generate the classes of generate.h into a bounded queue that the workers
+// solve with every formulation as soon as an instance is ready: only the
+// queued instances are in memory and only their seeds are saved. The
+// solutions go to output/solution.csv and the results store as with `run`
+int pipeline(const pipeline_options_t *options);
+// Write instance `number` of `seeds` in the format of instances.csv
+int pipeline_regenerate(const char *seeds, int number, FILE *fp);
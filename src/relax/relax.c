@@ -0,0 +1,283 @@
+#include "relax.h"
+#include "../generate/generate.h"
+#include "../run/backend/backend.h"
+#include "../run/model/model.h"
+#include "../run/run.h"
+#include "../stats/stats.h"
+#include "../utils/csv.h"
+#include "../utils/utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RELAX_TOLERANCE 1e-6 // Relative difference of bounds counted as equal
+
+typedef struct {
+  solver_t solver;
+  int jobs_class;
+  int p_class;
+  int r_class;
+  int count;
+  int solved;       // LPs solved to optimality, the means are over them
+  double ratio;     // Sum of bound over the best bound of the instance
+  double solve_time;
+  double max_solve_time;
+  double iterations; // Simplex and barrier iterations
+  double memory;
+  double max_memory;
+  int best; // Instances where no formulation has a better bound
+} relax_group_t;
+
+int relax_solve(simulation_t *sim, size_t i, solver_t solver,
+                const relax_options_t *options, relax_stats_t *stats);
+int relax_write(const relax_stats_t *records, int length, int instances);
+relax_group_t *relax_group(relax_group_t *groups, int *length,
+                           const relax_stats_t *stats);
+
+int relax(const relax_options_t *options) {
+  int result = 0;
+
+  vector_t *instances = vector_init();
+  if (instances == NULL)
+    return -1;
+  if ((result = load_csv(options->filename, instances)) != 0)
+    return result;
+  if ((result = create_folder("output")) != 0) {
+    perror("Could not create folder output");
+    return result;
+  }
+
+  simulation_t *sim = environment_init(instances);
+  if (sim == NULL)
+    return -1;
+
+  int length = 0;
+  relax_stats_t *records =
+      malloc(sizeof(*records) * sim->instances->length * NUMBER_OF_SOLVERS);
+  if (records == NULL) {
+    perror("Could not allocate memory for relaxation statistics");
+    return -1;
+  }
+  // The heuristic variants only add a start, which the LP does not use
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    if (solver_formulation(solver) != solver || solver == DynamicProgramming)
+      continue;
+    printf("Relaxing %s models\n", solver_name(solver));
+    for (size_t i = 0; i < sim->instances->length; i++) {
+      if (relax_solve(sim, i, solver, options, &records[length]) == 0)
+        length += 1;
+    }
+  }
+
+  result = relax_write(records, length, sim->instances->length);
+
+  free(records);
+  records = NULL;
+  if (simulation_free(sim) != 0)
+    return -1;
+  return result;
+}
+
+int relax_method(const char *name) {
+  if (!strcmp(name, "auto"))
+    return -1;
+  if (!strcmp(name, "dual"))
+    return METHOD_DUAL;
+  if (!strcmp(name, "barrier"))
+    return METHOD_BARRIER;
+  if (!strcmp(name, "concurrent"))
+    return METHOD_CONCURRENT;
+  return -2;
+}
+
+int relax_solve(simulation_t *sim, size_t i, solver_t solver,
+                const relax_options_t *options, relax_stats_t *stats) {
+  int result = 0;
+  instance_t *instance = sim->instances->values[i];
+  const backend_t *backend = sim->backend;
+  measure_t start, end;
+
+  memset(stats, 0, sizeof(*stats));
+  stats->solver = solver;
+  stats->instance = i + 1;
+  stats->number_of_jobs = instance->number_of_jobs;
+  stats->bound = -1;
+  for (size_t j = 0; j < instance->number_of_jobs; j++) {
+    if (instance->processing_times[j] > stats->max_p_j)
+      stats->max_p_j = instance->processing_times[j];
+    if (instance->release_dates[j] > stats->max_r_j)
+      stats->max_r_j = instance->release_dates[j];
+  }
+
+  // The dominance fixings are kept: the bound of the model the runs solve
+  measure_now(&start);
+  void *relaxed = NULL;
+  if ((result = model_init(sim, i, solver, NULL)) != 0) {
+    fprintf(stderr, "Could not build %s model of instance %ld\n",
+            solver_name(solver), i + 1);
+  } else if ((result = backend->relax(instance->model, &relaxed)) != 0) {
+    log_error(sim, result, "relax");
+  }
+  // Only the LP is kept in memory while it is solved
+  if (instance->model != NULL)
+    backend->model_free(instance->model);
+  instance->model = NULL;
+  measure_now(&end);
+  stats->build_time = end.wall - start.wall;
+  if (result != 0)
+    return result;
+
+  if ((result = backend->set_dbl_param(relaxed, PARAM_TIME_LIMIT,
+                                       options->time_limit)) != 0)
+    log_error(sim, result, "set_dbl_param(\"TimeLimit\")");
+  else if ((result = backend->set_int_param(relaxed, PARAM_METHOD,
+                                            options->method)) != 0)
+    log_error(sim, result, "set_int_param(\"Method\")");
+  // The bound needs no basis
+  else if (options->method == METHOD_BARRIER &&
+           (result = backend->set_int_param(relaxed, PARAM_CROSSOVER, 0)) !=
+               0)
+    log_error(sim, result, "set_int_param(\"Crossover\")");
+  else if ((result = backend->optimize(relaxed)) != 0)
+    log_error(sim, result, "optimize");
+
+  if (result == 0 &&
+      (result = backend->get_int_attr(relaxed, ATTR_STATUS, &stats->status)) !=
+          0)
+    log_error(sim, result, "get_int_attr(\"Status\")");
+  if (result == 0 && stats->status == STATUS_OPTIMAL &&
+      (result = backend->get_dbl_attr(relaxed, ATTR_OBJ_VAL, &stats->bound)) !=
+          0)
+    log_error(sim, result, "get_dbl_attr(\"ObjVal\")");
+  if (result == 0 &&
+      (result = backend->get_dbl_attr(relaxed, ATTR_RUNTIME,
+                                      &stats->solve_time)) != 0)
+    log_error(sim, result, "get_dbl_attr(\"Runtime\")");
+  if (result == 0 &&
+      (result = backend->get_dbl_attr(relaxed, ATTR_ITER_COUNT,
+                                      &stats->iterations)) != 0)
+    log_error(sim, result, "get_dbl_attr(\"IterCount\")");
+  if (result == 0 &&
+      (result = backend->get_int_attr(relaxed, ATTR_BAR_ITER_COUNT,
+                                      &stats->barrier_iterations)) != 0)
+    log_error(sim, result, "get_int_attr(\"BarIterCount\")");
+  if (result == 0 &&
+      (result = backend->get_dbl_attr(relaxed, ATTR_MAX_MEM_USED,
+                                      &stats->memory)) != 0)
+    log_error(sim, result, "get_dbl_attr(\"MaxMemUsed\")");
+
+  int free_result = 0;
+  if ((free_result = backend->model_free(relaxed)) != 0)
+    log_error(sim, free_result, "model_free");
+  return result;
+}
+
+int relax_write(const relax_stats_t *records, int length, int instances) {
+  char *filename = RELAX_OUTPUT ".csv";
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL) {
+    perror("Could not open " RELAX_OUTPUT ".csv");
+    return -1;
+  }
+  fprintf(fp, "Solver,Instance,Jobs,MaxProcessingTime,MaxReleaseDate,Status,"
+              "Bound,Iterations,BarrierIterations,BuildTime,SolveTime,"
+              "MemoryGB\n");
+  // Best bound of every instance over the formulations
+  double *best = malloc(sizeof(*best) * (instances > 0 ? instances : 1));
+  relax_group_t *groups = malloc(sizeof(*groups) * (length > 0 ? length : 1));
+  if (best == NULL || groups == NULL) {
+    perror("Could not allocate memory for relaxation groups");
+    free(best);
+    free(groups);
+    fclose(fp);
+    return -1;
+  }
+  for (size_t i = 0; i < instances; i++) {
+    best[i] = -1;
+  }
+  for (size_t k = 0; k < length; k++) {
+    const relax_stats_t *s = &records[k];
+    fprintf(fp, "%d,%d,%d,%d,%d,%d,%.6f,%.0f,%d,%.6f,%.6f,%.6f\n", s->solver,
+            s->instance, s->number_of_jobs, s->max_p_j, s->max_r_j, s->status,
+            s->bound, s->iterations, s->barrier_iterations, s->build_time,
+            s->solve_time, s->memory);
+    if (s->bound > best[s->instance - 1])
+      best[s->instance - 1] = s->bound;
+  }
+  fclose(fp);
+  printf("Relaxation statistics saved in %s\n", filename);
+
+  int groups_length = 0;
+  for (size_t k = 0; k < length; k++) {
+    const relax_stats_t *s = &records[k];
+    relax_group_t *group = relax_group(groups, &groups_length, s);
+    group->count += 1;
+    if (s->bound < 0)
+      continue;
+    double top = best[s->instance - 1];
+    group->solved += 1;
+    group->ratio += top > 0 ? s->bound / top : 1;
+    group->solve_time += s->solve_time;
+    if (s->solve_time > group->max_solve_time)
+      group->max_solve_time = s->solve_time;
+    group->iterations += s->iterations + s->barrier_iterations;
+    group->memory += s->memory;
+    if (s->memory > group->max_memory)
+      group->max_memory = s->memory;
+    if (s->bound >= top - RELAX_TOLERANCE * fabs(top))
+      group->best += 1;
+  }
+  free(best);
+
+  filename = RELAX_OUTPUT "-groups.csv";
+  if ((fp = fopen(filename, "w")) == NULL) {
+    perror("Could not open " RELAX_OUTPUT "-groups.csv");
+    free(groups);
+    return -1;
+  }
+  // Bound ratio per second: how much of the best bound a second buys
+  fprintf(fp, "Solver,JobsClass,ProcessingTimeClass,ReleaseDateClass,Count,"
+              "Solved,MeanBoundRatio,MeanSolveTime,MaxSolveTime,"
+              "MeanIterations,MeanMemoryGB,MaxMemoryGB,Best,"
+              "BoundRatioPerSecond\n");
+  for (size_t g = 0; g < groups_length; g++) {
+    const relax_group_t *group = &groups[g];
+    int solved = group->solved > 0 ? group->solved : 1;
+    double ratio = group->ratio / solved;
+    double solve_time = group->solve_time / solved;
+    fprintf(fp, "%d,%d,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.1f,%.6f,%.6f,%d,",
+            group->solver, group->jobs_class, group->p_class, group->r_class,
+            group->count, group->solved, ratio, solve_time,
+            group->max_solve_time, group->iterations / solved,
+            group->memory / solved, group->max_memory, group->best);
+    if (group->solved > 0 && solve_time > 0)
+      fprintf(fp, "%.6f", ratio / solve_time);
+    fprintf(fp, "\n");
+  }
+  fclose(fp);
+  printf("Relaxation statistics by class saved in %s\n", filename);
+
+  free(groups);
+  return 0;
+}
+
+relax_group_t *relax_group(relax_group_t *groups, int *length,
+                           const relax_stats_t *stats) {
+  int jobs_class = stats_class(stats->number_of_jobs, NUMBER_OF_JOBS_UL);
+  int p_class = stats_class(stats->max_p_j, PROCESSING_TIMES_UL);
+  int r_class = stats_class(stats->max_r_j, RELEASE_DATES_UL);
+  for (size_t g = 0; g < *length; g++) {
+    if (groups[g].solver == stats->solver &&
+        groups[g].jobs_class == jobs_class && groups[g].p_class == p_class &&
+        groups[g].r_class == r_class)
+      return &groups[g];
+  }
+  relax_group_t *group = &groups[(*length)++];
+  memset(group, 0, sizeof(*group));
+  group->solver = stats->solver;
+  group->jobs_class = jobs_class;
+  group->p_class = p_class;
+  group->r_class = r_class;
+  return group;
+}
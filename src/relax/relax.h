@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define RELAX_OUTPUT "output/relax"
+#define RELAX_TIME_LIMIT 300.0 // Seconds of every LP
+
+typedef struct {
+  const char *filename; // Instances to relax
+  int method;           // METHOD_* of run/backend/backend.h, -1: automatic
+  double time_limit;    // Seconds of every LP
+} relax_options_t;
+
+typedef struct {
+  solver_t solver;
+  int instance;
+  int number_of_jobs;
+  int max_p_j;
+  int max_r_j;
+  int status;             // Backend status of the LP
+  double bound;           // LP optimum, -1 when not solved to optimality
+  double iterations;      // Simplex iterations
+  int barrier_iterations;
+  double build_time;      // Seconds building and relaxing the model
+  double solve_time;      // Seconds of the LP
+  double memory;          // Peak GB of the LP
+} relax_stats_t;
+
+// Build every formulation of every instance in `filename`, drop the
+// integrality and solve only the LP with `method`: the root bound of every
+// model, its iterations, time and memory go to output/relax.csv, the mean
+// bound (over the best of the instance), time and memory of every
+// formulation and (n, p, r) class to output/relax-groups.csv
+int relax(const relax_options_t *options);
+// Method named `name` ("auto", "dual", "barrier", "concurrent"), -2 if none
+int relax_method(const char *name);
@@ -0,0 +1,398 @@
+#include "report.h"
+#include "../run/backend/backend.h"
+#include "../run/cache.h"
+#include "../utils/csv.h"
+#include "../utils/results.h"
+#include "../utils/utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPORT_BUCKETS (REPORT_DECADES * REPORT_BUCKETS_PER_DECADE)
+#define REPORT_TAUS (REPORT_TAU_DECADES * REPORT_TAU_PER_DECADE + 1)
+#define NOT_RUN -1.0
+
+typedef struct {
+  long records;
+  long solved;
+  long gaps; // Records with a gap
+  double runtime_sum;
+  double runtime_max;
+  double gap_sum;
+  long histogram[REPORT_BUCKETS];
+} solver_report_t;
+
+typedef struct {
+  solver_report_t solvers[NUMBER_OF_SOLVERS];
+  int instances;          // Distinct instance keys seen
+  int instances_capacity; // Instances allocated in `best` and `keys`
+  // Fastest optimal runtime of every (instance, solver): NOT_RUN without
+  // records, INFINITY when never solved
+  double *best;
+  unsigned long long *keys; // Key of every instance of `best`
+  int *slots;               // Open addressing on the keys, -1: empty
+  int slots_capacity;
+} report_t;
+
+int report_block(const results_block_t *block, void *data);
+unsigned long long report_key(const results_block_t *block, size_t k);
+int report_instance(report_t *report, unsigned long long key);
+int report_rehash(report_t *report);
+int report_grow(report_t *report, int instance);
+void report_free(report_t *report);
+double report_quantile(const solver_report_t *solver, double q);
+int report_write(const report_t *report, const char *output);
+int report_profile(const report_t *report, const char *output);
+
+int report(const report_options_t *options) {
+  int result = 0;
+  for (size_t k = 0; k < options->imports_length; k++) {
+    if ((result = report_import(options->imports[k], options->instances,
+                                options->store)) != 0)
+      return result;
+  }
+
+  report_t report;
+  memset(&report, 0, sizeof(report));
+  measure_t start, end;
+  measure_now(&start);
+  if ((result = results_scan(options->store, report_block, &report)) != 0) {
+    report_free(&report);
+    return result;
+  }
+  measure_now(&end);
+
+  long records = 0;
+  for (solver_t s = 0; s < NUMBER_OF_SOLVERS; s++) {
+    records += report.solvers[s].records;
+  }
+  printf("Aggregated %ld records of %d instances in %.3fs\n", records,
+         report.instances, end.wall - start.wall);
+
+  if ((result = report_write(&report, options->output)) == 0)
+    result = report_profile(&report, options->output);
+  report_free(&report);
+  return result;
+}
+
+int report_block(const results_block_t *block, void *data) {
+  report_t *report = data;
+  double bucket_scale = REPORT_BUCKETS_PER_DECADE;
+  for (size_t k = 0; k < block->length; k++) {
+    int s = block->solver[k];
+    if (s < 0 || s >= NUMBER_OF_SOLVERS || block->instance[k] < 1)
+      continue;
+    int instance = report_instance(report, report_key(block, k));
+    if (instance < 0)
+      return -1;
+
+    solver_report_t *solver = &report->solvers[s];
+    double runtime = block->runtime[k];
+    solver->records += 1;
+    solver->runtime_sum += runtime;
+    if (runtime > solver->runtime_max)
+      solver->runtime_max = runtime;
+    int bucket = 0;
+    if (runtime > 0)
+      bucket = (log10(runtime) - REPORT_FIRST_DECADE) * bucket_scale;
+    if (bucket < 0)
+      bucket = 0;
+    if (bucket >= REPORT_BUCKETS)
+      bucket = REPORT_BUCKETS - 1;
+    solver->histogram[bucket] += 1;
+    if (block->gap[k] >= 0) {
+      solver->gaps += 1;
+      solver->gap_sum += block->gap[k];
+    }
+
+    double *best = &report->best[instance * NUMBER_OF_SOLVERS + s];
+    if (*best == NOT_RUN)
+      *best = INFINITY;
+    if (block->status[k] == STATUS_OPTIMAL) {
+      solver->solved += 1;
+      if (runtime < *best)
+        *best = runtime;
+    }
+  }
+  return 0;
+}
+
+unsigned long long report_key(const results_block_t *block, size_t k) {
+  if (block->key[k] != 0)
+    return block->key[k];
+  // Records of version 2 and older: the number and features of the instance
+  // only tell apart the instances of one campaign
+  int values[6] = {block->instance[k], block->number_of_jobs[k],
+                   block->min_p_j[k],  block->max_p_j[k],
+                   block->min_r_j[k],  block->max_r_j[k]};
+  unsigned long long key = 14695981039346656037ULL;
+  for (size_t v = 0; v < 6; v++) {
+    key = (key ^ (unsigned)values[v]) * 1099511628211ULL;
+  }
+  return key != 0 ? key : 1;
+}
+
+int report_instance(report_t *report, unsigned long long key) {
+  // At most half full
+  if (2 * (report->instances + 1) > report->slots_capacity &&
+      report_rehash(report) != 0)
+    return -1;
+  size_t slot = key % report->slots_capacity;
+  while (report->slots[slot] >= 0) {
+    if (report->keys[report->slots[slot]] == key)
+      return report->slots[slot];
+    slot = (slot + 1) % report->slots_capacity;
+  }
+  int instance = report->instances;
+  if (instance + 1 > report->instances_capacity &&
+      report_grow(report, instance + 1) != 0)
+    return -1;
+  report->keys[instance] = key;
+  report->slots[slot] = instance;
+  report->instances += 1;
+  return instance;
+}
+
+int report_rehash(report_t *report) {
+  int capacity = report->slots_capacity > 0 ? 2 * report->slots_capacity
+                                            : 2 * VECTOR_DEFAULT_SIZE;
+  int *slots = malloc(sizeof(*slots) * capacity);
+  if (slots == NULL) {
+    perror("Could not allocate memory for instance keys");
+    return -1;
+  }
+  for (size_t slot = 0; slot < capacity; slot++) {
+    slots[slot] = -1;
+  }
+  for (size_t i = 0; i < report->instances; i++) {
+    size_t slot = report->keys[i] % capacity;
+    while (slots[slot] >= 0)
+      slot = (slot + 1) % capacity;
+    slots[slot] = i;
+  }
+  free(report->slots);
+  report->slots = slots;
+  report->slots_capacity = capacity;
+  return 0;
+}
+
+int report_grow(report_t *report, int instance) {
+  int capacity = report->instances_capacity > 0 ? report->instances_capacity
+                                                : VECTOR_DEFAULT_SIZE;
+  while (capacity < instance)
+    capacity *= 2;
+  double *best =
+      realloc(report->best, sizeof(*best) * capacity * NUMBER_OF_SOLVERS);
+  if (best == NULL) {
+    perror("Could not allocate memory for best runtimes");
+    return -1;
+  }
+  report->best = best;
+  unsigned long long *keys = realloc(report->keys, sizeof(*keys) * capacity);
+  if (keys == NULL) {
+    perror("Could not allocate memory for instance keys");
+    return -1;
+  }
+  report->keys = keys;
+  for (size_t k = report->instances_capacity * NUMBER_OF_SOLVERS;
+       k < capacity * NUMBER_OF_SOLVERS; k++) {
+    best[k] = NOT_RUN;
+  }
+  report->instances_capacity = capacity;
+  return 0;
+}
+
+void report_free(report_t *report) {
+  free(report->best);
+  report->best = NULL;
+  free(report->keys);
+  report->keys = NULL;
+  free(report->slots);
+  report->slots = NULL;
+}
+
+double report_quantile(const solver_report_t *solver, double q) {
+  long target = ceil(q * solver->records);
+  long count = 0;
+  for (size_t b = 0; b < REPORT_BUCKETS; b++) {
+    count += solver->histogram[b];
+    if (count >= target && count > 0) {
+      // Upper edge of the bucket, never past the largest runtime
+      double edge = pow(10, (double)(b + 1) / REPORT_BUCKETS_PER_DECADE +
+                                REPORT_FIRST_DECADE);
+      return edge < solver->runtime_max ? edge : solver->runtime_max;
+    }
+  }
+  return solver->runtime_max;
+}
+
+int report_write(const report_t *report, const char *output) {
+  char *filename = formatted_string("%s.csv", output);
+  FILE *fp = filename != NULL ? fopen(filename, "w") : NULL;
+  if (fp == NULL) {
+    perror_formatted("Could not open %s.csv", output);
+    free(filename);
+    return -1;
+  }
+  fprintf(fp, "Solver,Records,Solved,SolveRate,MeanRuntime,MedianRuntime,"
+              "P90Runtime,P99Runtime,MaxRuntime,MeanGap\n");
+  printf("%-24s %9s %7s %9s %9s %9s %9s %8s\n", "Formulation", "Records",
+         "Solved", "Median", "P90", "P99", "Max", "Gap");
+  for (solver_t s = 0; s < NUMBER_OF_SOLVERS; s++) {
+    const solver_report_t *solver = &report->solvers[s];
+    if (solver->records == 0)
+      continue;
+    double solve_rate = (double)solver->solved / solver->records;
+    double mean_gap = solver->gaps > 0 ? solver->gap_sum / solver->gaps : -1;
+    double quantiles[3] = {report_quantile(solver, 0.5),
+                           report_quantile(solver, 0.9),
+                           report_quantile(solver, 0.99)};
+    fprintf(fp, "%d,%ld,%ld,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.6f\n", s,
+            solver->records, solver->solved, solve_rate,
+            solver->runtime_sum / solver->records, quantiles[0], quantiles[1],
+            quantiles[2], solver->runtime_max, mean_gap);
+    printf("%-24s %9ld %6.1f%% %9.2f %9.2f %9.2f %9.2f %7.2f%%\n",
+           solver_name(s), solver->records, solve_rate * 100, quantiles[0],
+           quantiles[1], quantiles[2], solver->runtime_max,
+           mean_gap >= 0 ? mean_gap * 100 : NAN);
+  }
+  fclose(fp);
+  printf("Report saved in %s\n", filename);
+  free(filename);
+  filename = NULL;
+  return 0;
+}
+
+int report_profile(const report_t *report, const char *output) {
+  // counts[s * REPORT_TAUS + k]: instances first within tau_k of the best
+  long *counts = malloc(sizeof(*counts) * NUMBER_OF_SOLVERS * REPORT_TAUS);
+  if (counts == NULL) {
+    perror("Could not allocate memory for performance profiles");
+    return -1;
+  }
+  memset(counts, 0, sizeof(*counts) * NUMBER_OF_SOLVERS * REPORT_TAUS);
+
+  long instances = 0;
+  for (size_t i = 0; i < report->instances; i++) {
+    const double *runtimes = &report->best[i * NUMBER_OF_SOLVERS];
+    double best = INFINITY;
+    int seen = 0;
+    for (solver_t s = 0; s < NUMBER_OF_SOLVERS; s++) {
+      if (runtimes[s] == NOT_RUN)
+        continue;
+      seen = 1;
+      if (runtimes[s] < best)
+        best = runtimes[s];
+    }
+    if (!seen)
+      continue;
+    instances += 1;
+    // Unsolved by every formulation: the instance only lowers the profiles
+    if (best == INFINITY)
+      continue;
+    best = fmax(best, REPORT_MIN_RUNTIME);
+    for (solver_t s = 0; s < NUMBER_OF_SOLVERS; s++) {
+      if (runtimes[s] == NOT_RUN || runtimes[s] == INFINITY)
+        continue;
+      double ratio = fmax(runtimes[s], REPORT_MIN_RUNTIME) / best;
+      int k = ceil(log10(ratio) * REPORT_TAU_PER_DECADE - 1e-9);
+      if (k < 0)
+        k = 0;
+      if (k < REPORT_TAUS)
+        counts[s * REPORT_TAUS + k] += 1;
+    }
+  }
+
+  char *filename = formatted_string("%s-profile.csv", output);
+  FILE *fp = filename != NULL ? fopen(filename, "w") : NULL;
+  if (fp == NULL) {
+    perror_formatted("Could not open %s-profile.csv", output);
+    free(filename);
+    free(counts);
+    return -1;
+  }
+  fprintf(fp, "Tau");
+  for (solver_t s = 0; s < NUMBER_OF_SOLVERS; s++) {
+    if (report->solvers[s].records > 0)
+      fprintf(fp, ",%d", s);
+  }
+  fprintf(fp, "\n");
+  long cumulative[NUMBER_OF_SOLVERS] = {0};
+  for (size_t k = 0; k < REPORT_TAUS; k++) {
+    fprintf(fp, "%.4f", pow(10, (double)k / REPORT_TAU_PER_DECADE));
+    for (solver_t s = 0; s < NUMBER_OF_SOLVERS; s++) {
+      if (report->solvers[s].records == 0)
+        continue;
+      cumulative[s] += counts[s * REPORT_TAUS + k];
+      fprintf(fp, ",%.6f",
+              instances > 0 ? (double)cumulative[s] / instances : 0);
+    }
+    fprintf(fp, "\n");
+  }
+  fclose(fp);
+  printf("Performance profiles saved in %s\n", filename);
+
+  free(filename);
+  filename = NULL;
+  free(counts);
+  counts = NULL;
+  return 0;
+}
+
+int report_import(const char *solutions, const char *instances_file,
+                  const char *store) {
+  int result = 0;
+  vector_t *instances = vector_init();
+  if (instances == NULL)
+    return -1;
+  if ((result = load_csv(instances_file, instances)) != 0)
+    return result;
+
+  FILE *fp = fopen(solutions, "r");
+  if (fp == NULL) {
+    perror_formatted("Could not open %s", solutions);
+    vector_free(instances);
+    return -1;
+  }
+  results_t *results = results_open(store);
+  if (results == NULL) {
+    fclose(fp);
+    vector_free(instances);
+    return -1;
+  }
+
+  // Skipping first line
+  fscanf(fp, "%*[^\n]\n");
+  long rows = 0;
+  result_t record;
+  memset(&record, 0, sizeof(record));
+  // The model sizes and memory are not in solution.csv
+  record.variables = record.nonzeros = record.memory = -1;
+  int solver = 0;
+  while (fscanf(fp, "%d,%d,%d,%lf,%lf,%lf\n", &solver, &record.instance,
+                &record.status, &record.runtime, &record.objective_value,
+                &record.heuristic_value) == 6) {
+    record.solver = solver;
+    record.bound = record.status == STATUS_OPTIMAL ? record.objective_value : -1;
+    record.gap = record.status == STATUS_OPTIMAL ? 0 : -1;
+    if (record.instance >= 1 && record.instance <= instances->length) {
+      instance_t *instance = instances->values[record.instance - 1];
+      results_features(instance, &record);
+      record.key = cache_hash(instance);
+    } else {
+      record.number_of_jobs = record.min_p_j = record.max_p_j = 0;
+      record.min_r_j = record.max_r_j = 0;
+      record.key = 0;
+    }
+    if ((result = results_append(results, &record)) != 0)
+      break;
+    rows += 1;
+  }
+  fclose(fp);
+  if (results_close(results) != 0)
+    result = -1;
+  vector_free(instances);
+  printf("Imported %ld rows of %s in %s\n", rows, solutions, store);
+  return result;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define REPORT_OUTPUT "output/report"
+#define REPORT_INSTANCES "results/instances.csv"
+// Runtimes below are treated as this (the CSVs round them to hundredths)
+#define REPORT_MIN_RUNTIME 0.01
+// Runtime histogram: 100 buckets per decade from 1 ms to 1e6 s, so the
+// quantiles are within 2.3% of the exact ones
+#define REPORT_FIRST_DECADE -3
+#define REPORT_DECADES 9
+#define REPORT_BUCKETS_PER_DECADE 100
+// Performance profiles are sampled at 20 ratios per decade up to 10^3
+#define REPORT_TAU_DECADES 3
+#define REPORT_TAU_PER_DECADE 20
+
+typedef struct {
+  const char *store;     // Results store to aggregate
+  char **imports;        // Solution CSVs appended to the store first
+  int imports_length;    // Number of solution CSVs
+  const char *instances; // Instances file of the imported solutions
+  const char *output;    // Prefix of the CSV reports
+} report_options_t;
+
+// Stream over the results store writing per formulation runtime quantiles,
+// solve rates and mean gaps in <output>.csv and the Dolan-More performance
+// profiles in <output>-profile.csv
+int report(const report_options_t *options);
+
+// Append the rows of a solution CSV (Solver, Instance, Status, Runtime,
+// Solution, Heuristic) to `store`, with the features of `instances`
+int report_import(const char *solutions, const char *instances,
+                  const char *store);
@@ -0,0 +1,24 @@
+#include "backend.h"
+#include <stdlib.h>
+#include <string.h>
+
+const backend_t *backend_get(const char *name) {
+#ifdef AMOD_WITH_GUROBI
+  if (!strcmp(name, gurobi_backend.name))
+    return &gurobi_backend;
+#endif
+  if (!strcmp(name, recorder_backend.name))
+    return &recorder_backend;
+  return NULL;
+}
+
+const backend_t *backend_default(void) {
+  const char *name = getenv("AMOD_BACKEND");
+  if (name != NULL && name[0] != '\0')
+    return backend_get(name);
+#ifdef AMOD_WITH_GUROBI
+  return &gurobi_backend;
+#else
+  return &recorder_backend;
+#endif
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "../../utils/entities.h"
+
+// Variable types and constraint senses (same values as Gurobi)
+#define BACKEND_CONTINUOUS 'C'
+#define BACKEND_BINARY 'B'
+#define BACKEND_INTEGER 'I'
+#define BACKEND_LESS_EQUAL '<'
+#define BACKEND_GREATER_EQUAL '>'
+#define BACKEND_EQUAL '='
+#define BACKEND_INFINITY 1e100
+
+// Algorithms of PARAM_METHOD (same values as Gurobi, -1: automatic)
+#define METHOD_DUAL 1
+#define METHOD_BARRIER 2
+#define METHOD_CONCURRENT 3
+
+// Optimization status (same values as Gurobi)
+#define STATUS_LOADED 1 // Model built but not solved
+#define STATUS_OPTIMAL 2
+#define STATUS_INFEASIBLE 3
+#define STATUS_CUTOFF 6
+#define STATUS_TIME_LIMIT 9
+#define STATUS_MEM_LIMIT 17
+
+// Error codes returned by the backends that are not Gurobi
+#define BACKEND_ERROR_NULL_ARGUMENT 10002
+#define BACKEND_ERROR_OUT_OF_MEMORY 10001
+#define BACKEND_ERROR_UNKNOWN_ATTRIBUTE 10004
+#define BACKEND_ERROR_DATA_NOT_AVAILABLE 10005
+#define BACKEND_ERROR_INDEX_OUT_OF_RANGE 10006
+#define BACKEND_ERROR_UNKNOWN_PARAMETER 10007
+#define BACKEND_ERROR_FILE_WRITE 10013
+
+// Parameters and attributes use the Gurobi names, backends reject (or ignore,
+// for parameters) the ones they do not support
+#define PARAM_TIME_LIMIT "TimeLimit"
+#define PARAM_SEED "Seed"
+#define PARAM_MIP_FOCUS "MIPFocus"
+#define PARAM_PRESOLVE "Presolve"
+#define PARAM_CUTS "Cuts"
+#define PARAM_HEURISTICS "Heuristics"
+#define PARAM_METHOD "Method"
+#define PARAM_THREADS "Threads"
+// Barrier solves end without a basis (0), enough for a bound
+#define PARAM_CROSSOVER "Crossover"
+// Only solutions better than the value are searched, STATUS_CUTOFF if none
+#define PARAM_CUTOFF "Cutoff"
+// GB, the solve stops with STATUS_MEM_LIMIT above it (Gurobi's MemLimit can
+// only be set on an environment before it starts, this one on every model)
+#define PARAM_MEM_LIMIT "SoftMemLimit"
+#define ATTR_STATUS "Status"
+#define ATTR_RUNTIME "Runtime"
+#define ATTR_OBJ_VAL "ObjVal"
+#define ATTR_OBJ_BOUND "ObjBound"
+#define ATTR_SOL_COUNT "SolCount"
+#define ATTR_NUM_VARS "NumVars"
+#define ATTR_NUM_CONSTRS "NumConstrs"
+#define ATTR_NUM_NZS "NumNZs"
+#define ATTR_MEM_USED "MemUsed"
+#define ATTR_MAX_MEM_USED "MaxMemUsed"
+#define ATTR_ITER_COUNT "IterCount"        // Simplex iterations (double)
+#define ATTR_BAR_ITER_COUNT "BarIterCount" // Barrier iterations (int)
+#define ATTR_X "X"
+#define ATTR_START "Start"
+#define ATTR_LB "LB"
+#define ATTR_UB "UB"
+
+// Progress of a running optimize: `report` gets the best objective and bound
+// so far (BACKEND_INFINITY and -BACKEND_INFINITY before there are any), from
+// the thread calling optimize. Embedded first in the structure it updates
+typedef struct backend_progress_t backend_progress_t;
+struct backend_progress_t {
+  void (*report)(backend_progress_t *progress, double objective, double bound);
+};
+
+// Thin layer between the model builders and the engine solving the models:
+// every function returns 0 on success or an error code described by
+// `error_message`
+struct backend_t {
+  const char *name;
+  int (*env_init)(void **env);
+  void (*env_free)(void *env);
+  const char *(*error_message)(void *env);
+
+  int (*model_init)(void *env, void **model, const char *name);
+  int (*model_free)(void *model);
+  // Append `count` columns: objective, bounds (NULL: [0, inf)), types, names
+  int (*add_vars)(void *model, int count, double *obj, double *lb, double *ub,
+                  char *types, char **names);
+  // Append `count` rows in CSR format: row i has the nonzeros in
+  // [begins[i], begins[i + 1]) (or up to `nonzeros` for the last row)
+  int (*add_constrs)(void *model, int count, int nonzeros, int *begins,
+                     int *indexes, double *values, char *senses, double *rhs);
+  // Process pending changes (needed before querying a built model)
+  int (*update)(void *model);
+  int (*set_int_param)(void *model, const char *name, int value);
+  int (*set_dbl_param)(void *model, const char *name, double value);
+  // Set one element of an array attribute (e.g. the MIP start)
+  int (*set_dbl_element)(void *model, const char *name, int index,
+                         double value);
+  int (*set_dbl_array)(void *model, const char *name, int first, int length,
+                       double *values);
+  int (*optimize)(void *model);
+  // Continuous copy of `model` (integrality dropped), a model of its own
+  int (*relax)(void *model, void **relaxed);
+  // Report the progress of the next optimizes of `model` (NULL: stop)
+  int (*set_progress)(void *model, backend_progress_t *progress);
+  int (*get_int_attr)(void *model, const char *name, int *value);
+  int (*get_dbl_attr)(void *model, const char *name, double *value);
+  int (*get_dbl_array)(void *model, const char *name, int first, int length,
+                       double *values);
+  int (*write)(void *model, const char *filename);
+};
+
+// Solves the models with Gurobi (only available when built with Gurobi)
+extern const backend_t gurobi_backend;
+// Only records the models in memory (CSR matrix, bounds, starts), never solves
+extern const backend_t recorder_backend;
+
+// Backend called `name` ("gurobi" or "recorder"), NULL if not available
+const backend_t *backend_get(const char *name);
+// Backend chosen by the AMOD_BACKEND environment variable, Gurobi if available
+// otherwise the recorder
+const backend_t *backend_default(void);
@@ -0,0 +1,157 @@
+#include "backend.h"
+#include "gurobi_c.h"
+#include <stdio.h>
+
+int gurobi_env_init(void **env);
+void gurobi_env_free(void *env);
+const char *gurobi_error_message(void *env);
+int gurobi_model_init(void *env, void **model, const char *name);
+int gurobi_model_free(void *model);
+int gurobi_add_vars(void *model, int count, double *obj, double *lb,
+                    double *ub, char *types, char **names);
+int gurobi_add_constrs(void *model, int count, int nonzeros, int *begins,
+                       int *indexes, double *values, char *senses,
+                       double *rhs);
+int gurobi_update(void *model);
+int gurobi_set_int_param(void *model, const char *name, int value);
+int gurobi_set_dbl_param(void *model, const char *name, double value);
+int gurobi_set_dbl_element(void *model, const char *name, int index,
+                           double value);
+int gurobi_set_dbl_array(void *model, const char *name, int first, int length,
+                         double *values);
+int gurobi_optimize(void *model);
+int gurobi_relax(void *model, void **relaxed);
+int gurobi_set_progress(void *model, backend_progress_t *progress);
+int __stdcall gurobi_callback(GRBmodel *model, void *cbdata, int where,
+                              void *usrdata);
+int gurobi_get_int_attr(void *model, const char *name, int *value);
+int gurobi_get_dbl_attr(void *model, const char *name, double *value);
+int gurobi_get_dbl_array(void *model, const char *name, int first, int length,
+                         double *values);
+int gurobi_write(void *model, const char *filename);
+
+const backend_t gurobi_backend = {
+    .name = "gurobi",
+    .env_init = gurobi_env_init,
+    .env_free = gurobi_env_free,
+    .error_message = gurobi_error_message,
+    .model_init = gurobi_model_init,
+    .model_free = gurobi_model_free,
+    .add_vars = gurobi_add_vars,
+    .add_constrs = gurobi_add_constrs,
+    .update = gurobi_update,
+    .set_int_param = gurobi_set_int_param,
+    .set_dbl_param = gurobi_set_dbl_param,
+    .set_dbl_element = gurobi_set_dbl_element,
+    .set_dbl_array = gurobi_set_dbl_array,
+    .optimize = gurobi_optimize,
+    .relax = gurobi_relax,
+    .set_progress = gurobi_set_progress,
+    .get_int_attr = gurobi_get_int_attr,
+    .get_dbl_attr = gurobi_get_dbl_attr,
+    .get_dbl_array = gurobi_get_dbl_array,
+    .write = gurobi_write,
+};
+
+int gurobi_env_init(void **env) {
+  int result = 0;
+  GRBenv *grb_env = NULL;
+  if ((result = GRBemptyenv(&grb_env)) != 0) {
+    fprintf(stderr, "GRBemptyenv failed (code: %d)\n", result);
+    return result;
+  }
+  *env = grb_env;
+  return GRBstartenv(grb_env);
+}
+
+void gurobi_env_free(void *env) { GRBfreeenv(env); }
+
+const char *gurobi_error_message(void *env) { return GRBgeterrormsg(env); }
+
+int gurobi_model_init(void *env, void **model, const char *name) {
+  GRBmodel *grb_model = NULL;
+  int result =
+      GRBnewmodel(env, &grb_model, name, 0, NULL, NULL, NULL, NULL, NULL);
+  *model = grb_model;
+  return result;
+}
+
+int gurobi_model_free(void *model) { return GRBfreemodel(model); }
+
+int gurobi_add_vars(void *model, int count, double *obj, double *lb,
+                    double *ub, char *types, char **names) {
+  return GRBaddvars(model, count, 0, NULL, NULL, NULL, obj, lb, ub, types,
+                    names);
+}
+
+int gurobi_add_constrs(void *model, int count, int nonzeros, int *begins,
+                       int *indexes, double *values, char *senses,
+                       double *rhs) {
+  return GRBaddconstrs(model, count, nonzeros, begins, indexes, values, senses,
+                       rhs, NULL);
+}
+
+int gurobi_update(void *model) { return GRBupdatemodel(model); }
+
+int gurobi_set_int_param(void *model, const char *name, int value) {
+  return GRBsetintparam(GRBgetenv(model), name, value);
+}
+
+int gurobi_set_dbl_param(void *model, const char *name, double value) {
+  return GRBsetdblparam(GRBgetenv(model), name, value);
+}
+
+int gurobi_set_dbl_element(void *model, const char *name, int index,
+                           double value) {
+  return GRBsetdblattrelement(model, name, index, value);
+}
+
+int gurobi_set_dbl_array(void *model, const char *name, int first, int length,
+                         double *values) {
+  return GRBsetdblattrarray(model, name, first, length, values);
+}
+
+int gurobi_optimize(void *model) { return GRBoptimize(model); }
+
+int gurobi_relax(void *model, void **relaxed) {
+  // Pending changes are not part of the copy
+  int result = GRBupdatemodel(model);
+  if (result != 0)
+    return result;
+  return GRBrelaxmodel(model, (GRBmodel **)relaxed);
+}
+
+int gurobi_set_progress(void *model, backend_progress_t *progress) {
+  return GRBsetcallbackfunc(model, progress != NULL ? gurobi_callback : NULL,
+                            progress);
+}
+
+int __stdcall gurobi_callback(GRBmodel *model, void *cbdata, int where,
+                              void *usrdata) {
+  // Called between the nodes of the MIP search
+  if (where != GRB_CB_MIP)
+    return 0;
+  double objective = GRB_INFINITY, bound = -GRB_INFINITY;
+  GRBcbget(cbdata, where, GRB_CB_MIP_OBJBST, &objective);
+  GRBcbget(cbdata, where, GRB_CB_MIP_OBJBND, &bound);
+  backend_progress_t *progress = usrdata;
+  progress->report(progress, objective, bound);
+  return 0;
+}
+
+int gurobi_get_int_attr(void *model, const char *name, int *value) {
+  return GRBgetintattr(model, name, value);
+}
+
+int gurobi_get_dbl_attr(void *model, const char *name, double *value) {
+  return GRBgetdblattr(model, name, value);
+}
+
+int gurobi_get_dbl_array(void *model, const char *name, int first, int length,
+                         double *values) {
+  return GRBgetdblattrarray(model, name, first, length, values);
+}
+
+int gurobi_write(void *model, const char *filename) {
+  return GRBwrite(model, filename);
+}
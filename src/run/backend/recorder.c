@@ -0,0 +1,476 @@
+#include "backend.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORDER_DEFAULT_SIZE 64
+#define RECORDER_ERROR_SIZE 256
+
+typedef struct {
+  char error[RECORDER_ERROR_SIZE];
+} recorder_env_t;
+
+// Model kept in memory: columns as arrays, rows as a CSR matrix
+typedef struct {
+  recorder_env_t *env;
+  int vars;
+  int vars_capacity;
+  double *obj;
+  double *lb;
+  double *ub;
+  double *start; // BACKEND_INFINITY when not set
+  char *types;
+  int constrs;
+  int constrs_capacity;
+  int nonzeros;
+  int nonzeros_capacity;
+  int *begins;
+  int *indexes;
+  double *values;
+  char *senses;
+  double *rhs;
+  int status;
+  backend_progress_t *progress; // Told that nothing was found
+} recorder_model_t;
+
+int recorder_env_init(void **env);
+void recorder_env_free(void *env);
+const char *recorder_error_message(void *env);
+int recorder_model_init(void *env, void **model, const char *name);
+int recorder_model_free(void *model);
+int recorder_add_vars(void *model, int count, double *obj, double *lb,
+                      double *ub, char *types, char **names);
+int recorder_add_constrs(void *model, int count, int nonzeros, int *begins,
+                         int *indexes, double *values, char *senses,
+                         double *rhs);
+int recorder_update(void *model);
+int recorder_set_int_param(void *model, const char *name, int value);
+int recorder_set_dbl_param(void *model, const char *name, double value);
+int recorder_set_dbl_element(void *model, const char *name, int index,
+                             double value);
+int recorder_set_dbl_array(void *model, const char *name, int first,
+                           int length, double *values);
+int recorder_optimize(void *model);
+int recorder_relax(void *model, void **relaxed);
+int recorder_set_progress(void *model, backend_progress_t *progress);
+int recorder_get_int_attr(void *model, const char *name, int *value);
+int recorder_get_dbl_attr(void *model, const char *name, double *value);
+int recorder_get_dbl_array(void *model, const char *name, int first,
+                           int length, double *values);
+int recorder_write(void *model, const char *filename);
+
+int recorder_error(recorder_model_t *model, int code, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+double *recorder_column(recorder_model_t *model, const char *name);
+int recorder_capacity(int capacity, int needed);
+int recorder_resize(void **array, size_t size, int capacity);
+void recorder_write_row(FILE *fp, int length, const int *indexes,
+                        const double *values);
+
+const backend_t recorder_backend = {
+    .name = "recorder",
+    .env_init = recorder_env_init,
+    .env_free = recorder_env_free,
+    .error_message = recorder_error_message,
+    .model_init = recorder_model_init,
+    .model_free = recorder_model_free,
+    .add_vars = recorder_add_vars,
+    .add_constrs = recorder_add_constrs,
+    .update = recorder_update,
+    .set_int_param = recorder_set_int_param,
+    .set_dbl_param = recorder_set_dbl_param,
+    .set_dbl_element = recorder_set_dbl_element,
+    .set_dbl_array = recorder_set_dbl_array,
+    .optimize = recorder_optimize,
+    .relax = recorder_relax,
+    .set_progress = recorder_set_progress,
+    .get_int_attr = recorder_get_int_attr,
+    .get_dbl_attr = recorder_get_dbl_attr,
+    .get_dbl_array = recorder_get_dbl_array,
+    .write = recorder_write,
+};
+
+int recorder_env_init(void **env) {
+  recorder_env_t *recorder_env = malloc(sizeof(*recorder_env));
+  if (recorder_env == NULL) {
+    perror("Could not allocate memory for recorder environment");
+    return BACKEND_ERROR_OUT_OF_MEMORY;
+  }
+  recorder_env->error[0] = '\0';
+  *env = recorder_env;
+  return 0;
+}
+
+void recorder_env_free(void *env) { free(env); }
+
+const char *recorder_error_message(void *env) {
+  if (env == NULL)
+    return "Recorder environment not initialized";
+  return ((recorder_env_t *)env)->error;
+}
+
+int recorder_model_init(void *env, void **model, const char *name) {
+  (void)name;
+  if (env == NULL)
+    return BACKEND_ERROR_NULL_ARGUMENT;
+  recorder_model_t *m = malloc(sizeof(*m));
+  if (m == NULL) {
+    perror("Could not allocate memory for recorded model");
+    return BACKEND_ERROR_OUT_OF_MEMORY;
+  }
+  memset(m, 0, sizeof(*m));
+  m->env = env;
+  m->status = STATUS_LOADED;
+  *model = m;
+  return 0;
+}
+
+int recorder_model_free(void *model) {
+  recorder_model_t *m = model;
+  if (m == NULL)
+    return 0;
+  free(m->obj);
+  free(m->lb);
+  free(m->ub);
+  free(m->start);
+  free(m->types);
+  free(m->begins);
+  free(m->indexes);
+  free(m->values);
+  free(m->senses);
+  free(m->rhs);
+  free(m);
+  return 0;
+}
+
+int recorder_add_vars(void *model, int count, double *obj, double *lb,
+                      double *ub, char *types, char **names) {
+  (void)names;
+  recorder_model_t *m = model;
+  int needed = m->vars + count;
+  if (needed > m->vars_capacity) {
+    int capacity = recorder_capacity(m->vars_capacity, needed);
+    if (recorder_resize((void **)&m->obj, sizeof(*m->obj), capacity) ||
+        recorder_resize((void **)&m->lb, sizeof(*m->lb), capacity) ||
+        recorder_resize((void **)&m->ub, sizeof(*m->ub), capacity) ||
+        recorder_resize((void **)&m->start, sizeof(*m->start), capacity) ||
+        recorder_resize((void **)&m->types, sizeof(*m->types), capacity))
+      return recorder_error(m, BACKEND_ERROR_OUT_OF_MEMORY,
+                            "Could not allocate %d variables", needed);
+    m->vars_capacity = capacity;
+  }
+  for (size_t k = 0; k < count; k++) {
+    int v = m->vars + k;
+    m->obj[v] = obj != NULL ? obj[k] : 0;
+    m->lb[v] = lb != NULL ? lb[k] : 0;
+    m->ub[v] = ub != NULL ? ub[k] : BACKEND_INFINITY;
+    m->types[v] = types != NULL ? types[k] : BACKEND_CONTINUOUS;
+    if (m->types[v] == BACKEND_BINARY && ub == NULL)
+      m->ub[v] = 1;
+    m->start[v] = BACKEND_INFINITY;
+  }
+  m->vars = needed;
+  return 0;
+}
+
+int recorder_add_constrs(void *model, int count, int nonzeros, int *begins,
+                         int *indexes, double *values, char *senses,
+                         double *rhs) {
+  recorder_model_t *m = model;
+  for (size_t k = 0; k < nonzeros; k++) {
+    if (indexes[k] < 0 || indexes[k] >= m->vars)
+      return recorder_error(m, BACKEND_ERROR_INDEX_OUT_OF_RANGE,
+                            "Constraint references variable %d of %d",
+                            indexes[k], m->vars);
+  }
+
+  int needed = m->nonzeros + nonzeros;
+  if (needed > m->nonzeros_capacity) {
+    int capacity = recorder_capacity(m->nonzeros_capacity, needed);
+    if (recorder_resize((void **)&m->indexes, sizeof(*m->indexes), capacity) ||
+        recorder_resize((void **)&m->values, sizeof(*m->values), capacity))
+      return recorder_error(m, BACKEND_ERROR_OUT_OF_MEMORY,
+                            "Could not allocate %d nonzeros", needed);
+    m->nonzeros_capacity = capacity;
+  }
+  // Row i ends where row i + 1 begins: begins has one extra element
+  needed = m->constrs + count + 1;
+  if (needed > m->constrs_capacity) {
+    int capacity = recorder_capacity(m->constrs_capacity, needed);
+    if (recorder_resize((void **)&m->begins, sizeof(*m->begins), capacity) ||
+        recorder_resize((void **)&m->senses, sizeof(*m->senses), capacity) ||
+        recorder_resize((void **)&m->rhs, sizeof(*m->rhs), capacity))
+      return recorder_error(m, BACKEND_ERROR_OUT_OF_MEMORY,
+                            "Could not allocate %d constraints", needed);
+    m->constrs_capacity = capacity;
+  }
+
+  memcpy(m->indexes + m->nonzeros, indexes, sizeof(*indexes) * nonzeros);
+  memcpy(m->values + m->nonzeros, values, sizeof(*values) * nonzeros);
+  for (size_t k = 0; k < count; k++) {
+    int c = m->constrs + k;
+    m->begins[c] = m->nonzeros + begins[k];
+    m->senses[c] = senses[k];
+    m->rhs[c] = rhs[k];
+  }
+  m->constrs += count;
+  m->nonzeros += nonzeros;
+  m->begins[m->constrs] = m->nonzeros;
+  return 0;
+}
+
+int recorder_update(void *model) {
+  (void)model;
+  return 0;
+}
+
+int recorder_set_int_param(void *model, const char *name, int value) {
+  // Nothing is solved: every parameter is accepted and ignored
+  (void)model;
+  (void)name;
+  (void)value;
+  return 0;
+}
+
+int recorder_set_dbl_param(void *model, const char *name, double value) {
+  (void)model;
+  (void)name;
+  (void)value;
+  return 0;
+}
+
+int recorder_set_dbl_element(void *model, const char *name, int index,
+                             double value) {
+  recorder_model_t *m = model;
+  double *column = recorder_column(m, name);
+  if (column == NULL)
+    return recorder_error(m, BACKEND_ERROR_UNKNOWN_ATTRIBUTE,
+                          "Unknown attribute %s", name);
+  if (index < 0 || index >= m->vars)
+    return recorder_error(m, BACKEND_ERROR_INDEX_OUT_OF_RANGE,
+                          "Variable %d of %d", index, m->vars);
+  column[index] = value;
+  return 0;
+}
+
+int recorder_set_dbl_array(void *model, const char *name, int first,
+                           int length, double *values) {
+  recorder_model_t *m = model;
+  double *column = recorder_column(m, name);
+  if (column == NULL)
+    return recorder_error(m, BACKEND_ERROR_UNKNOWN_ATTRIBUTE,
+                          "Unknown attribute %s", name);
+  if (first < 0 || first + length > m->vars)
+    return recorder_error(m, BACKEND_ERROR_INDEX_OUT_OF_RANGE,
+                          "Variables [%d, %d) of %d", first, first + length,
+                          m->vars);
+  memcpy(column + first, values, sizeof(*values) * length);
+  return 0;
+}
+
+int recorder_optimize(void *model) {
+  recorder_model_t *m = model;
+  m->status = STATUS_LOADED;
+  if (m->progress != NULL)
+    m->progress->report(m->progress, BACKEND_INFINITY, -BACKEND_INFINITY);
+  return 0;
+}
+
+int recorder_relax(void *model, void **relaxed) {
+  recorder_model_t *m = model;
+  int result = 0;
+  char *types = malloc(sizeof(*types) * (m->vars > 0 ? m->vars : 1));
+  if (types == NULL)
+    return recorder_error(m, BACKEND_ERROR_OUT_OF_MEMORY,
+                          "Could not allocate %d variables", m->vars);
+  memset(types, BACKEND_CONTINUOUS, sizeof(*types) * m->vars);
+  *relaxed = NULL;
+  // Bounds are copied as they are, binaries keep their upper bound of 1
+  if ((result = recorder_model_init(m->env, relaxed, NULL)) == 0 &&
+      (result = recorder_add_vars(*relaxed, m->vars, m->obj, m->lb, m->ub,
+                                  types, NULL)) == 0 &&
+      m->constrs > 0)
+    result = recorder_add_constrs(*relaxed, m->constrs, m->nonzeros,
+                                  m->begins, m->indexes, m->values, m->senses,
+                                  m->rhs);
+  if (result == 0) {
+    memcpy(((recorder_model_t *)*relaxed)->start, m->start,
+           sizeof(*m->start) * m->vars);
+  } else {
+    recorder_model_free(*relaxed);
+    *relaxed = NULL;
+  }
+  free(types);
+  return result;
+}
+
+int recorder_set_progress(void *model, backend_progress_t *progress) {
+  recorder_model_t *m = model;
+  m->progress = progress;
+  return 0;
+}
+
+int recorder_get_int_attr(void *model, const char *name, int *value) {
+  recorder_model_t *m = model;
+  if (!strcmp(name, ATTR_NUM_VARS))
+    *value = m->vars;
+  else if (!strcmp(name, ATTR_NUM_CONSTRS))
+    *value = m->constrs;
+  else if (!strcmp(name, ATTR_NUM_NZS))
+    *value = m->nonzeros;
+  else if (!strcmp(name, ATTR_STATUS))
+    *value = m->status;
+  else if (!strcmp(name, ATTR_SOL_COUNT) ||
+           !strcmp(name, ATTR_BAR_ITER_COUNT))
+    *value = 0;
+  else
+    return recorder_error(m, BACKEND_ERROR_UNKNOWN_ATTRIBUTE,
+                          "Unknown attribute %s", name);
+  return 0;
+}
+
+int recorder_get_dbl_attr(void *model, const char *name, double *value) {
+  recorder_model_t *m = model;
+  if (!strcmp(name, ATTR_RUNTIME) || !strcmp(name, ATTR_ITER_COUNT)) {
+    *value = 0;
+  } else if (!strcmp(name, ATTR_MEM_USED) ||
+             !strcmp(name, ATTR_MAX_MEM_USED)) {
+    // GB used by the recorded arrays, they only grow
+    size_t bytes = (size_t)m->vars_capacity * (sizeof(double) * 4 + 1) +
+                   (size_t)m->constrs_capacity *
+                       (sizeof(int) + sizeof(char) + sizeof(double)) +
+                   (size_t)m->nonzeros_capacity * (sizeof(int) + sizeof(double));
+    *value = bytes / 1e9;
+  } else if (!strcmp(name, ATTR_OBJ_VAL)) {
+    return recorder_error(m, BACKEND_ERROR_DATA_NOT_AVAILABLE,
+                          "Recorded models are never solved");
+  } else {
+    return recorder_error(m, BACKEND_ERROR_UNKNOWN_ATTRIBUTE,
+                          "Unknown attribute %s", name);
+  }
+  return 0;
+}
+
+int recorder_get_dbl_array(void *model, const char *name, int first,
+                           int length, double *values) {
+  recorder_model_t *m = model;
+  if (!strcmp(name, ATTR_X))
+    return recorder_error(m, BACKEND_ERROR_DATA_NOT_AVAILABLE,
+                          "Recorded models are never solved");
+  double *column = recorder_column(m, name);
+  if (column == NULL)
+    return recorder_error(m, BACKEND_ERROR_UNKNOWN_ATTRIBUTE,
+                          "Unknown attribute %s", name);
+  if (first < 0 || first + length > m->vars)
+    return recorder_error(m, BACKEND_ERROR_INDEX_OUT_OF_RANGE,
+                          "Variables [%d, %d) of %d", first, first + length,
+                          m->vars);
+  memcpy(values, column + first, sizeof(*values) * length);
+  return 0;
+}
+
+int recorder_write(void *model, const char *filename) {
+  recorder_model_t *m = model;
+  const char *extension = strrchr(filename, '.');
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL)
+    return recorder_error(m, BACKEND_ERROR_FILE_WRITE, "Could not open %s",
+                          filename);
+
+  // No solution to export: the MIP start is written instead
+  if (extension != NULL && strcmp(extension, ".lp") != 0) {
+    fprintf(fp, "# Recorded model (not solved): MIP start\n");
+    for (size_t v = 0; v < m->vars; v++) {
+      if (m->start[v] < BACKEND_INFINITY)
+        fprintf(fp, "x%ld %g\n", v, m->start[v]);
+    }
+    fclose(fp);
+    return 0;
+  }
+
+  fprintf(fp, "\\ Recorded model: %d vars, %d constrs, %d nonzeros\n", m->vars,
+          m->constrs, m->nonzeros);
+  fprintf(fp, "Minimize\n obj:");
+  for (size_t v = 0; v < m->vars; v++) {
+    if (m->obj[v] != 0)
+      fprintf(fp, " %+g x%ld", m->obj[v], v);
+  }
+  fprintf(fp, "\nSubject To\n");
+  for (size_t c = 0; c < m->constrs; c++) {
+    fprintf(fp, " c%ld:", c);
+    recorder_write_row(fp, m->begins[c + 1] - m->begins[c],
+                       m->indexes + m->begins[c], m->values + m->begins[c]);
+    const char *sense = m->senses[c] == BACKEND_LESS_EQUAL      ? "<="
+                        : m->senses[c] == BACKEND_GREATER_EQUAL ? ">="
+                                                                : "=";
+    fprintf(fp, " %s %g\n", sense, m->rhs[c]);
+  }
+  fprintf(fp, "Bounds\n");
+  for (size_t v = 0; v < m->vars; v++) {
+    int binary_bounds = m->lb[v] == 0 && m->ub[v] == 1;
+    if (m->types[v] == BACKEND_BINARY && binary_bounds)
+      continue;
+    if (m->lb[v] == m->ub[v])
+      fprintf(fp, " x%ld = %g\n", v, m->lb[v]);
+    else if (m->lb[v] != 0 || m->ub[v] < BACKEND_INFINITY)
+      fprintf(fp, " %g <= x%ld <= %g\n", m->lb[v], v, m->ub[v]);
+  }
+  const char *sections[2] = {"Generals", "Binaries"};
+  const char types[2] = {BACKEND_INTEGER, BACKEND_BINARY};
+  for (size_t s = 0; s < 2; s++) {
+    fprintf(fp, "%s\n", sections[s]);
+    for (size_t v = 0; v < m->vars; v++) {
+      if (m->types[v] == types[s])
+        fprintf(fp, " x%ld\n", v);
+    }
+  }
+  fprintf(fp, "End\n");
+  fclose(fp);
+  return 0;
+}
+
+int recorder_error(recorder_model_t *model, int code, const char *format,
+                   ...) {
+  va_list arg;
+  va_start(arg, format);
+  vsnprintf(model->env->error, RECORDER_ERROR_SIZE, format, arg);
+  va_end(arg);
+  return code;
+}
+
+double *recorder_column(recorder_model_t *model, const char *name) {
+  if (!strcmp(name, ATTR_START))
+    return model->start;
+  if (!strcmp(name, "LB"))
+    return model->lb;
+  if (!strcmp(name, "UB"))
+    return model->ub;
+  if (!strcmp(name, "Obj"))
+    return model->obj;
+  return NULL;
+}
+
+int recorder_capacity(int capacity, int needed) {
+  int new_capacity = capacity > 0 ? capacity : RECORDER_DEFAULT_SIZE;
+  while (new_capacity < needed)
+    new_capacity *= 2;
+  return new_capacity;
+}
+
+int recorder_resize(void **array, size_t size, int capacity) {
+  void *values = realloc(*array, size * capacity);
+  if (values == NULL) {
+    perror("Could not reallocate recorded model");
+    return -1;
+  }
+  *array = values;
+  return 0;
+}
+
+void recorder_write_row(FILE *fp, int length, const int *indexes,
+                        const double *values) {
+  for (size_t k = 0; k < length; k++) {
+    fprintf(fp, " %+g x%d", values[k], indexes[k]);
+  }
+}
@@ -0,0 +1,438 @@
+#include "block.h"
+#include "../utils/evaluate.h"
+#include "../utils/utils.h"
+#include "backend/backend.h"
+#include "dp.h"
+#include "memory.h"
+#include "model/model.h"
+#include "run.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+// Blocks shared by the workers, each one taken by a single worker
+typedef struct {
+  vector_t *instances;
+  solver_t solver;
+  int exact;            // Blocks of at most `exact` jobs skip the models
+  double deadline;      // Wall clock when every block must be solved
+  int threads;          // Backend threads of every block model
+  pthread_mutex_t lock; // Guards `next` and `active`
+  int next;             // Next block to take
+  int active;           // Block models admitted and not freed yet
+  pthread_cond_t released; // Signaled when an admitted model is freed
+  int *status;          // Backend status of every block
+  long long *objectives; // Sum C_j of every block, -1 without a solution
+  long long *bounds;     // Bound of every block, -1 if not available
+  int **sequences;       // Sequence of every block (its own job indexes)
+} pool_t;
+
+typedef struct {
+  pool_t *pool;
+  simulation_t sim; // Own backend environment, the blocks as instances
+  int result;
+} worker_t;
+
+int blocks_add(blocks_t *blocks, const instance_t *instance, const int *jobs,
+               int length);
+void *blocks_worker(void *data);
+int blocks_solve_one(simulation_t *sim, pool_t *pool, int b);
+int blocks_admit(simulation_t *sim, pool_t *pool, double gb, double *limit);
+void blocks_release(simulation_t *sim, pool_t *pool, double gb);
+
+blocks_t *blocks_split(instance_t *instance) {
+  int n = instance->number_of_jobs;
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return NULL;
+  blocks_t *blocks = malloc(sizeof(*blocks));
+  if (blocks == NULL) {
+    perror("Could not allocate memory for blocks");
+    return NULL;
+  }
+  blocks->instances = vector_init();
+  blocks->jobs = malloc(sizeof(*blocks->jobs) * (n > 0 ? n : 1));
+  blocks->offsets = malloc(sizeof(*blocks->offsets) * (n > 0 ? n : 1));
+  if (blocks->instances == NULL || blocks->jobs == NULL ||
+      blocks->offsets == NULL) {
+    perror("Could not allocate memory for blocks");
+    if (blocks->instances != NULL)
+      vector_free(blocks->instances);
+    free(blocks->jobs);
+    free(blocks->offsets);
+    free(blocks);
+    return NULL;
+  }
+
+  // Earliest release date schedule: the machine idles before job k when
+  // it is released after the previous jobs are done
+  int first = 0;
+  long long t = 0;
+  for (size_t k = 0; k < n; k++) {
+    int j = orders->by_release[k];
+    if (k > 0 && instance->release_dates[j] > t) {
+      if (blocks_add(blocks, instance, orders->by_release + first,
+                     k - first) != 0) {
+        blocks_free(blocks);
+        return NULL;
+      }
+      first = k;
+    }
+    if (instance->release_dates[j] > t)
+      t = instance->release_dates[j];
+    t += instance->processing_times[j];
+  }
+  if (n > 0 &&
+      blocks_add(blocks, instance, orders->by_release + first, n - first) != 0) {
+    blocks_free(blocks);
+    return NULL;
+  }
+  return blocks;
+}
+
+void blocks_free(blocks_t *blocks) {
+  if (blocks == NULL)
+    return;
+  for (size_t b = 0; b < blocks->instances->length; b++) {
+    instance_t *block = blocks->instances->values[b];
+    instance_orders_free(block);
+    free(block->processing_times);
+    free(block->release_dates);
+    free(blocks->jobs[b]);
+  }
+  vector_free(blocks->instances);
+  blocks->instances = NULL;
+  free(blocks->jobs);
+  blocks->jobs = NULL;
+  free(blocks->offsets);
+  blocks->offsets = NULL;
+  free(blocks);
+}
+
+solution_t *blocks_solve(simulation_t *sim, instance_t *instance,
+                         blocks_t *blocks, solver_t solver, double limit,
+                         int workers, int exact, int *sequence) {
+  int n = instance->number_of_jobs;
+  int length = blocks->instances->length;
+  measure_t start, end;
+  measure_now(&start);
+
+  pool_t pool = {.instances = blocks->instances,
+                 .solver = solver,
+                 .exact = exact,
+                 .deadline = start.wall + limit,
+                 .threads = 0,
+                 .next = 0,
+                 .active = 0};
+  pool.status = malloc(sizeof(*pool.status) * length);
+  pool.objectives = malloc(sizeof(*pool.objectives) * length);
+  pool.bounds = malloc(sizeof(*pool.bounds) * length);
+  pool.sequences = calloc(length, sizeof(*pool.sequences));
+  solution_t *solution = malloc(sizeof(*solution));
+  double *values = malloc(sizeof(*values) * n);
+  int *c_hs = malloc(sizeof(*c_hs) * n);
+  worker_t *pool_workers = malloc(sizeof(*pool_workers) * workers);
+  pthread_t *threads = malloc(sizeof(*threads) * workers);
+  int result = pool.status == NULL || pool.objectives == NULL ||
+                       pool.bounds == NULL || pool.sequences == NULL ||
+                       solution == NULL || values == NULL || c_hs == NULL ||
+                       pool_workers == NULL || threads == NULL
+                   ? -1
+                   : 0;
+  for (size_t b = 0; b < length && result == 0; b++) {
+    instance_t *block = blocks->instances->values[b];
+    pool.status[b] = 0;
+    pool.objectives[b] = -1;
+    pool.bounds[b] = -1;
+    pool.sequences[b] = malloc(sizeof(*pool.sequences[b]) *
+                               block->number_of_jobs);
+    if (pool.sequences[b] == NULL)
+      result = -1;
+  }
+  if (result != 0) {
+    perror("Could not allocate memory for blocks solve");
+  } else if (pthread_mutex_init(&pool.lock, NULL) != 0) {
+    perror("Could not initialize blocks lock");
+    result = -1;
+  } else if (pthread_cond_init(&pool.released, NULL) != 0) {
+    perror("Could not initialize blocks condition");
+    pthread_mutex_destroy(&pool.lock);
+    result = -1;
+  }
+
+  if (result == 0) {
+    // Worker 0 is this thread with the simulation environment
+    int started = 0;
+    if (workers > length)
+      workers = length;
+    // Concurrent block models share the processors
+    int processors = blocks_workers();
+    if (workers > 1)
+      pool.threads = processors > workers ? processors / workers : 1;
+    for (size_t w = 0; w < workers; w++) {
+      pool_workers[w].pool = &pool;
+      pool_workers[w].sim = *sim;
+      pool_workers[w].sim.instances = blocks->instances;
+      // The progress of the instance, not of its blocks
+      pool_workers[w].sim.progress = NULL;
+      pool_workers[w].result = 0;
+      if (w == 0)
+        continue;
+      if (simulation_worker_init(&pool_workers[w].sim) != 0)
+        break;
+      if (pthread_create(&threads[w], NULL, blocks_worker, &pool_workers[w]) !=
+          0) {
+        simulation_worker_free(&pool_workers[w].sim);
+        break;
+      }
+      started += 1;
+    }
+    blocks_worker(&pool_workers[0]);
+    for (size_t w = 1; w <= started; w++) {
+      pthread_join(threads[w], NULL);
+      simulation_worker_free(&pool_workers[w].sim);
+    }
+    for (size_t w = 0; w <= started; w++) {
+      if (pool_workers[w].result != 0)
+        result = pool_workers[w].result;
+    }
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.released);
+  }
+
+  if (result == 0) {
+    // Blocks in release order, unsolved ones in earliest release date order
+    int proven = 1, position = 0;
+    long long sum = 0, bound = 0;
+    for (size_t b = 0; b < length; b++) {
+      instance_t *block = blocks->instances->values[b];
+      if (pool.objectives[b] < 0) {
+        proven = 0;
+        memcpy(pool.sequences[b], instance_orders(block)->by_release,
+               sizeof(*pool.sequences[b]) * block->number_of_jobs);
+      }
+      proven = proven && pool.status[b] == STATUS_OPTIMAL;
+      // Every completion of the block is `offsets[b]` later in the instance
+      long long shift = (long long)blocks->offsets[b] * block->number_of_jobs;
+      sum += pool.objectives[b] + shift;
+      bound = bound >= 0 && pool.bounds[b] >= 0 ? bound + pool.bounds[b] + shift
+                                                : -1;
+      for (size_t k = 0; k < block->number_of_jobs; k++) {
+        sequence[position++] = blocks->jobs[b][pool.sequences[b][k]];
+      }
+    }
+    long long objective = evaluate(instance, sequence, c_hs);
+    for (size_t h = 0; h < n; h++) {
+      values[sequence[h]] = c_hs[h];
+    }
+    measure_now(&end);
+    memset(solution, 0, sizeof(*solution));
+    solution->size = n;
+    solution->solver = solver;
+    // Overlapping blocks: the sum of the block optima is only a bound
+    solution->status =
+        proven && objective == sum ? STATUS_OPTIMAL : STATUS_TIME_LIMIT;
+    solution->runtime = end.wall - start.wall;
+    solution->objective_value = objective;
+    solution->bound = bound;
+    solution->gap = bound >= 0 && objective > 0
+                        ? (double)llabs(bound - objective) / objective
+                        : -1;
+    solution->values = values;
+    solution->heuristic_value = -1;
+    solution->memory = -1;
+  }
+
+  for (size_t b = 0; b < length && pool.sequences != NULL; b++) {
+    free(pool.sequences[b]);
+  }
+  free(pool.sequences);
+  free(pool.status);
+  free(pool.objectives);
+  free(pool.bounds);
+  free(c_hs);
+  free(pool_workers);
+  free(threads);
+  if (result != 0) {
+    free(values);
+    free(solution);
+    return NULL;
+  }
+  return solution;
+}
+
+int blocks_workers(void) {
+#ifdef __linux__
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+  return processors > 0 ? processors : 1;
+#else
+  return 1;
+#endif
+}
+
+int blocks_add(blocks_t *blocks, const instance_t *instance, const int *jobs,
+               int length) {
+  instance_t *block = malloc(sizeof(*block));
+  int *block_jobs = malloc(sizeof(*block_jobs) * length);
+  if (block == NULL || block_jobs == NULL) {
+    perror("Could not allocate memory for block");
+    free(block);
+    free(block_jobs);
+    return -1;
+  }
+  block->number_of_jobs = length;
+  block->processing_times = malloc(sizeof(*block->processing_times) * length);
+  block->release_dates = malloc(sizeof(*block->release_dates) * length);
+  block->orders = NULL;
+  block->model = NULL;
+  int offset = length > 0 ? instance->release_dates[jobs[0]] : 0;
+  for (size_t k = 1; k < length; k++) {
+    if (instance->release_dates[jobs[k]] < offset)
+      offset = instance->release_dates[jobs[k]];
+  }
+  if (block->processing_times == NULL || block->release_dates == NULL) {
+    perror("Could not allocate memory for block");
+    free(block->processing_times);
+    free(block->release_dates);
+    free(block);
+    free(block_jobs);
+    return -1;
+  }
+  for (size_t k = 0; k < length; k++) {
+    block_jobs[k] = jobs[k];
+    block->processing_times[k] = instance->processing_times[jobs[k]];
+    block->release_dates[k] = instance->release_dates[jobs[k]] - offset;
+  }
+  blocks->jobs[blocks->instances->length] = block_jobs;
+  blocks->offsets[blocks->instances->length] = offset;
+  return vector_add(blocks->instances, (void **)&block);
+}
+
+void *blocks_worker(void *data) {
+  worker_t *worker = data;
+  pool_t *pool = worker->pool;
+  for (;;) {
+    pthread_mutex_lock(&pool->lock);
+    int b = pool->next++;
+    pthread_mutex_unlock(&pool->lock);
+    if (b >= pool->instances->length)
+      break;
+    if (blocks_solve_one(&worker->sim, pool, b) != 0)
+      worker->result = -1;
+  }
+  return NULL;
+}
+
+int blocks_solve_one(simulation_t *sim, pool_t *pool, int b) {
+  int result = 0;
+  const backend_t *backend = sim->backend;
+  instance_t *block = sim->instances->values[b];
+  int *sequence = pool->sequences[b];
+
+  // A single job starts at its release date
+  if (block->number_of_jobs < BLOCK_MIN_JOBS) {
+    sequence[0] = 0;
+    pool->status[b] = STATUS_OPTIMAL;
+    pool->objectives[b] = evaluate(block, sequence, NULL);
+    pool->bounds[b] = pool->objectives[b];
+    return 0;
+  }
+  measure_t now;
+  measure_now(&now);
+  // Small blocks are solved exactly, the models only when it runs out
+  if (block->number_of_jobs <= pool->exact) {
+    solution_t *solution =
+        dp_solve(block, pool->solver, pool->deadline - now.wall, 1, sequence);
+    if (solution != NULL) {
+      pool->status[b] = solution->status;
+      pool->objectives[b] = solution->objective_value;
+      pool->bounds[b] = solution->bound;
+      free(solution->values);
+      free(solution);
+      return 0;
+    }
+  }
+  // Too large for the memory left even alone: solved as part of the whole
+  double estimate = 0, memory_limit = 0;
+  if (sim->memory != NULL) {
+    estimate = memory_estimate(sim->memory, block, pool->solver);
+    if (blocks_admit(sim, pool, estimate, &memory_limit) != 0) {
+      pool->status[b] = STATUS_MEM_LIMIT;
+      return 0;
+    }
+  }
+  measure_now(&now);
+  double limit = pool->deadline - now.wall;
+  if (limit <= 0) {
+    pool->status[b] = STATUS_TIME_LIMIT;
+    blocks_release(sim, pool, memory_limit);
+    return 0;
+  }
+
+  int heuristic_value = -1;
+  if ((result = model_init(sim, b, pool->solver, &heuristic_value)) != 0) {
+    if (block->model != NULL)
+      backend->model_free(block->model);
+    block->model = NULL;
+    blocks_release(sim, pool, memory_limit);
+    return result;
+  }
+  if ((result = backend->set_dbl_param(block->model, PARAM_TIME_LIMIT,
+                                       limit)) != 0 ||
+      (pool->threads > 0 &&
+       (result = backend->set_int_param(block->model, PARAM_THREADS,
+                                        pool->threads)) != 0) ||
+      (sim->memory != NULL &&
+       (result = backend->set_dbl_param(block->model, PARAM_MEM_LIMIT,
+                                        memory_limit)) != 0))
+    log_error(sim, result, "set_param");
+
+  solution_t *solution = model_optimize(sim, b, pool->solver);
+  if (solution == NULL) {
+    result = -1;
+  } else {
+    pool->status[b] = solution->status;
+    if (solution->bound >= 0)
+      pool->bounds[b] = ceil(solution->bound - 1e-6);
+    if (solution->objective_value >= 0 &&
+        model_sequence(sim, block, pool->solver, sequence) == 0)
+      pool->objectives[b] = evaluate(block, sequence, NULL);
+    free(solution->values);
+    free(solution);
+  }
+  if (backend->model_free(block->model) != 0)
+    result = -1;
+  block->model = NULL;
+  blocks_release(sim, pool, memory_limit);
+  return result;
+}
+
+int blocks_admit(simulation_t *sim, pool_t *pool, double gb, double *limit) {
+  // Waits for the models of the other workers as long as there are some
+  pthread_mutex_lock(&pool->lock);
+  int result = 0;
+  while ((result = memory_acquire(sim->memory, gb, limit)) != 0 &&
+         pool->active > 0) {
+    pthread_cond_wait(&pool->released, &pool->lock);
+  }
+  if (result == 0)
+    pool->active += 1;
+  pthread_mutex_unlock(&pool->lock);
+  return result;
+}
+
+void blocks_release(simulation_t *sim, pool_t *pool, double gb) {
+  if (sim->memory == NULL)
+    return;
+  pthread_mutex_lock(&pool->lock);
+  memory_release(sim->memory, gb);
+  pool->active -= 1;
+  pthread_cond_broadcast(&pool->released);
+  pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define BLOCK_MIN_JOBS 2 // Blocks of one job are scheduled at their r_j
+
+// Jobs between two idle times of the earliest release date schedule: jobs of
+// other blocks only delay each other when a block ends up longer than in it.
+// A block starts at time 0: its release dates are shifted by the first one,
+// so that time indexed models do not span the horizon before it
+typedef struct {
+  vector_t *instances; // One sub-instance by block
+  int **jobs;          // jobs[b][k]: job of the instance that is job k of b
+  int *offsets;        // offsets[b]: subtracted from the release dates of b
+} blocks_t;
+
+// Blocks of `instance`, a single one when the machine never idles
+blocks_t *blocks_split(instance_t *instance);
+void blocks_free(blocks_t *blocks);
+// Solve every block with `solver` on `workers` threads within `limit`
+// seconds, the blocks of at most `exact` jobs by dynamic programming (dp.h),
+// and stitch the block sequences into `sequence`. The sum of the block
+// bounds bounds the instance, the solution is optimal when every block is
+// and the stitched blocks do not overlap
+solution_t *blocks_solve(simulation_t *sim, instance_t *instance,
+                         blocks_t *blocks, solver_t solver, double limit,
+                         int workers, int exact, int *sequence);
+// Workers available to `blocks_solve` (online processors)
+int blocks_workers(void);
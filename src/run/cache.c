@@ -0,0 +1,289 @@
+#include "cache.h"
+#include "../utils/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+char *cache_filename(const char *folder, unsigned long long hash);
+int cache_read(const char *filename, instance_t *instance,
+               cache_entry_t *entry);
+unsigned long long cache_mix(unsigned long long hash, int value);
+int cache_lock(const char *filename);
+void cache_unlock(int lock);
+FILE *cache_temporary(const char *filename, char **temporary);
+
+unsigned long long cache_hash(instance_t *instance) {
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return 0;
+  unsigned long long hash = cache_mix(FNV_OFFSET, instance->number_of_jobs);
+  for (size_t k = 0; k < instance->number_of_jobs; k++) {
+    int j = orders->by_release[k];
+    hash = cache_mix(hash, instance->release_dates[j]);
+    hash = cache_mix(hash, instance->processing_times[j]);
+  }
+  return hash;
+}
+
+int cache_get(const char *folder, instance_t *instance, cache_entry_t *entry) {
+  entry->objective = -1;
+  entry->bound = -1;
+  entry->proven = 0;
+  entry->sequence = NULL;
+  char *filename = cache_filename(folder, cache_hash(instance));
+  if (filename == NULL)
+    return -1;
+  int result = cache_read(filename, instance, entry);
+  free(filename);
+  filename = NULL;
+  return result;
+}
+
+int cache_put(const char *folder, instance_t *instance,
+              const cache_entry_t *entry) {
+  int result = 0;
+  int n = instance->number_of_jobs;
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return -1;
+  unsigned long long hash = cache_hash(instance);
+  char *filename = cache_filename(folder, hash);
+  if (filename == NULL)
+    return -1;
+  // Shards and workers merging the same entry wait for each other, none of
+  // their updates is lost
+  int lock = cache_lock(filename);
+  if (lock < 0) {
+    free(filename);
+    return -1;
+  }
+
+  cache_entry_t merged;
+  if (cache_read(filename, instance, &merged) < 0) {
+    cache_unlock(lock);
+    free(filename);
+    return -1;
+  }
+  if (entry->sequence != NULL &&
+      (merged.objective < 0 || entry->objective < merged.objective)) {
+    free(merged.sequence);
+    merged.sequence = malloc(sizeof(*merged.sequence) * n);
+    if (merged.sequence == NULL) {
+      perror("Could not allocate memory for cached sequence");
+      cache_unlock(lock);
+      free(filename);
+      return -1;
+    }
+    memcpy(merged.sequence, entry->sequence, sizeof(*merged.sequence) * n);
+    merged.objective = entry->objective;
+  }
+  if (entry->bound > merged.bound)
+    merged.bound = entry->bound;
+  merged.proven = merged.proven || entry->proven ||
+                  (merged.objective >= 0 && merged.bound >= merged.objective);
+
+  // Written aside then renamed, readers never see half an entry
+  char *temporary = NULL;
+  FILE *fp = cache_temporary(filename, &temporary);
+  if (fp == NULL) {
+    perror_formatted("Could not open %s", filename);
+    cache_unlock(lock);
+    free(temporary);
+    free(filename);
+    cache_entry_free(&merged);
+    return -1;
+  }
+  fprintf(fp, "%d %d\n", CACHE_VERSION, n);
+  // Canonical jobs, checked on read against hash collisions
+  for (size_t k = 0; k < n; k++) {
+    int j = orders->by_release[k];
+    fprintf(fp, "%d %d\n", instance->release_dates[j],
+            instance->processing_times[j]);
+  }
+  fprintf(fp, "%lld %lld %d\n", merged.objective, merged.bound, merged.proven);
+  if (merged.sequence != NULL) {
+    // Canonical position of every job of the sequence
+    int *canonical = malloc(sizeof(*canonical) * n);
+    if (canonical == NULL) {
+      perror("Could not allocate memory for canonical positions");
+      result = -1;
+    } else {
+      for (size_t k = 0; k < n; k++) {
+        canonical[orders->by_release[k]] = k;
+      }
+      for (size_t h = 0; h < n; h++) {
+        fprintf(fp, h + 1 < n ? "%d " : "%d\n", canonical[merged.sequence[h]]);
+      }
+      free(canonical);
+    }
+  }
+  if (fclose(fp) != 0) {
+    perror_formatted("Could not write %s", temporary);
+    result = -1;
+  }
+  if (result == 0 && rename(temporary, filename) != 0) {
+    perror_formatted("Could not rename %s", temporary);
+    result = -1;
+  }
+  if (result != 0)
+    remove(temporary);
+  cache_unlock(lock);
+
+  free(temporary);
+  temporary = NULL;
+  free(filename);
+  filename = NULL;
+  cache_entry_free(&merged);
+  return result;
+}
+
+void cache_entry_free(cache_entry_t *entry) {
+  free(entry->sequence);
+  entry->sequence = NULL;
+}
+
+char *cache_filename(const char *folder, unsigned long long hash) {
+  if (create_folder(folder) != 0) {
+    perror_formatted("Could not create folder %s", folder);
+    return NULL;
+  }
+  return formatted_string("%s/%016llx", folder, hash);
+}
+
+int cache_read(const char *filename, instance_t *instance,
+               cache_entry_t *entry) {
+  int n = instance->number_of_jobs;
+  const orders_t *orders = instance_orders(instance);
+  entry->objective = -1;
+  entry->bound = -1;
+  entry->proven = 0;
+  entry->sequence = NULL;
+  if (orders == NULL)
+    return -1;
+  FILE *fp = fopen(filename, "r");
+  if (fp == NULL)
+    return 1;
+
+  int version = 0, number_of_jobs = 0;
+  int same = fscanf(fp, "%d %d", &version, &number_of_jobs) == 2 &&
+             version == CACHE_VERSION && number_of_jobs == n;
+  for (size_t k = 0; k < n && same; k++) {
+    int j = orders->by_release[k];
+    int r_j = 0, p_j = 0;
+    same = fscanf(fp, "%d %d", &r_j, &p_j) == 2 &&
+           r_j == instance->release_dates[j] &&
+           p_j == instance->processing_times[j];
+  }
+  // Other version or hash collision: treated as missing
+  if (!same || fscanf(fp, "%lld %lld %d", &entry->objective, &entry->bound,
+                      &entry->proven) != 3) {
+    fclose(fp);
+    entry->objective = -1;
+    entry->bound = -1;
+    entry->proven = 0;
+    return 1;
+  }
+
+  if (entry->objective >= 0) {
+    entry->sequence = malloc(sizeof(*entry->sequence) * n);
+    int *seen = calloc(n, sizeof(*seen));
+    if (entry->sequence == NULL || seen == NULL) {
+      perror("Could not allocate memory for cached sequence");
+      cache_entry_free(entry);
+      free(seen);
+      fclose(fp);
+      return -1;
+    }
+    int valid = 1;
+    for (size_t h = 0; h < n && valid; h++) {
+      int k = 0;
+      valid = fscanf(fp, "%d", &k) == 1 && k >= 0 && k < n && !seen[k];
+      if (valid) {
+        seen[k] = 1;
+        entry->sequence[h] = orders->by_release[k];
+      }
+    }
+    free(seen);
+    // Not a permutation of the jobs: the whole entry is corrupted
+    if (!valid) {
+      cache_entry_free(entry);
+      entry->objective = -1;
+      entry->bound = -1;
+      entry->proven = 0;
+      fclose(fp);
+      return 1;
+    }
+  }
+  fclose(fp);
+  return 0;
+}
+
+unsigned long long cache_mix(unsigned long long hash, int value) {
+  for (size_t b = 0; b < sizeof(value); b++) {
+    hash ^= (value >> (8 * b)) & 0xff;
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+int cache_lock(const char *filename) {
+#ifndef _WIN32
+  // Entries are replaced by renames, the lock lives in a file of its own
+  char *path = formatted_string("%s.lock", filename);
+  int lock = path != NULL ? open(path, O_RDWR | O_CREAT, 0644) : -1;
+  if (lock < 0) {
+    perror_formatted("Could not open lock of %s", filename);
+    free(path);
+    return -1;
+  }
+  free(path);
+  while (flock(lock, LOCK_EX) != 0) {
+    if (errno != EINTR) {
+      perror_formatted("Could not lock %s", filename);
+      close(lock);
+      return -1;
+    }
+  }
+  return lock;
+#else
+  return 0;
+#endif
+}
+
+void cache_unlock(int lock) {
+#ifndef _WIN32
+  // Closing the descriptor releases the lock
+  close(lock);
+#endif
+}
+
+FILE *cache_temporary(const char *filename, char **temporary) {
+#ifndef _WIN32
+  // A name of its own for every writer, threads of a process included
+  *temporary = formatted_string("%s.XXXXXX", filename);
+  int fd = *temporary != NULL ? mkstemp(*temporary) : -1;
+  if (fd < 0)
+    return NULL;
+  fchmod(fd, 0644);
+  FILE *fp = fdopen(fd, "w");
+  if (fp == NULL) {
+    close(fd);
+    remove(*temporary);
+  }
+  return fp;
+#else
+  *temporary = formatted_string("%s.tmp", filename);
+  return *temporary != NULL ? fopen(*temporary, "w") : NULL;
+#endif
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define CACHE_FOLDER "output/cache"
+#define CACHE_VERSION 1
+#define STATUS_CACHED 100 // Proven optimal by a previous run, not solved
+
+// What is known about an instance, shared by every instance with the same
+// multiset of (r_j, p_j) pairs whatever the order of its jobs
+typedef struct {
+  long long objective; // Best known sum C_j, -1 if none
+  long long bound;     // Best known lower bound, -1 if none
+  int proven;          // `objective` is optimal
+  int *sequence;       // Best known sequence (jobs of the instance) or NULL
+} cache_entry_t;
+
+// FNV-1a of the jobs sorted by (r_j, p_j)
+unsigned long long cache_hash(instance_t *instance);
+// Entry of `instance` in `folder`: 0 when found, 1 when missing
+int cache_get(const char *folder, instance_t *instance, cache_entry_t *entry);
+// Merge `entry` with the cached one (best sequence, best bound) and save it
+int cache_put(const char *folder, instance_t *instance,
+              const cache_entry_t *entry);
+void cache_entry_free(cache_entry_t *entry);
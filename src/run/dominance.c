@@ -0,0 +1,132 @@
+#include "dominance.h"
+#include "../utils/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int dominance_rule(const instance_t *instance, int i, int j);
+
+dominance_t *dominance_init(instance_t *instance) {
+  int n = instance->number_of_jobs;
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return NULL;
+  dominance_t *dominance = malloc(sizeof(*dominance));
+  if (dominance == NULL) {
+    perror("Could not allocate memory for dominance");
+    return NULL;
+  }
+  dominance->n = n;
+  dominance->words = (n + 63) / 64;
+  size_t rows = (size_t)n * dominance->words;
+  dominance->after = calloc(rows > 0 ? rows : 1, sizeof(*dominance->after));
+  dominance->predecessors = calloc(n > 0 ? n : 1, sizeof(int));
+  dominance->successors = calloc(n > 0 ? n : 1, sizeof(int));
+  dominance->heads = calloc(n > 0 ? n : 1, sizeof(int));
+  dominance->tails = calloc(n > 0 ? n : 1, sizeof(int));
+  if (dominance->after == NULL || dominance->predecessors == NULL ||
+      dominance->successors == NULL || dominance->heads == NULL ||
+      dominance->tails == NULL) {
+    perror("Could not allocate memory for dominance");
+    dominance_free(dominance);
+    return NULL;
+  }
+
+  // The rule only orders jobs released earlier (or tied, by index) first:
+  // later rows are complete when an earlier one takes them in
+  const int *order = orders->by_release;
+  for (int k = n - 1; k >= 0; k--) {
+    int i = order[k];
+    uint64_t *row = dominance->after + (size_t)i * dominance->words;
+    for (size_t m = k + 1; m < n; m++) {
+      int j = order[m];
+      if (dominance_before(dominance, i, j) || !dominance_rule(instance, i, j))
+        continue;
+      const uint64_t *followers =
+          dominance->after + (size_t)j * dominance->words;
+      row[j / 64] |= 1ULL << (j % 64);
+      for (size_t w = 0; w < dominance->words; w++) {
+        row[w] |= followers[w];
+      }
+    }
+  }
+
+  for (size_t k = 0; k < n; k++) {
+    int j = order[k];
+    int min_r = instance->release_dates[j], sum_p = 0;
+    dominance->heads[j] = instance->release_dates[j];
+    for (size_t m = 0; m < n; m++) {
+      int i = order[m];
+      if (dominance_before(dominance, i, j)) {
+        // Predecessors come first in the order: their heads are final
+        int head = dominance->heads[i] + instance->processing_times[i];
+        if (head > dominance->heads[j])
+          dominance->heads[j] = head;
+        if (instance->release_dates[i] < min_r)
+          min_r = instance->release_dates[i];
+        sum_p += instance->processing_times[i];
+        dominance->predecessors[j] += 1;
+      } else if (dominance_before(dominance, j, i)) {
+        dominance->tails[j] += instance->processing_times[i];
+        dominance->successors[j] += 1;
+      }
+    }
+    // Every predecessor is done before j starts
+    if (min_r + sum_p > dominance->heads[j])
+      dominance->heads[j] = min_r + sum_p;
+  }
+  return dominance;
+}
+
+void dominance_free(dominance_t *dominance) {
+  if (dominance == NULL)
+    return;
+  free(dominance->after);
+  free(dominance->predecessors);
+  free(dominance->successors);
+  free(dominance->heads);
+  free(dominance->tails);
+  free(dominance);
+}
+
+int dominance_before(const dominance_t *dominance, int i, int j) {
+  const uint64_t *row = dominance->after + (size_t)i * dominance->words;
+  return (row[j / 64] >> (j % 64)) & 1;
+}
+
+int dominance_repair(instance_t *instance, int *sequence) {
+  int n = instance->number_of_jobs;
+  const orders_t *orders = instance_orders(instance);
+  int *first = malloc(sizeof(*first) * n);
+  int *cursor = malloc(sizeof(*cursor) * n);
+  if (orders == NULL || first == NULL || cursor == NULL) {
+    perror("Could not allocate memory for dominance repair");
+    free(first);
+    free(cursor);
+    return -1;
+  }
+  // Jobs of equal p_j are contiguous by release date in `by_processing`:
+  // the positions a class takes in `sequence` are refilled in that order
+  const int *by_processing = orders->by_processing;
+  for (size_t k = 0; k < n; k++) {
+    int j = by_processing[k];
+    int i = k > 0 ? by_processing[k - 1] : -1;
+    first[j] = i >= 0 && instance->processing_times[i] ==
+                             instance->processing_times[j]
+                   ? first[i]
+                   : k;
+    cursor[k] = k;
+  }
+  for (size_t h = 0; h < n; h++) {
+    sequence[h] = by_processing[cursor[first[sequence[h]]]++];
+  }
+  free(first);
+  free(cursor);
+  return 0;
+}
+
+int dominance_rule(const instance_t *instance, int i, int j) {
+  if (instance->processing_times[i] != instance->processing_times[j])
+    return 0;
+  return instance->release_dates[i] < instance->release_dates[j] ||
+         (instance->release_dates[i] == instance->release_dates[j] && i < j);
+}
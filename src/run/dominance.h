@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../utils/entities.h"
+#include <stdint.h>
+
+// Orderings provable before solving: some optimal schedule processes job i
+// before job j for every pair of the (transitive) relation at once
+typedef struct {
+  int n;
+  int words;         // 64 bit words of every row
+  uint64_t *after;   // Row i: jobs following i
+  int *predecessors; // Number of jobs preceding j
+  int *successors;   // Number of jobs following j
+  int *heads;        // Earliest start of j after its predecessors
+  int *tails;        // Processing time of the jobs following j
+} dominance_t;
+
+// Equal processing times go by release date (ties by index): exchanging two
+// such jobs never delays the others. r_i <= r_j and p_i <= p_j alone is not
+// enough, a shorter job can still fill the idle time before a release
+dominance_t *dominance_init(instance_t *instance);
+void dominance_free(dominance_t *dominance);
+int dominance_before(const dominance_t *dominance, int i, int j);
+// Reorder `sequence` to respect every ordering, sum C_j never increases
+int dominance_repair(instance_t *instance, int *sequence);
@@ -0,0 +1,430 @@
+#include "dp.h"
+#include "../utils/evaluate.h"
+#include "../utils/utils.h"
+#include "backend/backend.h"
+#include "dominance.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  long long cost; // Sum C_j of the set
+  int makespan;
+  int parent; // 32 * state of the set without the last job + the last job
+} dp_state_t;
+
+// Fronts of the sets of k jobs, sets ranked in colexicographic order (the
+// order of their masks): front of rank s in states[offsets[s], offsets[s+1])
+typedef struct {
+  long sets;
+  int *offsets;
+  dp_state_t *states;
+} dp_layer_t;
+
+typedef struct {
+  const instance_t *instance;
+  int n;
+  long binomial[DP_JOBS_LIMIT + 1][DP_JOBS_LIMIT + 1];
+  uint32_t *before;         // Jobs every job must follow (dominance.h)
+  const int *by_processing; // Shortest first, for the lower bounds
+  long long upper;          // Sum C_j of the best heuristic schedule
+  uint64_t *alive;          // Bit of every set with a non empty front
+  dp_layer_t *layers;
+} dp_t;
+
+// Sets of ranks [first, last) of a layer computed by one thread, the fronts
+// in its own buffers until the layer is joined
+typedef struct {
+  dp_t *dp;
+  int layer;
+  long first, last;
+  dp_state_t *states;
+  long length, capacity;
+  dp_state_t *candidates;
+  long candidates_capacity;
+  int result;
+} dp_worker_t;
+
+long dp_rank(const dp_t *dp, uint32_t set);
+uint32_t dp_unrank(const dp_t *dp, long rank, int k);
+uint32_t dp_next(uint32_t set);
+void *dp_worker(void *data);
+int dp_front(dp_worker_t *worker, uint32_t set, long rank);
+long long dp_lower(const dp_t *dp, uint32_t left, int makespan);
+int dp_compare(const void *a, const void *b);
+int dp_reserve(dp_state_t **states, long *capacity, long length);
+int dp_layer(dp_t *dp, int k, dp_worker_t *workers, int threads);
+
+solution_t *dp_solve(instance_t *instance, solver_t solver, double limit,
+                     int workers, int *sequence) {
+  int n = instance->number_of_jobs;
+  if (n < 1 || n > DP_JOBS_LIMIT)
+    return NULL;
+  measure_t start, now;
+  measure_now(&start);
+  const orders_t *orders = instance_orders(instance);
+  dominance_t *dominance = dominance_init(instance);
+  if (orders == NULL || dominance == NULL) {
+    dominance_free(dominance);
+    return NULL;
+  }
+
+  dp_t dp = {.instance = instance,
+             .n = n,
+             .by_processing = orders->by_processing};
+  for (int i = 0; i <= n; i++) {
+    dp.binomial[i][0] = 1;
+    for (int k = 1; k <= i; k++) {
+      dp.binomial[i][k] = dp.binomial[i - 1][k - 1] + dp.binomial[i - 1][k];
+    }
+  }
+  dp.before = calloc(n, sizeof(*dp.before));
+  dp.layers = calloc(n + 1, sizeof(*dp.layers));
+  dp.alive = calloc(((1ul << n) + 63) / 64, sizeof(*dp.alive));
+  if (workers < 1)
+    workers = 1;
+  dp_worker_t *dp_workers = calloc(workers, sizeof(*dp_workers));
+  if (dp.before == NULL || dp.layers == NULL || dp.alive == NULL ||
+      dp_workers == NULL) {
+    perror("Could not allocate memory for dynamic programming");
+    free(dp.before);
+    free(dp.layers);
+    free(dp.alive);
+    free(dp_workers);
+    dominance_free(dominance);
+    return NULL;
+  }
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      if (dominance_before(dominance, i, j))
+        dp.before[j] |= 1u << i;
+    }
+  }
+  dominance_free(dominance);
+  dominance = NULL;
+  // Every state above the best of the simple orders is dropped
+  dp.upper = evaluate(instance, orders->by_release, NULL);
+  long long value = evaluate(instance, orders->by_processing, NULL);
+  if (value < dp.upper)
+    dp.upper = value;
+  value = evaluate(instance, orders->by_completion, NULL);
+  if (value < dp.upper)
+    dp.upper = value;
+
+  int result = 0;
+  long states = 1;
+  dp_layer_t *empty = &dp.layers[0];
+  empty->sets = 1;
+  empty->offsets = malloc(sizeof(*empty->offsets) * 2);
+  empty->states = malloc(sizeof(*empty->states));
+  if (empty->offsets == NULL || empty->states == NULL) {
+    perror("Could not allocate memory for dynamic programming");
+    result = -1;
+  } else {
+    empty->offsets[0] = 0;
+    empty->offsets[1] = 1;
+    empty->states[0] = (dp_state_t){.cost = 0, .makespan = 0, .parent = -1};
+    dp.alive[0] = 1;
+  }
+  for (int k = 1; k <= n && result == 0; k++) {
+    if ((result = dp_layer(&dp, k, dp_workers, workers)) != 0)
+      break;
+    states += dp.layers[k].offsets[dp.layers[k].sets];
+    measure_now(&now);
+    if (states > DP_MAX_STATES || now.wall - start.wall > limit)
+      result = 1;
+  }
+
+  solution_t *solution = NULL;
+  // Front of the whole set by decreasing cost: the last state is optimal
+  long length = result == 0 ? dp.layers[n].offsets[1] : 0;
+  if (length > 0) {
+    solution = malloc(sizeof(*solution));
+    double *values = malloc(sizeof(*values) * n);
+    int *c_hs = malloc(sizeof(*c_hs) * n);
+    if (solution == NULL || values == NULL || c_hs == NULL) {
+      perror("Could not allocate memory for dynamic programming solution");
+      free(solution);
+      free(values);
+      free(c_hs);
+      solution = NULL;
+    } else {
+      uint32_t set = (1u << n) - 1;
+      const dp_state_t *state = &dp.layers[n].states[length - 1];
+      for (int k = n; k > 0; k--) {
+        int job = state->parent % 32;
+        sequence[k - 1] = job;
+        set &= ~(1u << job);
+        const dp_layer_t *layer = &dp.layers[k - 1];
+        state = &layer->states[layer->offsets[dp_rank(&dp, set)] +
+                               state->parent / 32];
+      }
+      long long objective = evaluate(instance, sequence, c_hs);
+      for (size_t h = 0; h < n; h++) {
+        values[sequence[h]] = c_hs[h];
+      }
+      free(c_hs);
+      measure_now(&now);
+      memset(solution, 0, sizeof(*solution));
+      solution->size = n;
+      solution->solver = solver;
+      solution->status = STATUS_OPTIMAL;
+      solution->runtime = now.wall - start.wall;
+      solution->objective_value = objective;
+      solution->bound = objective;
+      solution->gap = 0;
+      solution->values = values;
+      solution->heuristic_value = -1;
+      solution->memory = -1;
+    }
+  }
+
+  for (int k = 0; k <= n; k++) {
+    free(dp.layers[k].offsets);
+    free(dp.layers[k].states);
+  }
+  for (int w = 0; w < workers; w++) {
+    free(dp_workers[w].states);
+    free(dp_workers[w].candidates);
+  }
+  free(dp_workers);
+  free(dp.layers);
+  free(dp.alive);
+  free(dp.before);
+  return solution;
+}
+
+int dp_layer(dp_t *dp, int k, dp_worker_t *workers, int threads) {
+  dp_layer_t *layer = &dp->layers[k];
+  layer->sets = dp->binomial[dp->n][k];
+  layer->offsets = malloc(sizeof(*layer->offsets) * (layer->sets + 1));
+  if (layer->offsets == NULL) {
+    perror("Could not allocate memory for dynamic programming layer");
+    return -1;
+  }
+  if (layer->sets < DP_PARALLEL_SETS)
+    threads = 1;
+  else if (threads > layer->sets / DP_PARALLEL_SETS)
+    threads = layer->sets / DP_PARALLEL_SETS;
+
+  // Thread 0 is this one, fronts are written to `offsets` as their sizes
+  pthread_t *ids = malloc(sizeof(*ids) * threads);
+  if (ids == NULL) {
+    perror("Could not allocate memory for dynamic programming threads");
+    return -1;
+  }
+  int started = 0;
+  for (int w = 0; w < threads; w++) {
+    dp_worker_t *worker = &workers[w];
+    worker->dp = dp;
+    worker->layer = k;
+    worker->first = layer->sets * w / threads;
+    worker->last = layer->sets * (w + 1) / threads;
+    worker->length = 0;
+    worker->result = 0;
+  }
+  for (int w = 1; w < threads; w++) {
+    if (pthread_create(&ids[w], NULL, dp_worker, &workers[w]) != 0)
+      break;
+    started += 1;
+  }
+  // Ranges of the threads that could not start are computed here
+  for (int w = 0; w < threads; w++) {
+    if (w == 0 || w > started)
+      dp_worker(&workers[w]);
+  }
+  int result = 0;
+  for (int w = 1; w <= started; w++) {
+    pthread_join(ids[w], NULL);
+  }
+  free(ids);
+  long length = 0;
+  for (int w = 0; w < threads; w++) {
+    if (workers[w].result != 0)
+      result = workers[w].result;
+    length += workers[w].length;
+  }
+  if (result != 0)
+    return result;
+
+  layer->states = malloc(sizeof(*layer->states) * (length > 0 ? length : 1));
+  if (layer->states == NULL) {
+    perror("Could not allocate memory for dynamic programming layer");
+    return -1;
+  }
+  // Sizes to offsets, marking the sets the next layer can extend
+  int offset = 0;
+  uint32_t set = (1u << k) - 1;
+  for (long s = 0; s < layer->sets; s++) {
+    int size = layer->offsets[s + 1];
+    layer->offsets[s] = offset;
+    offset += size;
+    if (size > 0)
+      dp->alive[set / 64] |= 1ull << (set % 64);
+    set = dp_next(set);
+  }
+  layer->offsets[layer->sets] = offset;
+  // Ranges are consecutive: the buffers are the layer in rank order
+  offset = 0;
+  for (int w = 0; w < threads; w++) {
+    memcpy(layer->states + offset, workers[w].states,
+           sizeof(*layer->states) * workers[w].length);
+    offset += workers[w].length;
+  }
+  return 0;
+}
+
+void *dp_worker(void *data) {
+  dp_worker_t *worker = data;
+  const dp_t *dp = worker->dp;
+  uint32_t set = dp_unrank(dp, worker->first, worker->layer);
+  for (long rank = worker->first; rank < worker->last; rank++) {
+    if (dp_front(worker, set, rank) != 0) {
+      worker->result = -1;
+      break;
+    }
+    set = dp_next(set);
+  }
+  return NULL;
+}
+
+int dp_front(dp_worker_t *worker, uint32_t set, long rank) {
+  const dp_t *dp = worker->dp;
+  const instance_t *instance = dp->instance;
+  const dp_layer_t *previous = &dp->layers[worker->layer - 1];
+  uint32_t left = ((1u << dp->n) - 1) & ~set;
+  long candidates = 0;
+
+  for (uint32_t jobs = set; jobs != 0; jobs &= jobs - 1) {
+    int j = __builtin_ctz(jobs);
+    uint32_t rest = set & ~(1u << j);
+    // Some job that must precede j is not in the set yet
+    if ((dp->before[j] & ~rest) != 0 ||
+        (dp->alive[rest / 64] & (1ull << (rest % 64))) == 0)
+      continue;
+    const int *offsets = previous->offsets + dp_rank(dp, rest);
+    long first = offsets[0], last = offsets[1];
+    if (dp_reserve(&worker->candidates, &worker->candidates_capacity,
+                   candidates + last - first) != 0)
+      return -1;
+    int r_j = instance->release_dates[j], p_j = instance->processing_times[j];
+    for (long s = first; s < last; s++) {
+      const dp_state_t *state = &previous->states[s];
+      // Idle time before r_j another available job fits in: not extended
+      int idle = 0;
+      for (uint32_t others = r_j > state->makespan ? left : 0;
+           others != 0 && !idle; others &= others - 1) {
+        int i = __builtin_ctz(others);
+        int start = instance->release_dates[i] > state->makespan
+                        ? instance->release_dates[i]
+                        : state->makespan;
+        idle = (dp->before[i] & ~rest) == 0 &&
+               start + instance->processing_times[i] <= r_j;
+      }
+      if (idle)
+        continue;
+      int makespan = (r_j > state->makespan ? r_j : state->makespan) + p_j;
+      worker->candidates[candidates++] =
+          (dp_state_t){.cost = state->cost + makespan,
+                       .makespan = makespan,
+                       .parent = (int)(s - first) * 32 + j};
+    }
+  }
+
+  // Pareto front: increasing makespan, decreasing cost
+  if (candidates > 1)
+    qsort(worker->candidates, candidates, sizeof(*worker->candidates),
+          dp_compare);
+  if (dp_reserve(&worker->states, &worker->capacity,
+                 worker->length + candidates) != 0)
+    return -1;
+  if (worker->length + candidates > DP_MAX_STATES)
+    return -1;
+  long size = 0;
+  long long best = -1;
+  for (long c = 0; c < candidates; c++) {
+    const dp_state_t *candidate = &worker->candidates[c];
+    if (best >= 0 && candidate->cost >= best)
+      continue;
+    best = candidate->cost;
+    if (candidate->cost + dp_lower(dp, left, candidate->makespan) > dp->upper)
+      continue;
+    worker->states[worker->length + size++] = *candidate;
+  }
+  worker->length += size;
+  // Size of the front until the layer is joined
+  dp->layers[worker->layer].offsets[rank + 1] = size;
+  return 0;
+}
+
+long long dp_lower(const dp_t *dp, uint32_t left, int makespan) {
+  // Every job ends after its own release, and no earlier than in SPT order
+  // from the makespan without release dates
+  const instance_t *instance = dp->instance;
+  long long released = 0, spt = 0, elapsed = makespan;
+  for (int k = 0; k < dp->n; k++) {
+    int j = dp->by_processing[k];
+    if ((left & (1u << j)) == 0)
+      continue;
+    int r_j = instance->release_dates[j];
+    released +=
+        (r_j > makespan ? r_j : makespan) + instance->processing_times[j];
+    elapsed += instance->processing_times[j];
+    spt += elapsed;
+  }
+  return released > spt ? released : spt;
+}
+
+long dp_rank(const dp_t *dp, uint32_t set) {
+  long rank = 0;
+  for (int m = 1; set != 0; m++, set &= set - 1) {
+    rank += dp->binomial[__builtin_ctz(set)][m];
+  }
+  return rank;
+}
+
+uint32_t dp_unrank(const dp_t *dp, long rank, int k) {
+  uint32_t set = 0;
+  for (int m = k, i = dp->n - 1; m > 0; m--) {
+    while (dp->binomial[i][m] > rank) {
+      i -= 1;
+    }
+    set |= 1u << i;
+    rank -= dp->binomial[i][m];
+    i -= 1;
+  }
+  return set;
+}
+
+uint32_t dp_next(uint32_t set) {
+  // Gosper's hack: next larger mask with as many jobs, the next rank
+  uint32_t lowest = set & -set;
+  uint32_t ripple = set + lowest;
+  return ripple | (((set ^ ripple) >> 2) / lowest);
+}
+
+int dp_compare(const void *a, const void *b) {
+  const dp_state_t *x = a, *y = b;
+  if (x->makespan != y->makespan)
+    return x->makespan < y->makespan ? -1 : 1;
+  return (x->cost > y->cost) - (x->cost < y->cost);
+}
+
+int dp_reserve(dp_state_t **states, long *capacity, long length) {
+  if (length <= *capacity)
+    return 0;
+  long size = *capacity > 0 ? *capacity : VECTOR_DEFAULT_SIZE;
+  while (size < length) {
+    size *= 2;
+  }
+  dp_state_t *grown = realloc(*states, sizeof(**states) * size);
+  if (grown == NULL) {
+    perror("Could not allocate memory for dynamic programming states");
+    return -1;
+  }
+  *states = grown;
+  *capacity = size;
+  return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define DP_MAX_JOBS 20    // Default size of the instances solved exactly
+#define DP_JOBS_LIMIT 25  // 2^n sets, 128 MB of offsets at the limit
+#define DP_MAX_STATES (1 << 24) // States of every layer together, 16 B each
+#define DP_PARALLEL_SETS 4096   // Smaller layers are computed by one thread
+#define STATUS_EXACT 103 // A formulation solved by the dynamic program instead
+
+// Exact sum C_j of `instance` by dynamic programming over the sets of jobs
+// scheduled first. Layer k holds, for every set of k jobs, the (makespan,
+// sum C_j) pairs no other order of the set dominates: the jobs left only
+// depend on the makespan. Orders breaking the rules of dominance.h, or
+// leaving idle time another job fits in, are never extended, and states
+// whose lower bound exceeds a heuristic schedule are dropped. The sets of a
+// layer are split between `workers` threads. `sequence` gets the schedule,
+// NULL when the instance is too large, runs out of states or `limit` seconds
+solution_t *dp_solve(instance_t *instance, solver_t solver, double limit,
+                     int workers, int *sequence);
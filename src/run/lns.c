@@ -0,0 +1,330 @@
+#include "lns.h"
+#include "../utils/arena.h"
+#include "../utils/evaluate.h"
+#include "../utils/utils.h"
+#include "backend/backend.h"
+#include "block.h"
+#include "dominance.h"
+#include "model/model.h"
+#include "run.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LNS_MODULUS 2147483647 // Lehmer generator of every worker
+#define LNS_MULTIPLIER 48271
+#define LNS_MIN_MOVE 0.05 // Seconds, shorter sub-MIPs are not started
+
+// Best schedule shared by the workers
+typedef struct {
+  double deadline;      // Wall clock when the search stops
+  int threads;          // Backend threads of every sub-MIP, 0: default
+  pthread_mutex_t lock; // Guards everything below
+  int *best;
+  long long value; // Sum C_j of `best`
+  long moves;      // Moves started
+  int stall;       // Moves finished since the last improvement
+} lns_pool_t;
+
+typedef struct {
+  lns_pool_t *pool;
+  simulation_t sim; // Own backend environment, a copy of the instance (own
+                    // model, same jobs) as instance 0
+  long random;      // State of the generator
+  int result;
+} lns_worker_t;
+
+void *lns_worker(void *data);
+int lns_move(lns_worker_t *worker, long move, const int *current,
+             long long value, int *candidate);
+void lns_neighbourhood(lns_worker_t *worker, long move, const int *current,
+                       char *free_jobs, int *scratch);
+int lns_random(lns_worker_t *worker, int bound);
+
+solution_t *lns_solve(simulation_t *sim, instance_t *instance,
+                      solver_t solver, double limit, int workers,
+                      const int *start, int *sequence) {
+  int n = instance->number_of_jobs;
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return NULL;
+  measure_t begin, end;
+  measure_now(&begin);
+  if (workers < 1)
+    workers = 1;
+
+  lns_pool_t pool = {.deadline = begin.wall + limit,
+                     .threads = 0,
+                     .value = -1,
+                     .moves = 0,
+                     .stall = 0};
+  pool.best = malloc(sizeof(*pool.best) * n);
+  solution_t *solution = malloc(sizeof(*solution));
+  double *values = malloc(sizeof(*values) * n);
+  int *c_hs = malloc(sizeof(*c_hs) * n);
+  lns_worker_t *pool_workers = calloc(workers, sizeof(*pool_workers));
+  pthread_t *threads = malloc(sizeof(*threads) * workers);
+  int result = pool.best == NULL || solution == NULL || values == NULL ||
+                       c_hs == NULL || pool_workers == NULL || threads == NULL
+                   ? -1
+                   : 0;
+  if (result != 0) {
+    perror("Could not allocate memory for the neighbourhood search");
+  } else if (pthread_mutex_init(&pool.lock, NULL) != 0) {
+    perror("Could not initialize the neighbourhood search lock");
+    result = -1;
+  }
+
+  // Best of the simple orders and the start, agreeing with the dominance
+  // rules the models are built with
+  const int *candidates[4] = {start, orders->by_release, orders->by_processing,
+                              orders->by_completion};
+  for (size_t c = 0; c < 4 && result == 0; c++) {
+    if (candidates[c] == NULL)
+      continue;
+    memcpy(sequence, candidates[c], sizeof(*sequence) * n);
+    if (dominance_repair(instance, sequence) != 0)
+      continue;
+    long long value = evaluate(instance, sequence, NULL);
+    if (pool.value < 0 || value < pool.value) {
+      pool.value = value;
+      memcpy(pool.best, sequence, sizeof(*pool.best) * n);
+    }
+  }
+  if (result == 0 && pool.value < 0) {
+    pthread_mutex_destroy(&pool.lock);
+    result = -1;
+  }
+
+  if (result == 0) {
+    // Worker 0 is this thread with the simulation environment
+    int started = 0;
+    int processors = blocks_workers();
+    if (workers > 1)
+      pool.threads = processors > workers ? processors / workers : 1;
+    for (size_t w = 0; w < workers; w++) {
+      lns_worker_t *worker = &pool_workers[w];
+      worker->pool = &pool;
+      worker->sim = *sim;
+      worker->sim.progress = NULL;
+      worker->random = 1 + w * 7919;
+      instance_t *own = malloc(sizeof(*own));
+      if (own == NULL || (worker->sim.instances = vector_init()) == NULL) {
+        free(own);
+        result = w == 0 ? -1 : 0;
+        break;
+      }
+      *own = *instance;
+      own->orders = NULL;
+      own->model = NULL;
+      if (vector_add(worker->sim.instances, (void **)&own) != 0) {
+        free(own);
+        vector_free(worker->sim.instances);
+        result = w == 0 ? -1 : 0;
+        break;
+      }
+      if (w == 0)
+        continue;
+      if (simulation_worker_init(&worker->sim) != 0) {
+        vector_free(worker->sim.instances);
+        break;
+      }
+      if (pthread_create(&threads[w], NULL, lns_worker, worker) != 0) {
+        simulation_worker_free(&worker->sim);
+        vector_free(worker->sim.instances);
+        break;
+      }
+      started += 1;
+    }
+    // Without worker 0 no other worker was started
+    int prepared = result == 0;
+    if (prepared)
+      lns_worker(&pool_workers[0]);
+    for (size_t w = 1; w <= started; w++) {
+      pthread_join(threads[w], NULL);
+      simulation_worker_free(&pool_workers[w].sim);
+    }
+    for (size_t w = 0; w <= started && prepared; w++) {
+      instance_orders_free(pool_workers[w].sim.instances->values[0]);
+      vector_free(pool_workers[w].sim.instances);
+      if (pool_workers[w].result != 0)
+        result = pool_workers[w].result;
+    }
+    pthread_mutex_destroy(&pool.lock);
+  }
+
+  if (result == 0) {
+    memcpy(sequence, pool.best, sizeof(*sequence) * n);
+    evaluate(instance, sequence, c_hs);
+    for (size_t h = 0; h < n; h++) {
+      values[sequence[h]] = c_hs[h];
+    }
+    measure_now(&end);
+    memset(solution, 0, sizeof(*solution));
+    solution->size = n;
+    solution->solver = solver;
+    solution->status = STATUS_LNS;
+    solution->runtime = end.wall - begin.wall;
+    solution->objective_value = pool.value;
+    solution->bound = -1;
+    solution->gap = -1;
+    solution->values = values;
+    solution->heuristic_value = -1;
+    solution->memory = -1;
+  } else {
+    free(values);
+    free(solution);
+    solution = NULL;
+  }
+  free(pool.best);
+  free(c_hs);
+  free(pool_workers);
+  free(threads);
+  return solution;
+}
+
+void *lns_worker(void *data) {
+  lns_worker_t *worker = data;
+  lns_pool_t *pool = worker->pool;
+  simulation_t *sim = &worker->sim;
+  instance_t *instance = sim->instances->values[0];
+  int n = instance->number_of_jobs;
+  int *current = malloc(sizeof(*current) * n);
+  int *candidate = malloc(sizeof(*candidate) * n);
+  if (current == NULL || candidate == NULL) {
+    perror("Could not allocate memory for the neighbourhood search worker");
+    free(current);
+    free(candidate);
+    worker->result = -1;
+    return NULL;
+  }
+
+  // Built once, every move only changes its bounds and start
+  int heuristic_value = -1;
+  if ((worker->result = model_init(sim, 0, Positional, &heuristic_value)) ==
+          0 &&
+      pool->threads > 0 &&
+      (worker->result = sim->backend->set_int_param(
+           instance->model, PARAM_THREADS, pool->threads)) != 0)
+    log_error(sim, worker->result, "set_int_param(\"Threads\")");
+
+  while (worker->result == 0) {
+    measure_t now;
+    measure_now(&now);
+    pthread_mutex_lock(&pool->lock);
+    int stop = pool->deadline - now.wall < LNS_MIN_MOVE ||
+               pool->stall >= LNS_STALL;
+    long move = pool->moves++;
+    long long value = pool->value;
+    memcpy(current, pool->best, sizeof(*current) * n);
+    pthread_mutex_unlock(&pool->lock);
+    if (stop)
+      break;
+
+    int found = lns_move(worker, move, current, value, candidate);
+    long long candidate_value =
+        found == 0 ? evaluate(instance, candidate, NULL) : -1;
+    pthread_mutex_lock(&pool->lock);
+    // Another worker may have improved the schedule meanwhile
+    if (candidate_value >= 0 && candidate_value < pool->value) {
+      memcpy(pool->best, candidate, sizeof(*pool->best) * n);
+      pool->value = candidate_value;
+      pool->stall = 0;
+    } else {
+      pool->stall += 1;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    if (found < 0)
+      worker->result = -1;
+  }
+
+  if (instance->model != NULL)
+    sim->backend->model_free(instance->model);
+  instance->model = NULL;
+  free(current);
+  free(candidate);
+  return NULL;
+}
+
+int lns_move(lns_worker_t *worker, long move, const int *current,
+             long long value, int *candidate) {
+  int result = 0;
+  simulation_t *sim = &worker->sim;
+  const backend_t *backend = sim->backend;
+  instance_t *instance = sim->instances->values[0];
+  void *model = instance->model;
+  int n = instance->number_of_jobs;
+  // Starts of the previous moves
+  arena_reset(sim->arena);
+  char *free_jobs = arena_alloc(sim->arena, sizeof(*free_jobs) * n);
+  double *lb = arena_alloc(sim->arena, sizeof(*lb) * n * n);
+  if (free_jobs == NULL || lb == NULL)
+    return -1;
+  lns_neighbourhood(worker, move, current, free_jobs, candidate);
+
+  // x_(j h) = 1 for the fixed jobs, the others fill the positions left
+  memset(lb, 0, sizeof(*lb) * n * n);
+  for (size_t h = 0; h < n; h++) {
+    int j = current[h];
+    if (!free_jobs[j])
+      lb[j * n + h] = 1;
+  }
+  measure_t now;
+  measure_now(&now);
+  double limit = worker->pool->deadline - now.wall;
+  if (limit > LNS_SUB_LIMIT)
+    limit = LNS_SUB_LIMIT;
+  if ((result = backend->set_dbl_array(model, ATTR_LB, n, n * n, lb)) != 0 ||
+      (result = model_set_start(sim, instance, Positional, current)) != 0 ||
+      // Only better schedules, the sub-MIP stops as soon as none is left
+      (result = backend->set_dbl_param(model, PARAM_CUTOFF, value - 0.5)) !=
+          0 ||
+      (result = backend->set_dbl_param(model, PARAM_TIME_LIMIT, limit)) !=
+          0 ||
+      (result = backend->optimize(model)) != 0) {
+    log_error(sim, result, "lns_move");
+    return -1;
+  }
+  int solution_count = 0;
+  if ((result = backend->get_int_attr(model, ATTR_SOL_COUNT,
+                                      &solution_count)) != 0) {
+    log_error(sim, result, "get_int_attr(\"SolCount\")");
+    return -1;
+  }
+  if (solution_count == 0)
+    return 1;
+  return model_sequence(sim, instance, Positional, candidate) == 0 ? 0 : 1;
+}
+
+void lns_neighbourhood(lns_worker_t *worker, long move, const int *current,
+                       char *free_jobs, int *scratch) {
+  int n = ((instance_t *)worker->sim.instances->values[0])->number_of_jobs;
+  memset(free_jobs, 0, sizeof(*free_jobs) * n);
+  if (move % 2 == 0) {
+    // Consecutive positions
+    int width = n < LNS_WINDOW ? n : LNS_WINDOW;
+    int first = lns_random(worker, n - width + 1);
+    for (size_t h = first; h < first + width; h++) {
+      free_jobs[current[h]] = 1;
+    }
+  } else {
+    // Jobs anywhere in the schedule, first entries of a partial shuffle
+    int size = n < LNS_SUBSET ? n : LNS_SUBSET;
+    for (size_t j = 0; j < n; j++) {
+      scratch[j] = j;
+    }
+    for (size_t k = 0; k < size; k++) {
+      int other = k + lns_random(worker, n - k);
+      int job = scratch[other];
+      scratch[other] = scratch[k];
+      scratch[k] = job;
+      free_jobs[job] = 1;
+    }
+  }
+}
+
+int lns_random(lns_worker_t *worker, int bound) {
+  worker->random = (long long)worker->random * LNS_MULTIPLIER % LNS_MODULUS;
+  return worker->random % bound;
+}
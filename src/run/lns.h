@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define LNS_MIN_JOBS 50    // Smaller positional models are solved whole
+#define LNS_WINDOW 12      // Consecutive positions freed by a window move
+#define LNS_SUBSET 10      // Jobs freed by a random subset move
+#define LNS_SUB_LIMIT 2.0  // Seconds of every sub-MIP at most
+#define LNS_STALL 200      // Moves in a row without improvement end the search
+#define STATUS_LNS 102     // Best schedule of the neighbourhoods, not proven
+
+// Large neighbourhood search on the positional model of `instance`, from the
+// best of `start` (NULL: none) and the simple orders. Every move frees the
+// jobs of a window of consecutive positions, or a random subset of jobs, and
+// fixes the others in their position through the lower bounds of their
+// x_(j h): the sub-MIP reorders the free jobs within their positions in at
+// most LNS_SUB_LIMIT seconds. `workers` threads, alternating the two moves,
+// share the best schedule until `limit` seconds or LNS_STALL failed moves.
+// `sequence` gets the schedule
+solution_t *lns_solve(simulation_t *sim, instance_t *instance,
+                      solver_t solver, double limit, int workers,
+                      const int *start, int *sequence);
@@ -0,0 +1,116 @@
+#include "memory.h"
+#include "../utils/results.h"
+#include "model/model.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+// Sum of measured over default estimates for every formulation
+typedef struct {
+  int points[NUMBER_OF_SOLVERS];
+  double sum[NUMBER_OF_SOLVERS];
+} ratios_t;
+
+int memory_history(const results_block_t *block, void *data);
+double memory_default(double variables, double nonzeros);
+
+memory_t *memory_init(double budget, const char *history) {
+  memory_t *memory = malloc(sizeof(*memory));
+  if (memory == NULL) {
+    perror("Could not allocate memory for the memory budget");
+    return NULL;
+  }
+  if (pthread_mutex_init(&memory->lock, NULL) != 0) {
+    perror("Could not initialize memory lock");
+    free(memory);
+    return NULL;
+  }
+  memory->budget = budget;
+  memory->used = 0;
+
+  ratios_t ratios;
+  memset(&ratios, 0, sizeof(ratios));
+  FILE *fp = history != NULL ? fopen(history, "rb") : NULL;
+  if (fp != NULL) {
+    fclose(fp);
+    results_scan(history, memory_history, &ratios);
+  }
+  for (solver_t s = 0; s < NUMBER_OF_SOLVERS; s++) {
+    memory->factors[s] = ratios.points[s] > 0
+                             ? ratios.sum[s] / ratios.points[s] * MEMORY_MARGIN
+                             : 1;
+  }
+  return memory;
+}
+
+void memory_free(memory_t *memory) {
+  if (memory == NULL)
+    return;
+  pthread_mutex_destroy(&memory->lock);
+  free(memory);
+}
+
+double memory_estimate(const memory_t *memory, const instance_t *instance,
+                       solver_t solver) {
+  long variables = 0, nonzeros = 0;
+  model_counts(instance, solver, &variables, &nonzeros);
+  return memory_default(variables, nonzeros) * memory->factors[solver];
+}
+
+int memory_acquire(memory_t *memory, double gb, double *limit) {
+  int result = 0;
+  pthread_mutex_lock(&memory->lock);
+  double left = memory->budget - memory->used;
+  if (gb > left) {
+    result = 1;
+  } else {
+    // Its own share: the limits of the admitted models add up to the budget
+    *limit = gb * MEMORY_MARGIN < left ? gb * MEMORY_MARGIN : left;
+    memory->used += *limit;
+  }
+  pthread_mutex_unlock(&memory->lock);
+  return result;
+}
+
+void memory_release(memory_t *memory, double limit) {
+  pthread_mutex_lock(&memory->lock);
+  memory->used -= limit;
+  if (memory->used < 0)
+    memory->used = 0;
+  pthread_mutex_unlock(&memory->lock);
+}
+
+double memory_physical(void) {
+#ifdef __linux__
+  long pages = sysconf(_SC_PHYS_PAGES);
+  long page_size = sysconf(_SC_PAGE_SIZE);
+  return pages > 0 && page_size > 0 ? (double)pages * page_size / 1e9 : 0;
+#else
+  return 0;
+#endif
+}
+
+int memory_history(const results_block_t *block, void *data) {
+  ratios_t *ratios = data;
+  for (size_t k = 0; k < block->length; k++) {
+    int s = block->solver[k];
+    // Version 1 blocks and solves without a model have no measure
+    if (s < 0 || s >= NUMBER_OF_SOLVERS || block->memory[k] <= 0 ||
+        block->variables[k] <= 0 || block->nonzeros[k] < 0)
+      continue;
+    ratios->points[s] += 1;
+    ratios->sum[s] +=
+        block->memory[k] /
+        memory_default(block->variables[k], block->nonzeros[k]);
+  }
+  return 0;
+}
+
+double memory_default(double variables, double nonzeros) {
+  return MEMORY_BASE + MEMORY_PER_VARIABLE * variables +
+         MEMORY_PER_NONZERO * nonzeros;
+}
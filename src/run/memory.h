@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../utils/entities.h"
+#include <pthread.h>
+
+#define MEMORY_SHARE 0.8 // Default budget: share of the physical memory
+// GB of a model before any history: a base plus its variables and nonzeros
+#define MEMORY_BASE 0.05
+#define MEMORY_PER_VARIABLE 1e-6
+#define MEMORY_PER_NONZERO 2e-7
+#define MEMORY_MARGIN 1.25 // Over the mean ratio measured in the history
+
+// GB of the node admitted to the models solved at the same time
+struct memory_t {
+  double budget;
+  double used; // Admitted and not released yet
+  // Measured peak over the default estimate of every formulation, fitted on
+  // the MaxMemUsed of the results store (1 without history)
+  double factors[NUMBER_OF_SOLVERS];
+  pthread_mutex_t lock;
+};
+
+memory_t *memory_init(double budget, const char *history);
+void memory_free(memory_t *memory);
+// GB the model of `instance` is expected to use, from its size
+double memory_estimate(const memory_t *memory, const instance_t *instance,
+                       solver_t solver);
+// Admit a model of `gb`, 1 when it does not fit in what is left. `limit`
+// gets the GB reserved for the model, `gb` with a margin when it is left
+int memory_acquire(memory_t *memory, double gb, double *limit);
+// Release the `limit` of an admitted model
+void memory_release(memory_t *memory, double limit);
+// GB of physical memory of the node, 0 if unknown
+double memory_physical(void);
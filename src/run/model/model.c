@@ -1,13 +1,38 @@
 #include "model.h"
+#include "../../utils/arena.h"
+#include "../../utils/evaluate.h"
 #include "../../utils/utils.h"
+#include "../backend/backend.h"
+#include "../dominance.h"
+#include "../profile.h"
 #include "../run.h"
-#include "gurobi_c.h"
+#include <limits.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-void c_print(int size, int *index, double *vals, char **names);
-int realloc_constr(int **constr_index, double **constr_vals, size_t size);
+// Rows of one constraint family in CSR, added by a single add_constrs
+typedef struct {
+  int count;    // Rows so far
+  int nonzeros; // Nonzeros so far
+  int end;      // End of the last row, where the next one begins
+  int *begins;
+  int *indexes;
+  double *values;
+  char *senses;
+  double *rhs;
+} constrs_t;
+
+long model_size(const instance_t *instance, solver_t solver, int *big_t);
+void model_time_indexed_offsets(const instance_t *instance, int big_t,
+                                int *offsets);
+int constrs_init(arena_t *arena, constrs_t *constrs, long rows,
+                 long nonzeros);
+void constrs_add(constrs_t *constrs, int index, double value);
+void constrs_row(constrs_t *constrs, char sense, double rhs);
+int constrs_flush(simulation_t *sim, instance_t *instance, constrs_t *constrs,
+                  const char *family);
 tuple_t *create_tuple(int index, double val);
 
 int model_init(simulation_t *sim, int instance_number, solver_t solver,
@@ -15,22 +40,29 @@ int model_init(simulation_t *sim, int instance_number, solver_t solver,
   instance_t *instance = sim->instances->values[instance_number];
   int result = 0;
 
-  char *name = formatted_string("%d,%d", solver, instance_number);
+  // Left over by starts set after the previous build
+  arena_reset(sim->arena);
+  char *name = arena_printf(sim->arena, "%d,%d", solver, instance_number);
   if (name == NULL)
     name = "unknown,unknown";
 
-  if ((result = GRBnewmodel(sim->env, &instance->model, name, 0, NULL, NULL,
-                            NULL, NULL, NULL)) != 0) {
-    log_error(sim, result, "GRBnewmodel");
+  if ((result = sim->backend->model_init(sim->env, &instance->model, name)) !=
+      0) {
+    log_error(sim, result, "model_init");
     return result;
   }
 
-  if ((result = GRBsetdblparam(GRBgetenv(instance->model),
-                               GRB_DBL_PAR_TIMELIMIT, TIME_LIMIT)) != 0) {
-    log_error(sim, result, "GRBsetdblparam(\"GRB_DBL_PAR_TIMELIMIT\")");
+  if ((result = sim->backend->set_dbl_param(instance->model, PARAM_TIME_LIMIT,
+                                            TIME_LIMIT)) != 0) {
+    log_error(sim, result, "set_dbl_param(\"TimeLimit\")");
     return result;
   }
 
+  // Parameters tuned by `amod tune` for the class of the instance
+  const profile_t *profile = profile_find(sim->profiles, solver, instance);
+  if (profile != NULL && (result = profile_apply(sim, instance, profile)) != 0)
+    return result;
+
   switch (solver) {
   case Precedence:
     result = model_precedence_create(sim, instance);
@@ -51,9 +83,19 @@ int model_init(simulation_t *sim, int instance_number, solver_t solver,
     result =
         model_heuristics_time_indexed_create(sim, instance, heuristic_value);
     break;
+  case DynamicProgramming:
+    // Solved without a model (see run/dp.h)
+    result = -1;
+    break;
+  case CompactTimeIndexed:
+    result = model_compact_time_indexed_create(sim, instance);
+    break;
   }
-  free(name);
-  name = NULL;
+  // Orderings provable before solving shrink every formulation
+  if (result == 0 && model_dominance(sim, instance, solver) < 0)
+    result = -1;
+  // The backend has copied the model, its buffers are free for the next one
+  arena_reset(sim->arena);
   return result;
 }
 
@@ -66,6 +108,7 @@ solution_t *model_optimize(simulation_t *sim, int i, solver_t solver) {
     perror("Could not allocate memory for solution values");
     return NULL;
   }
+  memset(values, 0, sizeof(*values) * instance->number_of_jobs);
 
   solution_t *solution = malloc(sizeof(*solution));
   if (solution == NULL) {
@@ -76,30 +119,74 @@ solution_t *model_optimize(simulation_t *sim, int i, solver_t solver) {
   solution->solver = solver;
   solution->size = instance->number_of_jobs;
   solution->values = values;
+  solution->objective_value = -1;
+  solution->bound = -1;
+  solution->gap = -1;
   solution->heuristic_value = -1;
-
-  if ((result = GRBoptimize(instance->model)) != 0) {
-    log_error(sim, result, "GRBoptimize");
+  solution->memory = -1;
+
+  const backend_t *backend = sim->backend;
+  // Shown live while it runs (see run/status.h)
+  if (sim->progress != NULL &&
+      (result = backend->set_progress(instance->model, sim->progress)) != 0)
+    log_error(sim, result, "set_progress");
+  result = backend->optimize(instance->model);
+  if (sim->progress != NULL)
+    backend->set_progress(instance->model, NULL);
+  if (result != 0) {
+    log_error(sim, result, "optimize");
     return NULL;
   }
 
-  if ((result = GRBgetintattr(instance->model, GRB_INT_ATTR_STATUS,
-                              &solution->status)) != 0)
-    log_error(sim, result, "GRBgetintattr(\"GRB_INT_ATTR_STATUS\")");
+  if ((result = backend->get_int_attr(instance->model, ATTR_STATUS,
+                                      &solution->status)) != 0)
+    log_error(sim, result, "get_int_attr(\"Status\")");
 
-  if ((result = GRBgetdblattr(instance->model, GRB_DBL_ATTR_RUNTIME,
-                              &solution->runtime)) != 0)
-    log_error(sim, result, "GRBgetdblattr(\"GRB_DBL_ATTR_RUNTIME\")");
+  if ((result = backend->get_dbl_attr(instance->model, ATTR_RUNTIME,
+                                      &solution->runtime)) != 0)
+    log_error(sim, result, "get_dbl_attr(\"Runtime\")");
 
-  if ((result = GRBgetdblattr(instance->model, GRB_DBL_ATTR_OBJVAL,
-                              &solution->objective_value)) != 0)
-    log_error(sim, result, "GRBgetdblattr(\"GRB_DBL_ATTR_OBJVAL\")");
+  // Not every backend measures it
+  if (backend->get_dbl_attr(instance->model, ATTR_MAX_MEM_USED,
+                            &solution->memory) != 0)
+    solution->memory = -1;
 
-  if ((result =
-           GRBgetdblattrarray(instance->model, GRB_DBL_ATTR_X, 0,
-                              instance->number_of_jobs, solution->values)) != 0)
-    log_error(sim, result, "GRBgetdblattrarray(\"GRB_DBL_ATTR_X\")");
+  // Nothing to read when no solution was found (or the model is not solved)
+  int solution_count = 0;
+  if ((result = backend->get_int_attr(instance->model, ATTR_SOL_COUNT,
+                                      &solution_count)) != 0)
+    log_error(sim, result, "get_int_attr(\"SolCount\")");
+  if (solution_count == 0)
+    return solution;
 
+  if ((result = backend->get_dbl_attr(instance->model, ATTR_OBJ_VAL,
+                                      &solution->objective_value)) != 0)
+    log_error(sim, result, "get_dbl_attr(\"ObjVal\")");
+
+  if ((result = backend->get_dbl_attr(instance->model, ATTR_OBJ_BOUND,
+                                      &solution->bound)) != 0) {
+    log_error(sim, result, "get_dbl_attr(\"ObjBound\")");
+  } else {
+    double z = solution->objective_value;
+    double distance = fabs(solution->bound - z);
+    solution->gap = z != 0 ? distance / fabs(z) : distance;
+  }
+
+  // Completion times of the decoded sequence: the first variables are only
+  // the C_j in some of the formulations
+  int n = instance->number_of_jobs;
+  int *sequence = malloc(sizeof(*sequence) * n);
+  int *c_hs = malloc(sizeof(*c_hs) * n);
+  if (sequence == NULL || c_hs == NULL) {
+    perror("Could not allocate memory for the decoded solution");
+  } else if (model_sequence(sim, instance, solver, sequence) == 0) {
+    evaluate(instance, sequence, c_hs);
+    for (size_t h = 0; h < n; h++) {
+      solution->values[sequence[h]] = c_hs[h];
+    }
+  }
+  free(sequence);
+  free(c_hs);
   return solution;
 }
 
@@ -109,32 +196,23 @@ int model_precedence_create(simulation_t *sim, instance_t *instance) {
   int size = n                  // C_j
              + n * (n - 1) / 2; // x_(i j) i < j
 
-  double *vars = malloc(sizeof(*vars) * size);
-  if (vars == NULL) {
-    perror("Could not allocate memory for vars");
+  arena_t *arena = sim->arena;
+  double *vars = arena_alloc(arena, sizeof(*vars) * size);
+  char *var_types = arena_alloc(arena, sizeof(*var_types) * size);
+  char **names = arena_alloc(arena, sizeof(*names) * size);
+  if (vars == NULL || var_types == NULL || names == NULL)
     return -1;
-  }
   memset(vars, 0, sizeof(*vars) * size);
   // Setting objective function: sum_(h = 1)^n C_j
   for (size_t i = 0; i < n; i++) {
     vars[i] = 1.0;
   }
 
-  char *var_types = malloc(sizeof(*var_types) * size);
-  if (var_types == NULL) {
-    perror("Could not allocate memory for var_types");
-    return -1;
-  }
-  memset(var_types, GRB_BINARY, sizeof(*var_types) * size);
-  memset(var_types, GRB_INTEGER, sizeof(*var_types) * n);
+  memset(var_types, BACKEND_BINARY, sizeof(*var_types) * size);
+  memset(var_types, BACKEND_INTEGER, sizeof(*var_types) * n);
 
-  char **names = malloc(sizeof(*names) * size);
-  if (names == NULL) {
-    perror("Could not allocate memory for names");
-    return -1;
-  }
   for (size_t j = 0; j < n; j++) {
-    char *name = formatted_string("C_%ld", j + 1);
+    char *name = arena_printf(arena, "C_%ld", j + 1);
     if (name == NULL)
       name = "C_j";
     names[j] = name;
@@ -143,7 +221,7 @@ int model_precedence_create(simulation_t *sim, instance_t *instance) {
   size_t index = n;
   for (size_t i = 0; i < n; i++) {
     for (size_t j = i + 1; j < n; j++) {
-      char *name = formatted_string("x_(%ld,%ld)", i + 1, j + 1);
+      char *name = arena_printf(arena, "x_(%ld,%ld)", i + 1, j + 1);
       if (name == NULL)
         name = "x_(i,j)";
       names[index] = name;
@@ -151,9 +229,9 @@ int model_precedence_create(simulation_t *sim, instance_t *instance) {
     }
   }
 
-  if ((result = GRBaddvars(instance->model, size, 0, NULL, NULL, NULL, vars,
-                           NULL, NULL, var_types, names)) != 0) {
-    log_error(sim, result, "GRBaddvars");
+  if ((result = sim->backend->add_vars(instance->model, size, vars, NULL,
+                                       NULL, var_types, names)) != 0) {
+    log_error(sim, result, "add_vars");
     return result;
   }
 
@@ -167,103 +245,56 @@ int model_precedence_create(simulation_t *sim, instance_t *instance) {
   }
   big_m += max_r_j;
 
-  size_t c_size = 1;
-  int *c_index = malloc(sizeof(*c_index) * c_size);
-  if (c_index == NULL) {
-    perror("Could not allocate memory for constr_index");
-    return -1;
-  }
-  memset(c_index, 0, sizeof(*c_index) * c_size);
-  double *c_vals = malloc(sizeof(*c_vals) * c_size);
-  if (c_vals == NULL) {
-    perror("Could not allocate memory for constr_vals");
-    return -1;
-  }
-  memset(c_vals, 0, sizeof(c_vals) * c_size);
+  // Every family is added at once, from rows built in the arena
+  constrs_t constrs;
+  long pairs = (long)n * (n - 1) / 2;
 
   // C_j >= p_j + r_j forall j in J
-
-  // forall j in J
+  if (constrs_init(arena, &constrs, n, n) != 0)
+    return -1;
   for (size_t j = 0; j < n; j++) {
-    c_index[0] = j;
-    c_vals[0] = 1;
-
-    double rhs = instance->processing_times[j] + instance->release_dates[j];
-
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_GREATER_EQUAL, rhs, NULL)) != 0) {
-      perror(formatted_string("Constraint C_j >= p_j + r_j: j = %ld", j));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
-    }
+    constrs_add(&constrs, j, 1);
+    constrs_row(&constrs, BACKEND_GREATER_EQUAL,
+                instance->processing_times[j] + instance->release_dates[j]);
   }
-
-  c_size = 3;
-  if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints C_j >= p_j + r_j")) != 0)
     return result;
 
   // C_i <= C_j - p_j + M(1 - x_(i j)) 1 <= i < j <= n
+  if (constrs_init(arena, &constrs, pairs, 3 * pairs) != 0)
+    return -1;
   index = n;
   for (size_t i = 0; i < n; i++) {
     for (size_t j = i + 1; j < n; j++) {
-      c_index[0] = i;
-      c_vals[0] = 1;
-      c_index[1] = j;
-      c_vals[1] = -1;
-      c_index[2] = index++;
-      c_vals[2] = big_m;
-      double rhs = big_m - instance->processing_times[j];
-
-      if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                                 GRB_LESS_EQUAL, rhs, NULL)) != 0) {
-        perror(formatted_string("big M constraint 1: i = %ld, j = %ld", i, j));
-        log_error(sim, result, "GRBaddconstr");
-        c_print(c_size, c_index, c_vals, names);
-        return result;
-      }
+      constrs_add(&constrs, i, 1);
+      constrs_add(&constrs, j, -1);
+      constrs_add(&constrs, index++, big_m);
+      constrs_row(&constrs, BACKEND_LESS_EQUAL,
+                  big_m - instance->processing_times[j]);
     }
   }
-
-  c_size = 3;
-  if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "big M constraints 1")) != 0)
     return result;
 
   // C_j <= C_i - p_i + M x_(i j) 1 <= i < j <= n
+  if (constrs_init(arena, &constrs, pairs, 3 * pairs) != 0)
+    return -1;
   index = n;
   for (size_t i = 0; i < n; i++) {
     for (size_t j = i + 1; j < n; j++) {
-      c_index[0] = j;
-      c_vals[0] = 1;
-      c_index[1] = i;
-      c_vals[1] = -1;
-      c_index[2] = index++;
-      c_vals[2] = -big_m;
-      double rhs = -instance->processing_times[i];
-
-      if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                                 GRB_LESS_EQUAL, rhs, NULL)) != 0) {
-        perror(formatted_string("big M constraint 2: i = %ld, j = %ld", i, j));
-        log_error(sim, result, "GRBaddconstr");
-        c_print(c_size, c_index, c_vals, names);
-        return result;
-      }
+      constrs_add(&constrs, j, 1);
+      constrs_add(&constrs, i, -1);
+      constrs_add(&constrs, index++, -big_m);
+      constrs_row(&constrs, BACKEND_LESS_EQUAL,
+                  -instance->processing_times[i]);
     }
   }
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "big M constraints 2")) != 0)
+    return result;
 
-  for (size_t i = 0; i < size; i++) {
-    free(names[i]);
-  }
-  free(names);
-  names = NULL;
-  free(vars);
-  vars = NULL;
-  free(var_types);
-  var_types = NULL;
-  free(c_index);
-  c_index = NULL;
-  free(c_vals);
-  c_vals = NULL;
   return result;
 }
 
@@ -274,34 +305,25 @@ int model_positional_create(simulation_t *sim, instance_t *instance) {
   int size = n +    // C_[h]
              n * n; // x_(j h)
 
-  double *vars = malloc(sizeof(*vars) * size);
-  if (vars == NULL) {
-    perror("Could not allocate memory for vars");
+  arena_t *arena = sim->arena;
+  double *vars = arena_alloc(arena, sizeof(*vars) * size);
+  char *var_types = arena_alloc(arena, sizeof(*var_types) * size);
+  char **names = arena_alloc(arena, sizeof(*names) * size);
+  if (vars == NULL || var_types == NULL || names == NULL)
     return -1;
-  }
   memset(vars, 0, sizeof(*vars) * size);
   // Setting objective function: sum_(h = 1)^n C_[h]
   for (size_t i = 0; i < n; i++) {
     vars[i] = 1;
   }
 
-  char *var_types = malloc(sizeof(*var_types) * size);
-  if (var_types == NULL) {
-    perror("Could not allocate memory for var_types");
-    return -1;
-  }
-  memset(var_types, GRB_BINARY, sizeof(*var_types) * size);
+  memset(var_types, BACKEND_BINARY, sizeof(*var_types) * size);
   for (size_t i = 0; i < n; i++) {
-    var_types[i] = GRB_INTEGER;
+    var_types[i] = BACKEND_INTEGER;
   }
 
-  char **names = malloc(sizeof(*names) * size);
-  if (names == NULL) {
-    perror("Could not allocate memory for names");
-    return -1;
-  }
   for (size_t h = 0; h < n; h++) {
-    char *name = formatted_string("C_%ld", h + 1);
+    char *name = arena_printf(arena, "C_%ld", h + 1);
     if (name == NULL)
       name = "C_[h]";
     names[h] = name;
@@ -310,166 +332,91 @@ int model_positional_create(simulation_t *sim, instance_t *instance) {
   for (size_t j = 0; j < n; j++) {
     for (size_t h = 0; h < n; h++) {
       size_t index = n + j * n + h;
-      char *name = formatted_string("x_(%ld,%ld)", j + 1, h + 1);
+      char *name = arena_printf(arena, "x_(%ld,%ld)", j + 1, h + 1);
       if (name == NULL)
         name = "x_(j,h)";
       names[n + j * n + h] = name;
     }
   }
-  if ((result = GRBaddvars(instance->model, size, 0, NULL, NULL, NULL, vars,
-                           NULL, NULL, var_types, names)) != 0) {
-    log_error(sim, result, "GRBaddvars");
+  if ((result = sim->backend->add_vars(instance->model, size, vars, NULL,
+                                       NULL, var_types, names)) != 0) {
+    log_error(sim, result, "add_vars");
     return result;
   }
 
-  size_t c_size = n;
-  int *c_index = malloc(sizeof(*c_index) * c_size);
-  if (c_index == NULL) {
-    perror("Could not allocate memory for constr_index");
-    return -1;
-  }
-  memset(c_index, 0, sizeof(*c_index) * c_size);
-  double *c_vals = malloc(sizeof(*c_vals) * c_size);
-  if (c_vals == NULL) {
-    perror("Could not allocate memory for constr_vals");
-    return -1;
-  }
-  memset(c_vals, 0, sizeof(c_vals) * c_size);
+  // Every family is added at once, from rows built in the arena
+  constrs_t constrs;
 
   // sum_(h=1)^n x_(j h) = 1 forall j in J
-
-  // forall j in J
+  if (constrs_init(arena, &constrs, n, (long)n * n) != 0)
+    return -1;
   for (size_t j = 0; j < n; j++) {
     for (size_t h = 0; h < n; h++) {
-      c_index[h] = n + j * n + h;
-      c_vals[h] = 1;
-    }
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_EQUAL, 1, NULL)) != 0) {
-      perror(formatted_string("Constraint j = %ld", j));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
+      constrs_add(&constrs, n + j * n + h, 1);
     }
+    constrs_row(&constrs, BACKEND_EQUAL, 1);
   }
-
-  c_size = n;
-  if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the jobs")) != 0)
     return result;
 
   // sum_(j in J) x_(j h) forall h=1,..,n
-
-  // forall h=1,...n
+  if (constrs_init(arena, &constrs, n, (long)n * n) != 0)
+    return -1;
   for (size_t h = 0; h < n; h++) {
     for (size_t j = 0; j < n; j++) {
-      c_index[j] = n + j * n + h;
-      c_vals[j] = 1;
-    }
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_EQUAL, 1, NULL)) != 0) {
-      perror(formatted_string("Constraint h = %ld", h));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
+      constrs_add(&constrs, n + j * n + h, 1);
     }
+    constrs_row(&constrs, BACKEND_EQUAL, 1);
   }
-
-  c_size = n + 1;
-  if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the positions")) != 0)
     return result;
 
-  // C_1 >= sum_(j in J) (p_j x_(j 1))
-  c_index[0] = 0;
-  c_vals[0] = 1;
-  for (size_t j = 0; j < n; j++) {
-    c_index[1 + j] = n + j * n;
-    c_vals[1 + j] = -instance->processing_times[j];
-  }
-
-  if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                             GRB_GREATER_EQUAL, 0, NULL)) != 0) {
-    perror("Constraint C_1");
-    log_error(sim, result, "GRBaddconstr");
-    c_print(c_size, c_index, c_vals, names);
-    return result;
-  }
-
-  // C_[h] >= C_[h - 1] + sum_(j in J) (p_j x(j h)) forall h=2,...,n
-  for (size_t h = 1; h < n; h++) {
-    c_size = n + 2;
-    if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
-      return result;
+  // C_1 >= sum_(j in J) (p_j x_(j 1)) and C_[h] >= C_[h - 1] + sum_(j in J)
+  // (p_j x(j h)) forall h=2,...,n
+  if (constrs_init(arena, &constrs, n, (long)n * (n + 2)) != 0)
+    return -1;
+  for (size_t h = 0; h < n; h++) {
     // C_[h]
-    c_index[0] = h;
-    c_vals[0] = 1;
+    constrs_add(&constrs, h, 1);
     // C_[h-1]
-    c_index[1] = h - 1;
-    c_vals[1] = -1;
+    if (h > 0)
+      constrs_add(&constrs, h - 1, -1);
     for (size_t j = 0; j < n; j++) {
-      c_index[2 + j] = n + j * n + h;
-      c_vals[2 + j] = -instance->processing_times[j];
-    }
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_GREATER_EQUAL, 0, NULL)) != 0) {
-      perror(formatted_string("Constraint h = %ld", h));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
+      constrs_add(&constrs, n + j * n + h, -instance->processing_times[j]);
     }
+    constrs_row(&constrs, BACKEND_GREATER_EQUAL, 0);
   }
-
-  c_size = n + 1;
-  if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints C_[h]")) != 0)
     return result;
 
   // C_[h] >= sum_(j in J) (p_j + r_j) * x_(j h)
+  if (constrs_init(arena, &constrs, n, (long)n * (n + 1)) != 0)
+    return -1;
   for (size_t h = 0; h < n; h++) {
-    c_index[0] = h;
-    c_vals[0] = 1;
+    constrs_add(&constrs, h, 1);
     for (size_t j = 0; j < n; j++) {
       int c_j = instance->processing_times[j] + instance->release_dates[j];
-      c_index[1 + j] = n + j * n + h;
-      c_vals[1 + j] = -c_j;
-    }
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_GREATER_EQUAL, 0, NULL)) != 0) {
-      perror(formatted_string("Constraint h = %ld", h));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
+      constrs_add(&constrs, n + j * n + h, -c_j);
     }
+    constrs_row(&constrs, BACKEND_GREATER_EQUAL, 0);
   }
-
-  c_size = 1;
-  if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
-    return -1;
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the release dates")) != 0)
+    return result;
 
   // C_[h] >= 0
+  if (constrs_init(arena, &constrs, n, n) != 0)
+    return -1;
   for (size_t h = 0; h < n; h++) {
-    c_index[0] = h;
-    c_vals[0] = 1;
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_GREATER_EQUAL, 0, NULL)) != 0) {
-      perror(formatted_string("Constraint h = %ld", h));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
-    }
-  }
-
-  for (size_t i = 0; i < size; i++) {
-    free(names[i]);
-  }
-  free(names);
-  names = NULL;
-  free(vars);
-  vars = NULL;
-  free(var_types);
-  var_types = NULL;
-  free(c_index);
-  c_index = NULL;
-  free(c_vals);
-  c_vals = NULL;
+    constrs_add(&constrs, h, 1);
+    constrs_row(&constrs, BACKEND_GREATER_EQUAL, 0);
+  }
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints C_[h] >= 0")) != 0)
+    return result;
 
   return result;
 }
@@ -492,12 +439,14 @@ int model_time_indexed_create(simulation_t *sim, instance_t *instance) {
     size += big_t - instance->processing_times[j] + 1;
   }
 
-  size_t index = 0;
-  double *vars = malloc(sizeof(*vars) * size);
-  if (vars == NULL) {
-    perror("Could not allocate memory for vars");
+  arena_t *arena = sim->arena;
+  double *vars = arena_alloc(arena, sizeof(*vars) * size);
+  char *var_types = arena_alloc(arena, sizeof(*var_types) * size);
+  char **names = arena_alloc(arena, sizeof(*names) * size);
+  if (vars == NULL || var_types == NULL || names == NULL)
     return -1;
-  }
+
+  size_t index = 0;
   for (size_t j = 0; j < n; j++) {
     for (size_t t = 0; t < big_t - instance->processing_times[j] + 1; t++) {
       vars[index] = t + 1 + instance->processing_times[j] - 1;
@@ -505,152 +454,193 @@ int model_time_indexed_create(simulation_t *sim, instance_t *instance) {
     }
   }
 
-  char *var_types = malloc(sizeof(*var_types) * size);
-  if (var_types == NULL) {
-    perror("Could not allocate memory for var_types");
-    return -1;
-  }
-  memset(var_types, GRB_BINARY, sizeof(*var_types) * size);
-
-  char **names = malloc(sizeof(*names) * size);
-  if (names == NULL) {
-    perror("Could not allocate memory for names");
-    return -1;
-  }
+  memset(var_types, BACKEND_BINARY, sizeof(*var_types) * size);
 
   index = 0;
   for (size_t j = 0; j < n; j++) {
     for (size_t t = 0; t < big_t - instance->processing_times[j] + 1; t++) {
-      char *name = formatted_string("x_(%ld,%ld)", j + 1, t + 1);
+      char *name = arena_printf(arena, "x_(%ld,%ld)", j + 1, t + 1);
       if (name == NULL)
         name = "x_(j,t)";
       names[index++] = name;
     }
   }
 
-  if ((result = GRBaddvars(instance->model, size, 0, NULL, NULL, NULL, vars,
-                           NULL, NULL, var_types, names)) != 0) {
-    log_error(sim, result, "GRBaddvars");
+  if ((result = sim->backend->add_vars(instance->model, size, vars, NULL,
+                                       NULL, var_types, names)) != 0) {
+    log_error(sim, result, "add_vars");
     return result;
   }
 
-  size_t c_size = 1;
-  int *c_index = malloc(sizeof(*c_index) * c_size);
-  if (c_index == NULL) {
-    perror("Could not allocate memory for constr_index");
-    return -1;
-  }
-  memset(c_index, 0, sizeof(*c_index) * c_size);
-  double *c_vals = malloc(sizeof(*c_vals) * c_size);
-  if (c_vals == NULL) {
-    perror("Could not allocate memory for constr_vals");
-    return -1;
+  // Every family is added at once, from rows built in the arena: the
+  // capacity row of tau holds min{tau + 1, p_j} starts of every job that
+  // still fits
+  constrs_t constrs;
+  long capacity = 0, releases = 0;
+  for (size_t j = 0; j < n; j++) {
+    long p_j = instance->processing_times[j];
+    long starts = big_t - p_j + 1;
+    long ramp = starts < p_j ? starts : p_j;
+    capacity += ramp * (ramp + 1) / 2 + (starts - ramp) * p_j;
+    releases += instance->release_dates[j];
   }
-  memset(c_vals, 0, sizeof(c_vals) * c_size);
 
   // sum_(t = 1)^(T - p_j + 1) x_(j t) = 1 forall j in J
+  if (constrs_init(arena, &constrs, n, size) != 0)
+    return -1;
   int offset_j = 0;
   for (size_t j = 0; j < n; j++) {
-    index = 0;
-    c_size = big_t - instance->processing_times[j] + 1;
-
-    if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
-      return result;
-
-    for (size_t t = 0; t < c_size; t++) {
-      c_index[index] = offset_j + t;
-      c_vals[index] = 1;
-      index += 1;
+    int starts = big_t - instance->processing_times[j] + 1;
+    for (size_t t = 0; t < starts; t++) {
+      constrs_add(&constrs, offset_j + t, 1);
     }
-
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_EQUAL, 1, NULL)) != 0) {
-      perror(formatted_string("Constraint j = %ld", j));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
-    }
-    offset_j += big_t - instance->processing_times[j] + 1;
+    constrs_row(&constrs, BACKEND_EQUAL, 1);
+    offset_j += starts;
   }
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the jobs")) != 0)
+    return result;
 
   // sum_(j in J) sum_(t = max{0,tau-p_j+1})^tau x_(j t) <= 1 forall tau=1,...T
+  if (constrs_init(arena, &constrs, big_t, capacity) != 0)
+    return -1;
   for (size_t tau = 0; tau < big_t; tau++) {
-    index = 0;
-    c_size = 0;
     offset_j = 0;
     for (size_t j = 0; j < n; j++) {
       int max = tau - instance->processing_times[j] + 1;
       if (max < 0)
         max = 0;
-      // There are not enough time slots to process the entire job
-      if (big_t - tau < instance->processing_times[j] || tau - max + 1 == 0) {
-        offset_j += big_t - instance->processing_times[j] + 1;
-        continue;
-      }
-      c_size += tau - max + 1;
-
-      if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
-        return result;
-      for (size_t t = max; t <= tau; t++) {
-        c_index[index] = offset_j + t;
-        c_vals[index] = 1;
-        index += 1;
+      // There are enough time slots to process the entire job
+      if (big_t - tau >= instance->processing_times[j]) {
+        for (size_t t = max; t <= tau; t++) {
+          constrs_add(&constrs, offset_j + t, 1);
+        }
       }
       offset_j += big_t - instance->processing_times[j] + 1;
     }
-
-    if (c_size == 0)
-      continue;
-
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_LESS_EQUAL, 1, NULL)) != 0) {
-      perror(formatted_string("Constraint tau = %ld", tau));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
-    }
+    constrs_row(&constrs, BACKEND_LESS_EQUAL, 1);
   }
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the capacity")) != 0)
+    return result;
 
   // Release times
+  if (constrs_init(arena, &constrs, n, releases) != 0)
+    return -1;
   offset_j = 0;
   for (size_t j = 0; j < n; j++) {
-    c_size = instance->release_dates[j];
+    for (size_t t = 0; t < instance->release_dates[j]; t++) {
+      constrs_add(&constrs, offset_j + t, 1);
+    }
+    constrs_row(&constrs, BACKEND_EQUAL, 0);
+    offset_j += big_t - instance->processing_times[j] + 1;
+  }
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the release dates")) != 0)
+    return result;
 
-    if (c_size == 0) {
-      offset_j += big_t - instance->processing_times[j] + 1;
-      continue;
+  return result;
+}
+
+int model_compact_time_indexed_create(simulation_t *sim, instance_t *instance) {
+  int result = 0;
+  int n = instance->number_of_jobs;
+  int big_t = 0;
+  int size = model_size(instance, CompactTimeIndexed, &big_t);
+
+  // y_(j t) = 1 when job j has started by t, so that x_(j t) = y_(j t) -
+  // y_(j t-1): the jobs running at tau are y_(j tau) - y_(j tau-p_j), two
+  // variables a job in every capacity row
+  arena_t *arena = sim->arena;
+  double *vars = arena_alloc(arena, sizeof(*vars) * size);
+  char *var_types = arena_alloc(arena, sizeof(*var_types) * size);
+  char **names = arena_alloc(arena, sizeof(*names) * size);
+  int *offsets = arena_alloc(arena, sizeof(*offsets) * n);
+  if (vars == NULL || var_types == NULL || names == NULL || offsets == NULL)
+    return -1;
+  model_time_indexed_offsets(instance, big_t, offsets);
+
+  // sum_(t) (t + p_j) x_(j t) = T y_(j T-p_j) - sum_(t < T-p_j) y_(j t)
+  memset(var_types, BACKEND_BINARY, sizeof(*var_types) * size);
+  for (size_t j = 0; j < n; j++) {
+    int last = big_t - instance->processing_times[j];
+    for (size_t t = 0; t <= last; t++) {
+      vars[offsets[j] + t] = t < last ? -1 : big_t;
+      char *name = arena_printf(arena, "y_(%ld,%ld)", j + 1, t + 1);
+      if (name == NULL)
+        name = "y_(j,t)";
+      names[offsets[j] + t] = name;
     }
-    if ((result = realloc_constr(&c_index, &c_vals, c_size)) != 0)
-      return result;
+  }
+
+  if ((result = sim->backend->add_vars(instance->model, size, vars, NULL,
+                                       NULL, var_types, names)) != 0) {
+    log_error(sim, result, "add_vars");
+    return result;
+  }
+
+  // Every family is added at once, from rows built in the arena
+  constrs_t constrs;
+  long steps = size - n;
 
-    for (size_t t = 0; t < c_size; t++) {
-      c_index[t] = offset_j + t;
-      c_vals[t] = 1;
+  // y_(j T-p_j) = 1 forall j in J
+  if (constrs_init(arena, &constrs, n, n) != 0)
+    return -1;
+  for (size_t j = 0; j < n; j++) {
+    constrs_add(&constrs, offsets[j] + big_t - instance->processing_times[j],
+                1);
+    constrs_row(&constrs, BACKEND_EQUAL, 1);
+  }
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the jobs")) != 0)
+    return result;
+
+  // y_(j t-1) <= y_(j t) forall j in J, t = 2,...,T-p_j+1
+  if (constrs_init(arena, &constrs, steps, 2 * steps) != 0)
+    return -1;
+  for (size_t j = 0; j < n; j++) {
+    int last = big_t - instance->processing_times[j];
+    for (size_t t = 1; t <= last; t++) {
+      constrs_add(&constrs, offsets[j] + t - 1, 1);
+      constrs_add(&constrs, offsets[j] + t, -1);
+      constrs_row(&constrs, BACKEND_LESS_EQUAL, 0);
     }
-    if ((result = GRBaddconstr(instance->model, c_size, c_index, c_vals,
-                               GRB_EQUAL, 0, NULL)) != 0) {
-      perror(formatted_string("Constraint j = %ld", j));
-      log_error(sim, result, "GRBaddconstr");
-      c_print(c_size, c_index, c_vals, names);
-      return result;
+  }
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints y_(j t-1) <= y_(j t)")) != 0)
+    return result;
+
+  // sum_(j in J) y_(j tau) - y_(j tau-p_j) <= 1 forall tau=1,...,T: the
+  // window of every job slides by one variable from a row to the next
+  if (constrs_init(arena, &constrs, big_t, 2 * (long)size) != 0)
+    return -1;
+  for (size_t tau = 0; tau < big_t; tau++) {
+    for (size_t j = 0; j < n; j++) {
+      int p_j = instance->processing_times[j];
+      // Same jobs as the rows of the time indexed model
+      if (tau > big_t - p_j)
+        continue;
+      constrs_add(&constrs, offsets[j] + tau, 1);
+      if (tau >= p_j)
+        constrs_add(&constrs, offsets[j] + tau - p_j, -1);
     }
-    offset_j += big_t - instance->processing_times[j] + 1;
+    constrs_row(&constrs, BACKEND_LESS_EQUAL, 1);
   }
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the capacity")) != 0)
+    return result;
 
-  for (size_t i = 0; i < size; i++) {
-    free(names[i]);
-    names[i] = NULL;
+  // Release times: y_(j r_j) = 0, the earlier ones follow
+  if (constrs_init(arena, &constrs, n, n) != 0)
+    return -1;
+  for (size_t j = 0; j < n; j++) {
+    if (instance->release_dates[j] > 0)
+      constrs_add(&constrs, offsets[j] + instance->release_dates[j] - 1, 1);
+    constrs_row(&constrs, BACKEND_EQUAL, 0);
   }
-  free(names);
-  names = NULL;
-  free(vars);
-  vars = NULL;
-  free(var_types);
-  var_types = NULL;
-  free(c_index);
-  c_index = NULL;
-  free(c_vals);
-  c_vals = NULL;
+  if ((result = constrs_flush(sim, instance, &constrs,
+                              "Constraints of the release dates")) != 0)
+    return result;
 
   return result;
 }
@@ -658,172 +648,453 @@ int model_time_indexed_create(simulation_t *sim, instance_t *instance) {
 int model_heuristics_predecence_create(simulation_t *sim, instance_t *instance,
                                        int *heuristic_value) {
   int result = 0;
-  int n = instance->number_of_jobs;
-  // Array to keep track of index changes when sorting
-  int *indexes = malloc(sizeof(*indexes) * n);
-  if (indexes == NULL) {
-    perror("Could not allocate memory for indexes");
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
     return -1;
+  *heuristic_value = evaluate(instance, orders->by_release, NULL);
+
+  if ((result = model_precedence_create(sim, instance)) != 0) {
+    perror("Could not create precedence model for heuristic case");
+    return result;
   }
-  for (size_t i = 0; i < n; i++) {
-    indexes[i] = (int)i;
-  }
-  sort(instance, indexes);
+  return model_set_start(sim, instance, Precedence, orders->by_release);
+}
+
+int model_heuristics_positional_create(simulation_t *sim, instance_t *instance,
+                                       int *heuristic_value) {
+  int result = 0;
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return -1;
+  *heuristic_value = evaluate(instance, orders->by_release, NULL);
+
   if ((result = model_positional_create(sim, instance)) != 0) {
     perror("Could not create positional model for heuristic case");
     return result;
   }
-  // Initial solution (some information)
-  for (size_t i = 0; i < n - 1; i++) {
-    for (size_t j = indexes[i] + 1; j < n; j++) {
-      int index = n + (n - 1) * indexes[i] + n - j - 1;
-      if ((result = GRBsetdblattrelement(instance->model, "Start", index,
-                                         (double)1)) != 0) {
-        log_error(sim, result, "GRBsetintattrelement(\"Start\")");
-        return result;
+  return model_set_start(sim, instance, Positional, orders->by_release);
+}
+
+int model_heuristics_time_indexed_create(simulation_t *sim,
+                                         instance_t *instance,
+                                         int *heuristic_value) {
+  int result = 0;
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return -1;
+  *heuristic_value = evaluate(instance, orders->by_release, NULL);
+
+  if ((result = model_time_indexed_create(sim, instance)) != 0) {
+    perror("Could not create time indexed model for heuristic case");
+    return result;
+  }
+  return model_set_start(sim, instance, TimeIndexed, orders->by_release);
+}
+
+int model_set_start(simulation_t *sim, instance_t *instance, solver_t solver,
+                    const int *sequence) {
+  int result = 0;
+  int n = instance->number_of_jobs;
+  int big_t = 0;
+  int *offsets = NULL;
+  int size = model_size(instance, solver, &big_t);
+  // Released with the buffers of the next build
+  arena_t *arena = sim->arena;
+  int *c_hs = arena_alloc(arena, sizeof(*c_hs) * n);
+  int *positions = arena_alloc(arena, sizeof(*positions) * n);
+  int *repaired = arena_alloc(arena, sizeof(*repaired) * n);
+  double *start = arena_alloc(arena, sizeof(*start) * size);
+  if (c_hs == NULL || positions == NULL || repaired == NULL || start == NULL)
+    return -1;
+  // x_(j t) of job j start after the T - p_i + 1 variables of every i < j
+  if (solver_formulation(solver) >= TimeIndexed) {
+    if ((offsets = arena_alloc(arena, sizeof(*offsets) * n)) == NULL)
+      return -1;
+    model_time_indexed_offsets(instance, big_t, offsets);
+  }
+  memset(start, 0, sizeof(*start) * size);
+  // Repaired to agree with the variables fixed by `model_dominance`
+  memcpy(repaired, sequence, sizeof(*repaired) * n);
+  if (dominance_repair(instance, repaired) == 0)
+    sequence = repaired;
+  evaluate(instance, sequence, c_hs);
+  for (size_t h = 0; h < n; h++) {
+    positions[sequence[h]] = h;
+  }
+
+  switch (solver_formulation(solver)) {
+  case Precedence:
+    // C_j, then x_(i j) = 1 when i precedes j
+    for (size_t j = 0; j < n; j++) {
+      start[j] = c_hs[positions[j]];
+    }
+    size_t index = n;
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = i + 1; j < n; j++) {
+        start[index++] = positions[i] < positions[j] ? 1 : 0;
       }
     }
+    break;
+  case Positional:
+    // C_[h], then x_(j h) = 1 when job j is in position h
+    for (size_t h = 0; h < n; h++) {
+      start[h] = c_hs[h];
+      start[n + sequence[h] * n + h] = 1;
+    }
+    break;
+  case TimeIndexed:
+    // x_(j t) = 1 where t is the start time of j
+    for (size_t h = 0; h < n; h++) {
+      int j = sequence[h];
+      start[offsets[j] + c_hs[h] - instance->processing_times[j]] = 1;
+    }
+    break;
+  case CompactTimeIndexed:
+    // y_(j t) = 1 from the start time of j on
+    for (size_t h = 0; h < n; h++) {
+      int j = sequence[h];
+      int p_j = instance->processing_times[j];
+      for (size_t t = c_hs[h] - p_j; t <= big_t - p_j; t++) {
+        start[offsets[j] + t] = 1;
+      }
+    }
+    break;
+  default:
+    break;
   }
+
+  if ((result = sim->backend->set_dbl_array(instance->model, ATTR_START, 0,
+                                            size, start)) != 0)
+    log_error(sim, result, "set_dbl_array(\"Start\")");
   return result;
 }
 
-int model_heuristics_positional_create(simulation_t *sim, instance_t *instance,
-                                       int *heuristic_value) {
+int model_dominance(simulation_t *sim, instance_t *instance, solver_t solver) {
   int result = 0;
   int n = instance->number_of_jobs;
-  // Array to keep track of index changes when sorting
-  int *indexes = malloc(sizeof(*indexes) * n);
-  if (indexes == NULL) {
-    perror("Could not allocate memory for indexes");
+  int big_t = 0;
+  int size = model_size(instance, solver, &big_t);
+  // Counted without a simulation, in an arena of its own
+  arena_t *arena = sim != NULL ? sim->arena : arena_init(0);
+  if (arena == NULL)
+    return -1;
+  int *offsets = arena_alloc(arena, sizeof(*offsets) * n);
+  double *lb = arena_alloc(arena, sizeof(*lb) * size);
+  double *ub = arena_alloc(arena, sizeof(*ub) * size);
+  dominance_t *dominance = dominance_init(instance);
+  if (offsets == NULL || lb == NULL || ub == NULL || dominance == NULL) {
+    perror("Could not allocate memory for dominance bounds");
+    dominance_free(dominance);
+    if (sim == NULL)
+      arena_free(arena);
     return -1;
   }
-  for (size_t i = 0; i < n; i++) {
-    indexes[i] = (int)i;
+  if (solver_formulation(solver) >= TimeIndexed)
+    model_time_indexed_offsets(instance, big_t, offsets);
+  // Completion times are unbounded, assignments binary
+  int completions = solver_formulation(solver) >= TimeIndexed ? 0 : n;
+  for (size_t v = 0; v < size; v++) {
+    lb[v] = 0;
+    ub[v] = v < completions ? BACKEND_INFINITY : 1;
+  }
+
+  int fixed = 0;
+  switch (solver_formulation(solver)) {
+  case Precedence: {
+    // x_(i j) = 1 when i precedes j
+    size_t index = n;
+    for (size_t i = 0; i < n; i++) {
+      for (size_t j = i + 1; j < n; j++) {
+        if (dominance_before(dominance, i, j)) {
+          lb[index] = 1;
+          fixed += 1;
+        } else if (dominance_before(dominance, j, i)) {
+          ub[index] = 0;
+          fixed += 1;
+        }
+        index += 1;
+      }
+    }
+    break;
   }
-  sort(instance, indexes);
-  int *c_hs = malloc(sizeof(*c_hs) * n);
-  if (c_hs == NULL) {
-    perror("Could not allocate memory for C_js");
-    return -1;
+  case Positional:
+    // Job j has its predecessors before and its successors after it
+    for (size_t j = 0; j < n; j++) {
+      for (size_t h = 0; h < n; h++) {
+        if (h < dominance->predecessors[j] ||
+            h >= n - dominance->successors[j]) {
+          ub[n + j * n + h] = 0;
+          fixed += 1;
+        }
+      }
+    }
+    break;
+  case TimeIndexed:
+    // Starts before r_j are already excluded by the release constraints
+    for (size_t j = 0; j < n; j++) {
+      int p_j = instance->processing_times[j];
+      int last = big_t - p_j - dominance->tails[j];
+      for (size_t t = 0; t <= big_t - p_j; t++) {
+        if (t < dominance->heads[j] || t > last) {
+          ub[offsets[j] + t] = 0;
+          fixed += t >= instance->release_dates[j];
+        }
+      }
+    }
+    break;
+  case CompactTimeIndexed:
+    // Not started before head_j, started by T - p_j - tail_j. Variables
+    // before r_j and the last one are already fixed by their constraints
+    for (size_t j = 0; j < n; j++) {
+      int p_j = instance->processing_times[j];
+      int last = big_t - p_j - dominance->tails[j];
+      for (size_t t = 0; t <= big_t - p_j; t++) {
+        if (t < dominance->heads[j]) {
+          ub[offsets[j] + t] = 0;
+          fixed += t >= instance->release_dates[j];
+        } else if (t >= last) {
+          lb[offsets[j] + t] = 1;
+          fixed += t < big_t - p_j;
+        }
+      }
+    }
+    break;
+  default:
+    break;
   }
-  c_hs[0] = instance->release_dates[0] + instance->processing_times[0];
-  *heuristic_value = c_hs[0];
-  for (size_t i = 1; i < n; i++) {
-    // Current job start when previous job finished
-    int s_h = c_hs[i - 1];
-    // The next job is not released -> adding idle time until it's released
-    if (s_h < instance->release_dates[i])
-      s_h += instance->release_dates[i] - c_hs[i - 1];
-    int c_h = s_h + instance->processing_times[i];
 
-    c_hs[i] = c_h;
-    *heuristic_value += c_h;
+  if (sim != NULL && instance->model != NULL && fixed > 0 &&
+      ((result = sim->backend->set_dbl_array(instance->model, ATTR_LB, 0, size,
+                                             lb)) != 0 ||
+       (result = sim->backend->set_dbl_array(instance->model, ATTR_UB, 0, size,
+                                             ub)) != 0)) {
+    log_error(sim, result, "set_dbl_array(\"LB\", \"UB\")");
+    fixed = -1;
   }
-  if ((result = model_positional_create(sim, instance)) != 0) {
-    perror("Could not create positional model for heuristic case");
+
+  dominance_free(dominance);
+  dominance = NULL;
+  if (sim == NULL)
+    arena_free(arena);
+  return fixed;
+}
+
+int model_sequence(simulation_t *sim, instance_t *instance, solver_t solver,
+                   int *sequence) {
+  int result = 0;
+  int n = instance->number_of_jobs;
+  int big_t = 0;
+  int *offsets = NULL;
+  int size = model_size(instance, solver, &big_t);
+
+  double *x = malloc(sizeof(*x) * size);
+  int *keys = malloc(sizeof(*keys) * n);
+  if (solver_formulation(solver) >= TimeIndexed &&
+      (offsets = malloc(sizeof(*offsets) * n)) != NULL)
+    model_time_indexed_offsets(instance, big_t, offsets);
+  if (x == NULL || keys == NULL ||
+      (solver_formulation(solver) >= TimeIndexed && offsets == NULL)) {
+    perror("Could not allocate memory for the solution");
+    free(x);
+    free(keys);
+    free(offsets);
+    return -1;
+  }
+  if ((result = sim->backend->get_dbl_array(instance->model, ATTR_X, 0, size,
+                                            x)) != 0) {
+    log_error(sim, result, "get_dbl_array(\"X\")");
+    free(x);
+    free(keys);
+    free(offsets);
     return result;
   }
 
-  // Initial solution value for C_[h] variables
-  for (size_t i = 0; i < n; i++) {
-    if ((result = GRBsetdblattrelement(instance->model, "Start", i,
-                                       (double)c_hs[i])) != 0) {
-      log_error(sim, result, "GRBsetdblattrelement(\"Start\")");
-      return result;
-    }
+  // Jobs sorted by completion (precedence), position or start time
+  for (size_t j = 0; j < n; j++) {
+    keys[j] = -1;
+    sequence[j] = j;
   }
-  for (size_t i = 0; i < n; i++) {
-    int index = n + indexes[i] * instance->number_of_jobs + i;
-    if ((result = GRBsetdblattrelement(instance->model, "Start", index,
-                                       (double)1)) != 0) {
-      log_error(sim, result, "GRBsetdblattrelement(\"Start\")");
-      return result;
+  switch (solver_formulation(solver)) {
+  case Precedence:
+    for (size_t j = 0; j < n; j++) {
+      keys[j] = x[j] + 0.5;
+    }
+    break;
+  case Positional:
+    for (size_t j = 0; j < n; j++) {
+      for (size_t h = 0; h < n; h++) {
+        if (x[n + j * n + h] > 0.5)
+          keys[j] = h;
+      }
+    }
+    break;
+  case TimeIndexed:
+    for (size_t j = 0; j < n; j++) {
+      int slots = big_t - instance->processing_times[j] + 1;
+      for (size_t t = 0; t < slots; t++) {
+        if (x[offsets[j] + t] > 0.5)
+          keys[j] = t;
+      }
+    }
+    break;
+  case CompactTimeIndexed:
+    // First slot it has started by
+    for (size_t j = 0; j < n; j++) {
+      int slots = big_t - instance->processing_times[j] + 1;
+      for (size_t t = 0; t < slots && keys[j] < 0; t++) {
+        if (x[offsets[j] + t] > 0.5)
+          keys[j] = t;
+      }
     }
+    break;
+  default:
+    break;
+  }
+  for (size_t j = 0; j < n && result == 0; j++) {
+    if (keys[j] < 0)
+      result = -1;
   }
+  if (result == 0)
+    result = radix_sort(keys, sequence, n);
+
+  free(x);
+  x = NULL;
+  free(keys);
+  keys = NULL;
+  free(offsets);
+  offsets = NULL;
   return result;
 }
 
-int model_heuristics_time_indexed_create(simulation_t *sim,
-                                         instance_t *instance,
-                                         int *heuristic_value) {
-  int result = 0;
-  int n = instance->number_of_jobs;
-
-  int big_t = 1;
+long model_size(const instance_t *instance, solver_t solver, int *big_t) {
+  // In long: the sizes of the largest instances do not fit an int
+  long n = instance->number_of_jobs;
+  // T = sum_(j in J) p_j + max{r_j} + 1
+  *big_t = 1;
   int max_r_j = 0;
   for (size_t j = 0; j < n; j++) {
-    big_t += instance->processing_times[j];
+    *big_t += instance->processing_times[j];
     if (instance->release_dates[j] > max_r_j)
       max_r_j = instance->release_dates[j];
   }
-  big_t += max_r_j;
+  *big_t += max_r_j;
 
-  int *offsets = malloc(sizeof(*offsets) * n);
-  if (offsets == NULL) {
-    perror("Could not allocate memory for offsets");
-    return -1;
-  }
-  int offset_j = 0;
-  for (size_t i = 0; i < n; i++) {
-    offset_j += big_t - instance->processing_times[i] + 1;
-    offsets[i] = offset_j;
-  }
-  // Array to keep track of index changes when sorting
-  int *indexes = malloc(sizeof(*indexes) * n);
-  if (indexes == NULL) {
-    perror("Could not allocate memory for indexes");
-    return -1;
-  }
-  for (size_t i = 0; i < n; i++) {
-    indexes[i] = (int)i;
+  switch (solver_formulation(solver)) {
+  case Precedence:
+    return n + n * (n - 1) / 2;
+  case Positional:
+    return n + n * n;
+  default: {
+    long size = 0;
+    for (size_t j = 0; j < n; j++) {
+      size += *big_t - instance->processing_times[j] + 1;
+    }
+    return size;
   }
-  sort(instance, indexes);
-  if ((result = model_time_indexed_create(sim, instance)) != 0) {
-    perror("Could not create time indexed model for heuristic case");
-    return result;
   }
+}
 
-  // Initial solution
-  for (size_t i = 0; i < n; i++) {
-    int index = instance->release_dates[i];
-    if (indexes[i] != 0) {
-      index = offsets[i - 1] + instance->release_dates[i];
+void model_counts(const instance_t *instance, solver_t solver,
+                  long *variables, long *nonzeros) {
+  long n = instance->number_of_jobs;
+  int big_t = 0;
+  *variables = model_size(instance, solver, &big_t);
+  switch (solver_formulation(solver)) {
+  case Precedence:
+    // C_j >= p_j + r_j, then 3 nonzeros in both constraints of every pair
+    *nonzeros = n + 3 * n * (n - 1);
+    break;
+  case Positional:
+    // Assignments, C_1, C_[h] after C_[h - 1], release dates and C_[h] >= 0
+    *nonzeros = 2 * n * n + (n + 1) + (n - 1) * (n + 2) + n * (n + 1) + n;
+    break;
+  case TimeIndexed:
+    // Assignments, release dates and the capacity constraints of the tau
+    // jobs can still be started at: min{tau + 1, p_j} starts each
+    *nonzeros = 0;
+    for (size_t j = 0; j < n; j++) {
+      long p_j = instance->processing_times[j];
+      long starts = big_t - p_j + 1;
+      long ramp = starts < p_j ? starts : p_j;
+      *nonzeros += starts + instance->release_dates[j] +
+                   ramp * (ramp + 1) / 2 + (starts - ramp) * p_j;
     }
-    if ((result = GRBsetdblattrelement(instance->model, "Start", index,
-                                       (double)1)) != 0) {
-      log_error(sim, result, "GRBsetintattrelement(\"Start\")");
-      return result;
+    break;
+  case CompactTimeIndexed:
+    // Assignments, y_(j t-1) <= y_(j t), a release date and, in the capacity
+    // constraint of tau, y_(j tau) and y_(j tau-p_j) once tau >= p_j
+    *nonzeros = 0;
+    for (size_t j = 0; j < n; j++) {
+      long p_j = instance->processing_times[j];
+      long starts = big_t - p_j + 1;
+      long ends = starts > p_j ? starts - p_j : 0;
+      *nonzeros += 1 + 2 * (starts - 1) + (instance->release_dates[j] > 0) +
+                   starts + ends;
     }
+    break;
+  default:
+    *nonzeros = 0;
   }
-  return result;
 }
 
-void c_print(int size, int *index, double *vals, char **names) {
-  for (size_t i = 0; i < size; i++) {
-    char *sign = "+";
-    if (vals[i] < 0)
-      sign = "";
-    char *multiplier = "";
-    printf("%s%.2f %s ", sign, vals[i], names[index[i]]);
-
-    if (i == size - 1)
-      printf("");
+void model_time_indexed_offsets(const instance_t *instance, int big_t,
+                                int *offsets) {
+  int n = instance->number_of_jobs;
+  offsets[0] = 0;
+  for (size_t j = 1; j < n; j++) {
+    offsets[j] = offsets[j - 1] + big_t - instance->processing_times[j - 1] + 1;
   }
-  printf("\n");
 }
 
-int realloc_constr(int **constr_index, double **constr_vals, size_t size) {
-  *constr_index = realloc(*constr_index, sizeof(**constr_index) * size);
-  if (*constr_index == NULL) {
-    perror("Could not realloc constr_index");
-    return -1;
-  }
 
-  *constr_vals = realloc(*constr_vals, sizeof(**constr_vals) * size);
-  if (*constr_vals == NULL) {
-    perror("Could not realloc constr_vals");
+int constrs_init(arena_t *arena, constrs_t *constrs, long rows,
+                 long nonzeros) {
+  // The backends count in int
+  if (rows > INT_MAX || nonzeros > INT_MAX) {
+    fprintf(stderr, "Constraint family of %ld rows and %ld nonzeros too "
+                    "large\n", rows, nonzeros);
     return -1;
   }
-
+  constrs->count = 0;
+  constrs->nonzeros = 0;
+  constrs->end = 0;
+  constrs->begins = arena_alloc(arena, sizeof(*constrs->begins) * rows);
+  constrs->indexes = arena_alloc(arena, sizeof(*constrs->indexes) * nonzeros);
+  constrs->values = arena_alloc(arena, sizeof(*constrs->values) * nonzeros);
+  constrs->senses = arena_alloc(arena, sizeof(*constrs->senses) * rows);
+  constrs->rhs = arena_alloc(arena, sizeof(*constrs->rhs) * rows);
+  if (constrs->begins == NULL || constrs->indexes == NULL ||
+      constrs->values == NULL || constrs->senses == NULL ||
+      constrs->rhs == NULL)
+    return -1;
   return 0;
 }
+
+void constrs_add(constrs_t *constrs, int index, double value) {
+  constrs->indexes[constrs->nonzeros] = index;
+  constrs->values[constrs->nonzeros++] = value;
+}
+
+void constrs_row(constrs_t *constrs, char sense, double rhs) {
+  // A row without nonzeros is left out
+  if (constrs->nonzeros == constrs->end)
+    return;
+  constrs->begins[constrs->count] = constrs->end;
+  constrs->senses[constrs->count] = sense;
+  constrs->rhs[constrs->count++] = rhs;
+  constrs->end = constrs->nonzeros;
+}
+
+int constrs_flush(simulation_t *sim, instance_t *instance, constrs_t *constrs,
+                  const char *family) {
+  int result = 0;
+  if (constrs->count > 0 &&
+      (result = sim->backend->add_constrs(
+           instance->model, constrs->count, constrs->nonzeros, constrs->begins,
+           constrs->indexes, constrs->values, constrs->senses,
+           constrs->rhs)) != 0) {
+    perror(family);
+    log_error(sim, result, "add_constrs");
+  }
+  return result;
+}
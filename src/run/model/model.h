@@ -16,6 +16,10 @@ solution_t *model_optimize(simulation_t *simulation, int instance_number,
 int model_precedence_create(simulation_t *simulation, instance_t *instance);
 int model_positional_create(simulation_t *simulation, instance_t *instance);
 int model_time_indexed_create(simulation_t *simulation, instance_t *instance);
+// Time indexed model on y_(j t) = x_(j 1) + ... + x_(j t): the same LP
+// relaxation, with 2 nonzeros a job in every capacity row instead of p_j
+int model_compact_time_indexed_create(simulation_t *simulation,
+                                      instance_t *instance);
 int model_heuristics_predecence_create(simulation_t *sim, instance_t *instance,
                                        int *heuristic_value);
 int model_heuristics_positional_create(simulation_t *simulation,
@@ -24,3 +28,19 @@ int model_heuristics_positional_create(simulation_t *simulation,
 int model_heuristics_time_indexed_create(simulation_t *simulation,
                                          instance_t *instance,
                                          int *heuristic_value);
+// Set the MIP start of the model of `instance` to the schedule processing
+// the jobs in `sequence` order (every variable is given a value)
+int model_set_start(simulation_t *sim, instance_t *instance, solver_t solver,
+                    const int *sequence);
+// Fix the variables contradicting the orderings of run/dominance.h: x_(i j)
+// of the precedence model, (job, position) pairs of the positional one and
+// start times out of [head_j, T - p_j - tail_j] of the time indexed ones.
+// Bounds are set only with a simulation, returns how many variables it fixed
+int model_dominance(simulation_t *sim, instance_t *instance, solver_t solver);
+// Variables and nonzeros of the model of `instance`, without building it
+void model_counts(const instance_t *instance, solver_t solver,
+                  long *variables, long *nonzeros);
+// Sequence of the jobs in the best solution found for the model of
+// `instance`, -1 if it cannot be decoded
+int model_sequence(simulation_t *sim, instance_t *instance, solver_t solver,
+                   int *sequence);
@@ -0,0 +1,85 @@
+#include "profile.h"
+#include "../generate/generate.h"
+#include "../stats/stats.h"
+#include "../utils/utils.h"
+#include "backend/backend.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+vector_t *profiles_load(const char *filename) {
+  vector_t *profiles = vector_init();
+  if (profiles == NULL)
+    return NULL;
+  FILE *fp = fopen(filename, "r");
+  if (fp == NULL)
+    return profiles;
+
+  // Skipping first line
+  fscanf(fp, "%*[^\n]\n");
+  profile_t read;
+  int solver = 0;
+  while (fscanf(fp, "%d,%d,%d,%d,%d,%lf,%d\n", &solver, &read.jobs_class,
+                &read.mip_focus, &read.presolve, &read.cuts, &read.heuristics,
+                &read.method) == 7) {
+    profile_t *profile = malloc(sizeof(*profile));
+    if (profile == NULL) {
+      perror("Could not allocate memory for profile");
+      fclose(fp);
+      return profiles;
+    }
+    *profile = read;
+    profile->solver = solver;
+    if (vector_add(profiles, (void **)&profile) != 0)
+      break;
+  }
+  fclose(fp);
+  return profiles;
+}
+
+int profiles_save(const char *filename, vector_t *profiles) {
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL) {
+    perror_formatted("Could not open %s", filename);
+    return -1;
+  }
+  fprintf(fp, "Solver,JobsClass,MIPFocus,Presolve,Cuts,Heuristics,Method\n");
+  for (size_t k = 0; k < profiles->length; k++) {
+    const profile_t *p = profiles->values[k];
+    fprintf(fp, "%d,%d,%d,%d,%d,%.2f,%d\n", p->solver, p->jobs_class,
+            p->mip_focus, p->presolve, p->cuts, p->heuristics, p->method);
+  }
+  fclose(fp);
+  return 0;
+}
+
+const profile_t *profile_find(vector_t *profiles, solver_t solver,
+                              const instance_t *instance) {
+  if (profiles == NULL)
+    return NULL;
+  solver = solver_formulation(solver);
+  int jobs_class = stats_class(instance->number_of_jobs, NUMBER_OF_JOBS_UL);
+  for (size_t k = 0; k < profiles->length; k++) {
+    const profile_t *profile = profiles->values[k];
+    if (profile->solver == solver && profile->jobs_class == jobs_class)
+      return profile;
+  }
+  return NULL;
+}
+
+int profile_apply(simulation_t *sim, instance_t *instance,
+                  const profile_t *profile) {
+  int result = 0;
+  const backend_t *backend = sim->backend;
+  if ((result = backend->set_int_param(instance->model, PARAM_MIP_FOCUS,
+                                       profile->mip_focus)) != 0 ||
+      (result = backend->set_int_param(instance->model, PARAM_PRESOLVE,
+                                       profile->presolve)) != 0 ||
+      (result = backend->set_int_param(instance->model, PARAM_CUTS,
+                                       profile->cuts)) != 0 ||
+      (result = backend->set_dbl_param(instance->model, PARAM_HEURISTICS,
+                                       profile->heuristics)) != 0 ||
+      (result = backend->set_int_param(instance->model, PARAM_METHOD,
+                                       profile->method)) != 0)
+    log_error(sim, result, "profile_apply");
+  return result;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define PROFILE_FILE "output/profiles.csv"
+
+// Solver parameters of a (formulation, size class): the heuristic variants
+// use the profile of their formulation
+typedef struct {
+  solver_t solver;
+  int jobs_class; // Upper limit of the number of jobs (see stats_class)
+  int mip_focus;
+  int presolve;
+  int cuts;
+  double heuristics;
+  int method;
+} profile_t;
+
+// Gurobi defaults
+#define PROFILE_DEFAULT(s, c)                                                  \
+  (profile_t) {                                                                \
+    .solver = s, .jobs_class = c, .mip_focus = 0, .presolve = -1, .cuts = -1, \
+    .heuristics = 0.05, .method = -1                                           \
+  }
+
+// Profiles saved in `filename`, empty when it does not exist
+vector_t *profiles_load(const char *filename);
+int profiles_save(const char *filename, vector_t *profiles);
+// Profile of the class of `instance` solved by `solver`, NULL if not tuned
+const profile_t *profile_find(vector_t *profiles, solver_t solver,
+                              const instance_t *instance);
+// Set the parameters of `profile` on the model of `instance`
+int profile_apply(simulation_t *sim, instance_t *instance,
+                  const profile_t *profile);
@@ -0,0 +1,387 @@
+#include "refine.h"
+#include "../utils/evaluate.h"
+#include "../utils/utils.h"
+#include "backend/backend.h"
+#include "model/model.h"
+#include "schedule.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Full resolution model with job j starting in [lo_j, hi_j]
+typedef struct {
+  int *lo;
+  int *hi;
+  int *offsets; // First variable of every job
+  int size;
+} window_t;
+
+int refine_coarse(simulation_t *sim, instance_t *instance, solver_t solver,
+                  int k, double limit, int *sequence);
+int refine_window(simulation_t *sim, instance_t *instance, window_t *window,
+                  const int *starts, double limit, int *found);
+int refine_constrs(simulation_t *sim, void *model, instance_t *instance,
+                   window_t *window);
+int refine_big_t(const instance_t *instance);
+
+long refine_size(const instance_t *instance) {
+  int big_t = refine_big_t(instance);
+  long size = 0;
+  for (size_t j = 0; j < instance->number_of_jobs; j++) {
+    size += big_t - instance->processing_times[j] + 1;
+  }
+  return size;
+}
+
+solution_t *refine_solve(simulation_t *sim, instance_t *instance,
+                         solver_t solver, double limit, int *sequence) {
+  int n = instance->number_of_jobs;
+  int big_t = refine_big_t(instance);
+  measure_t start, now;
+  measure_now(&start);
+
+  // n T / k variables on the coarse grid
+  int k = ceil((double)refine_size(instance) / REFINE_COARSE_VARS);
+  if (k < 1)
+    k = 1;
+  if (refine_coarse(sim, instance, solver, k, limit * REFINE_COARSE_SHARE,
+                    sequence) != 0)
+    return NULL;
+
+  solution_t *solution = malloc(sizeof(*solution));
+  double *values = malloc(sizeof(*values) * n);
+  int *c_hs = malloc(sizeof(*c_hs) * n);
+  int *starts = malloc(sizeof(*starts) * n);
+  int *found = malloc(sizeof(*found) * n);
+  int *candidate = malloc(sizeof(*candidate) * n);
+  window_t window = {.lo = malloc(sizeof(int) * n),
+                     .hi = malloc(sizeof(int) * n),
+                     .offsets = malloc(sizeof(int) * n)};
+  if (solution == NULL || values == NULL || c_hs == NULL || starts == NULL ||
+      found == NULL || candidate == NULL || window.lo == NULL ||
+      window.hi == NULL || window.offsets == NULL) {
+    perror("Could not allocate memory for refinement");
+    free(solution);
+    solution = NULL;
+  }
+
+  long long best = solution != NULL ? evaluate(instance, sequence, c_hs) : -1;
+  int half = REFINE_WINDOW * k;
+  for (size_t iteration = 0; solution != NULL && iteration < REFINE_ITERATIONS;
+       iteration++) {
+    measure_now(&now);
+    double remaining = limit - (now.wall - start.wall);
+    if (remaining < SCHEDULE_MIN_LIMIT)
+      break;
+    // Windows around the best schedule so far
+    window.size = 0;
+    for (size_t h = 0; h < n; h++) {
+      int j = sequence[h];
+      int p_j = instance->processing_times[j];
+      starts[j] = c_hs[h] - p_j;
+      window.lo[j] = starts[j] - half;
+      if (window.lo[j] < instance->release_dates[j])
+        window.lo[j] = instance->release_dates[j];
+      window.hi[j] = starts[j] + half;
+      if (window.hi[j] > big_t - p_j)
+        window.hi[j] = big_t - p_j;
+    }
+    for (size_t j = 0; j < n; j++) {
+      window.offsets[j] = window.size;
+      window.size += window.hi[j] - window.lo[j] + 1;
+    }
+    if (refine_window(sim, instance, &window, starts, remaining, found) != 0)
+      break;
+
+    for (size_t j = 0; j < n; j++) {
+      candidate[j] = j;
+    }
+    if (radix_sort(found, candidate, n) != 0)
+      break;
+    long long value = evaluate(instance, candidate, NULL);
+    // Jobs on a border may be better off further: the windows move
+    int border = 0;
+    for (size_t j = 0; j < n; j++) {
+      int p_j = instance->processing_times[j];
+      if ((found[j] == window.lo[j] &&
+           window.lo[j] > instance->release_dates[j]) ||
+          (found[j] == window.hi[j] && window.hi[j] < big_t - p_j))
+        border = 1;
+    }
+    if (value >= best)
+      break;
+    best = value;
+    memcpy(sequence, candidate, sizeof(*sequence) * n);
+    evaluate(instance, sequence, c_hs);
+    if (!border)
+      break;
+  }
+
+  if (solution != NULL) {
+    measure_now(&now);
+    for (size_t h = 0; h < n; h++) {
+      values[sequence[h]] = c_hs[h];
+    }
+    memset(solution, 0, sizeof(*solution));
+    solution->size = n;
+    solution->solver = solver;
+    solution->status = STATUS_REFINED;
+    solution->runtime = now.wall - start.wall;
+    solution->objective_value = best;
+    solution->bound = -1;
+    solution->gap = -1;
+    solution->values = values;
+    solution->heuristic_value = -1;
+    solution->memory = -1;
+  } else {
+    free(values);
+  }
+  free(c_hs);
+  free(starts);
+  free(found);
+  free(candidate);
+  free(window.lo);
+  free(window.hi);
+  free(window.offsets);
+  return solution;
+}
+
+int refine_coarse(simulation_t *sim, instance_t *instance, solver_t solver,
+                  int k, double limit, int *sequence) {
+  int result = 0;
+  int n = instance->number_of_jobs;
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return -1;
+  // Without a coarse solution the earliest release date order is refined
+  memcpy(sequence, orders->by_release, sizeof(*sequence) * n);
+
+  vector_t *instances = vector_init();
+  instance_t *coarse = malloc(sizeof(*coarse));
+  if (instances == NULL || coarse == NULL) {
+    perror("Could not allocate memory for the coarse instance");
+    free(coarse);
+    vector_free(instances);
+    return -1;
+  }
+  coarse->number_of_jobs = n;
+  coarse->processing_times = malloc(sizeof(int) * n);
+  coarse->release_dates = malloc(sizeof(int) * n);
+  coarse->orders = NULL;
+  coarse->model = NULL;
+  if (coarse->processing_times == NULL || coarse->release_dates == NULL ||
+      vector_add(instances, (void **)&coarse) != 0) {
+    perror("Could not allocate memory for the coarse instance");
+    free(coarse->processing_times);
+    free(coarse->release_dates);
+    free(coarse);
+    vector_free(instances);
+    return -1;
+  }
+  // Rounded to the nearest slot, every job takes at least one
+  for (size_t j = 0; j < n; j++) {
+    coarse->processing_times[j] = (instance->processing_times[j] + k / 2) / k;
+    if (coarse->processing_times[j] < 1)
+      coarse->processing_times[j] = 1;
+    coarse->release_dates[j] = (instance->release_dates[j] + k / 2) / k;
+  }
+
+  simulation_t coarse_sim = *sim;
+  coarse_sim.instances = instances;
+  coarse_sim.progress = NULL;
+  int heuristic_value = -1;
+  if ((result = model_init(&coarse_sim, 0, solver, &heuristic_value)) == 0 &&
+      (result = sim->backend->set_dbl_param(coarse->model, PARAM_TIME_LIMIT,
+                                            limit)) == 0) {
+    solution_t *solution = model_optimize(&coarse_sim, 0, solver);
+    if (solution != NULL && solution->objective_value >= 0 &&
+        model_sequence(&coarse_sim, coarse, solver, sequence) != 0)
+      memcpy(sequence, orders->by_release, sizeof(*sequence) * n);
+    if (solution != NULL) {
+      free(solution->values);
+      free(solution);
+    }
+  }
+  if (coarse->model != NULL)
+    sim->backend->model_free(coarse->model);
+  coarse->model = NULL;
+
+  instance_orders_free(coarse);
+  free(coarse->processing_times);
+  free(coarse->release_dates);
+  vector_free(instances);
+  return result;
+}
+
+int refine_window(simulation_t *sim, instance_t *instance, window_t *window,
+                  const int *starts, double limit, int *found) {
+  int result = 0;
+  int n = instance->number_of_jobs;
+  const backend_t *backend = sim->backend;
+  void *model = NULL;
+  double *obj = malloc(sizeof(*obj) * window->size);
+  double *x = malloc(sizeof(*x) * window->size);
+  char *types = malloc(sizeof(*types) * window->size);
+  if (obj == NULL || x == NULL || types == NULL) {
+    perror("Could not allocate memory for the window model");
+    free(obj);
+    free(x);
+    free(types);
+    return -1;
+  }
+  // x_(j t) for t in [lo_j, hi_j], started from the schedule being refined
+  for (size_t j = 0; j < n; j++) {
+    for (int t = window->lo[j]; t <= window->hi[j]; t++) {
+      int v = window->offsets[j] + t - window->lo[j];
+      obj[v] = t + instance->processing_times[j];
+      x[v] = t == starts[j];
+      types[v] = BACKEND_BINARY;
+    }
+  }
+
+  if ((result = backend->model_init(sim->env, &model, "refine")) != 0 ||
+      (result = backend->set_dbl_param(model, PARAM_TIME_LIMIT, limit)) !=
+          0 ||
+      (result = backend->add_vars(model, window->size, obj, NULL, NULL, types,
+                                  NULL)) != 0 ||
+      (result = refine_constrs(sim, model, instance, window)) != 0 ||
+      (result = backend->set_dbl_array(model, ATTR_START, 0, window->size,
+                                       x)) != 0 ||
+      (result = backend->optimize(model)) != 0) {
+    log_error(sim, result, "refine_window");
+  }
+
+  int solution_count = 0;
+  if (result == 0 &&
+      (result = backend->get_int_attr(model, ATTR_SOL_COUNT,
+                                      &solution_count)) == 0 &&
+      solution_count > 0 &&
+      (result = backend->get_dbl_array(model, ATTR_X, 0, window->size, x)) ==
+          0) {
+    for (size_t j = 0; j < n; j++) {
+      found[j] = -1;
+      for (int t = window->lo[j]; t <= window->hi[j]; t++) {
+        if (x[window->offsets[j] + t - window->lo[j]] > 0.5)
+          found[j] = t;
+      }
+      if (found[j] < 0)
+        result = -1;
+    }
+  } else if (result == 0) {
+    result = 1;
+  }
+
+  if (model != NULL)
+    backend->model_free(model);
+  free(obj);
+  free(x);
+  free(types);
+  return result;
+}
+
+int refine_constrs(simulation_t *sim, void *model, instance_t *instance,
+                   window_t *window) {
+  int result = 0;
+  int n = instance->number_of_jobs;
+  int first = window->lo[0], last = 0;
+  for (size_t j = 0; j < n; j++) {
+    if (window->lo[j] < first)
+      first = window->lo[j];
+    if (window->hi[j] > last)
+      last = window->hi[j];
+  }
+  // A start slot of some window is a time every overlap goes through
+  char *starts = calloc(last - first + 1, sizeof(*starts));
+  int *begins = malloc(sizeof(*begins) * (n + last - first + 1));
+  char *senses = malloc(sizeof(*senses) * (n + last - first + 1));
+  double *rhs = malloc(sizeof(*rhs) * (n + last - first + 1));
+  size_t capacity = window->size * 2;
+  int *indexes = malloc(sizeof(*indexes) * capacity);
+  double *values = malloc(sizeof(*values) * capacity);
+  if (starts == NULL || begins == NULL || senses == NULL || rhs == NULL ||
+      indexes == NULL || values == NULL) {
+    perror("Could not allocate memory for the window constraints");
+    result = -1;
+  }
+
+  int rows = 0;
+  size_t nonzeros = 0;
+  // sum_t x_(j t) = 1 forall j in J
+  for (size_t j = 0; j < n && result == 0; j++) {
+    begins[rows] = nonzeros;
+    senses[rows] = BACKEND_EQUAL;
+    rhs[rows++] = 1;
+    for (int t = window->lo[j]; t <= window->hi[j]; t++) {
+      indexes[nonzeros] = window->offsets[j] + t - window->lo[j];
+      values[nonzeros++] = 1;
+      starts[t - first] = 1;
+    }
+  }
+  // sum_j sum_(t = tau - p_j + 1)^tau x_(j t) <= 1 at every start slot tau
+  // where two jobs can overlap
+  for (int tau = first; tau <= last && result == 0; tau++) {
+    if (!starts[tau - first])
+      continue;
+    size_t row = nonzeros;
+    int jobs = 0;
+    for (size_t j = 0; j < n; j++) {
+      int from = tau - instance->processing_times[j] + 1;
+      if (from < window->lo[j])
+        from = window->lo[j];
+      int to = tau < window->hi[j] ? tau : window->hi[j];
+      if (from > to)
+        continue;
+      jobs += 1;
+      if (nonzeros + to - from + 1 > capacity) {
+        capacity = (nonzeros + to - from + 1) * 2;
+        int *grown_indexes = realloc(indexes, sizeof(*indexes) * capacity);
+        double *grown_values = realloc(values, sizeof(*values) * capacity);
+        if (grown_indexes != NULL)
+          indexes = grown_indexes;
+        if (grown_values != NULL)
+          values = grown_values;
+        if (grown_indexes == NULL || grown_values == NULL) {
+          perror("Could not allocate memory for the window constraints");
+          result = -1;
+          break;
+        }
+      }
+      for (int t = from; t <= to; t++) {
+        indexes[nonzeros] = window->offsets[j] + t - window->lo[j];
+        values[nonzeros++] = 1;
+      }
+    }
+    // A single job is already limited by its own assignment
+    if (jobs < 2) {
+      nonzeros = row;
+      continue;
+    }
+    begins[rows] = row;
+    senses[rows] = BACKEND_LESS_EQUAL;
+    rhs[rows++] = 1;
+  }
+
+  if (result == 0 &&
+      (result = sim->backend->add_constrs(model, rows, nonzeros, begins,
+                                          indexes, values, senses, rhs)) != 0)
+    log_error(sim, result, "add_constrs");
+  free(starts);
+  free(begins);
+  free(senses);
+  free(rhs);
+  free(indexes);
+  free(values);
+  return result;
+}
+
+int refine_big_t(const instance_t *instance) {
+  // T = sum_(j in J) p_j + max{r_j} + 1, as in the time indexed model
+  int big_t = 1, max_r_j = 0;
+  for (size_t j = 0; j < instance->number_of_jobs; j++) {
+    big_t += instance->processing_times[j];
+    if (instance->release_dates[j] > max_r_j)
+      max_r_j = instance->release_dates[j];
+  }
+  return big_t + max_r_j;
+}
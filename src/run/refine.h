@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define REFINE_MAX_VARS 1000000   // Larger time-indexed models are refined
+#define REFINE_COARSE_VARS 100000 // Size of the coarse model
+#define REFINE_COARSE_SHARE 0.25  // Share of the time limit of the coarse solve
+#define REFINE_WINDOW 2           // Half width of the windows, in coarse slots
+#define REFINE_ITERATIONS 5       // Windowed solves at most
+#define STATUS_REFINED 101 // Best schedule within the windows, not proven
+
+// Variables of the full time-indexed model of `instance`
+long refine_size(const instance_t *instance);
+// Solve `instance` on a time grid coarsened by k, then at full resolution
+// with every job restricted to a window around its coarse start, moving the
+// windows while jobs end up on their borders. `sequence` gets the schedule
+solution_t *refine_solve(simulation_t *sim, instance_t *instance,
+                         solver_t solver, double limit, int *sequence);
@@ -1,96 +1,641 @@
 #include "run.h"
+#include "../utils/arena.h"
 #include "../utils/csv.h"
+#include "../utils/evaluate.h"
+#include "../utils/results.h"
 #include "../utils/utils.h"
-#include "gurobi_c.h"
+#include "backend/backend.h"
+#include "block.h"
+#include "cache.h"
+#include "dp.h"
+#include "lns.h"
+#include "memory.h"
 #include "model/model.h"
+#include "profile.h"
+#include "refine.h"
+#include "schedule.h"
+#include "status.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-void save_model(simulation_t *sim, size_t i, solver_t solver, char *format);
+int run_job(simulation_t *sim, job_t *job, double limit,
+            const cache_entry_t *known, const run_options_t *options,
+            FILE *error_fp);
+solution_t *run_job_blocks(simulation_t *sim, job_t *job, double limit,
+                           int workers, int exact);
+solution_t *run_job_refine(simulation_t *sim, job_t *job, double limit);
+solution_t *run_job_lns(simulation_t *sim, job_t *job, double limit,
+                        int workers, const int *start);
+solution_t *run_job_dp(simulation_t *sim, job_t *job, double limit,
+                       int workers);
+int run_job_admit(simulation_t *sim, job_t *job, double *memory_limit,
+                  FILE *error_fp);
+void run_job_save(simulation_t *sim, job_t *job, FILE *sol_fp,
+                  FILE *schedule_fp, results_t *results, const char *cache,
+                  FILE *error_fp);
+void run_job_schedule(simulation_t *sim, job_t *job, const int *sequence,
+                      FILE *schedule_fp, FILE *error_fp);
+void run_job_cache(simulation_t *sim, job_t *job, const int *sequence,
+                   const char *cache, FILE *error_fp);
+void run_job_incumbent(simulation_t *sim, job_t *job,
+                       cache_entry_t *incumbent);
+int *run_job_sequence(simulation_t *sim, job_t *job);
+void run_job_free(simulation_t *sim, job_t *job);
+char *run_output(const run_options_t *options, const char *name);
 
-int run(const char *filename) {
+int run(const run_options_t *options) {
   int result = 0;
 
   vector_t *instances = vector_init();
   if (instances == NULL)
     return -1;
 
-  if ((result = load_csv(filename, instances)) != 0)
+  if ((result = load_csv(options->filename, instances)) != 0)
     return result;
 
   if ((result = create_folder("output")) != 0) {
     perror("Could not create folder output");
     return result;
   }
-  FILE *error_fp = fopen("output/error.csv", "w");
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    if (solver == DynamicProgramming)
+      continue;
+    char *solver_folder = formatted_string("output/%d", solver);
+    if (solver_folder == NULL || create_folder(solver_folder) != 0) {
+      perror_formatted("Could not create folder output/%d", solver);
+      return -1;
+    }
+    free(solver_folder);
+    solver_folder = NULL;
+  }
+  int sharded = options->shards > 1;
+  char *error_file = run_output(options, "error");
+  char *sol_file = run_output(options, "solution");
+  char *schedule_file = run_output(options, "schedule");
+  if (error_file == NULL || sol_file == NULL || schedule_file == NULL)
+    return -1;
+  FILE *error_fp = fopen(error_file, "w");
   if (error_fp == NULL) {
-    perror("Could not open error.csv");
+    perror_formatted("Could not open %s", error_file);
     return -1;
   }
   fprintf(error_fp, "Solver,Instance,Function\n");
-  FILE *sol_fp = fopen("output/solution.csv", "w");
+  FILE *sol_fp = fopen(sol_file, "w");
   if (sol_fp == NULL) {
-    perror("Could not open solution.csv");
+    perror_formatted("Could not open %s", sol_file);
     return -1;
   }
+  free(error_file);
+  error_file = NULL;
+  free(sol_file);
+  sol_file = NULL;
   fprintf(sol_fp, "Solver,Instance,Status,Runtime,Solution,Heuristic\n");
+  // A few KB by instance instead of every variable of the models
+  FILE *schedule_fp = fopen(schedule_file, "w");
+  if (schedule_fp == NULL) {
+    perror_formatted("Could not open %s", schedule_file);
+    return -1;
+  }
+  free(schedule_file);
+  schedule_file = NULL;
+  fprintf(schedule_fp, "%s\n", RUN_SCHEDULE_HEADER);
 
   simulation_t *sim = environment_init(instances);
   if (sim == NULL)
     return -1;
+  // Peak memory of the previous runs corrects the estimates of this run
+  if (options->memory > 0 &&
+      (sim->memory = memory_init(options->memory, RESULTS_STORE)) == NULL)
+    return -1;
+  // Runtimes of the previous runs predict the ones of this run
+  schedule_t *schedule = schedule_init(sim, options->budget, RESULTS_STORE);
+  if (schedule == NULL)
+    return -1;
+  if (sharded && schedule_shard(sim, schedule, options->shard,
+                                options->shards) != 0)
+    return -1;
+  // Every run is appended to the store aggregated by `amod report`
+  results_t *results = results_open(RESULTS_STORE);
+  if (results == NULL)
+    return -1;
+  if (options->budget > 0)
+    printf("Scheduling %d solves in %.0fs\n", schedule->length,
+           options->budget);
+  // What the previous runs know, read once, then the best schedule of every
+  // instance so far: the solves of this run start from it but do not make
+  // the next formulations of the same instance skip it
+  cache_entry_t *known = NULL;
+  // Shards leave the cache as every other shard found it
+  const char *cache = sharded ? NULL : options->cache;
+  if (options->cache != NULL || options->transfer) {
+    known = calloc(instances->length, sizeof(*known));
+    if (known == NULL) {
+      perror("Could not allocate memory for cache entries");
+      return -1;
+    }
+    for (size_t i = 0; i < instances->length; i++) {
+      known[i].objective = -1;
+      known[i].bound = -1;
+      if (options->cache != NULL &&
+          cache_get(options->cache, instances->values[i], &known[i]) < 0)
+        fprintf(error_fp, "-1,%ld,Cache\n", i + 1);
+    }
+  }
+
+  // Live metrics of the run, read without waiting on the solves
+  status_t *status = NULL;
+  if (options->status &&
+      (status = status_start(schedule, sim->memory, options->shard,
+                             options->shards)) == NULL)
+    return -1;
 
-  for (solver_t solver = Precedence; solver <= Heuristics_TimeIndexed;
-       solver++) {
-    char *solver_folder = formatted_string("output/%d", solver);
-    if (solver_folder == NULL)
-      solver_folder = "output/unknown";
-    if (create_folder(solver_folder) != 0) {
-      perror(formatted_string("Could not create folder output/%d", solver));
+  int open_models = 0;
+  for (size_t k = 0; k < schedule->length; k++) {
+    job_t *job = &schedule->jobs[k];
+    double limit = schedule_limit(schedule, k, 0);
+    if (limit <= 0) {
+      fprintf(error_fp, "%d,%d,Budget\n", job->solver, job->instance + 1);
+      status_end(status, -1, NULL, job, 1);
       continue;
     }
-    for (size_t i = 0; i < sim->instances->length; i++) {
-      int heuristic_value = -1;
-      instance_t *instance = sim->instances->values[i];
-      if ((result = model_init(sim, i, solver, &heuristic_value)) != 0) {
-        fprintf(error_fp, "%d,%ld,Init\n", solver, i + 1);
-        continue;
-      }
-
-      save_model(sim, i, solver, "lp");
+    const cache_entry_t *entry = known != NULL ? &known[job->instance] : NULL;
+    if (entry != NULL && entry->proven) {
+      fprintf(sol_fp, "%d,%d,%d,%.2f,%.2f,%.2f\n", job->solver,
+              job->instance + 1, STATUS_CACHED, 0.0, (double)entry->objective,
+              (double)job->heuristic_value);
+      status_end(status, -1, NULL, job, 1);
+      continue;
+    }
+    int slot = status_begin(status, sim, job);
+    int failed = run_job(sim, job, limit, entry, options, error_fp) != 0;
+    // Timed out: resumed with the time left by the jobs finishing early
+    int open = !failed && options->budget > 0 &&
+               job->solution->status == STATUS_TIME_LIMIT;
+    status_end(status, slot, sim, job, !open);
+    if (failed)
+      continue;
+    if (options->transfer)
+      run_job_incumbent(sim, job, &known[job->instance]);
 
-      solution_t *solution = model_optimize(sim, i, solver);
-      if (solution == NULL) {
-        fprintf(error_fp, "%d,%ld,Optimize\n", solver, i + 1);
-        continue;
+    if (open) {
+      job->open = 1;
+      // Blocks schedules have no model to keep
+      instance_t *instance = sim->instances->values[job->instance];
+      if (instance->model != NULL && open_models < SCHEDULE_OPEN_MODELS) {
+        job->model = instance->model;
+        instance->model = NULL;
+        open_models += 1;
+      } else if (instance->model != NULL) {
+        // Its incumbent starts the model built again to resume it
+        int *sequence = run_job_sequence(sim, job);
+        if (sequence != NULL) {
+          free(job->sequence);
+          job->sequence = sequence;
+        }
+        run_job_free(sim, job);
       }
-      solution->heuristic_value = heuristic_value;
-      fprintf(sol_fp, "%d,%ld,%d,%.2f,%.2f,%.2f\n", solver, i + 1,
-              solution->status, solution->runtime, solution->objective_value,
-              solution->heuristic_value);
-
-      save_model(sim, i, solver, "sol");
+      continue;
+    }
+    run_job_save(sim, job, sol_fp, schedule_fp, results, cache, error_fp);
+  }
 
-      if ((result = GRBfreemodel(instance->model)) != 0)
-        log_error(sim, result, "GRBfreemodel");
-      instance->model = NULL;
+  // Cheapest open jobs first, the time they leave goes to the next ones
+  for (int k = schedule->length - 1; k >= 0; k--) {
+    job_t *job = &schedule->jobs[k];
+    if (!job->open)
+      continue;
+    instance_t *instance = sim->instances->values[job->instance];
+    instance->model = job->model;
+    job->model = NULL;
+    double limit = schedule_limit(schedule, k, 1);
+    const cache_entry_t *entry = known != NULL ? &known[job->instance] : NULL;
+    if (limit >= SCHEDULE_MIN_LIMIT) {
+      int slot = status_begin(status, sim, job);
+      if (run_job(sim, job, limit, entry, NULL, error_fp) == 0 &&
+          options->transfer)
+        run_job_incumbent(sim, job, &known[job->instance]);
+      status_end(status, slot, sim, job, 1);
+    } else {
+      status_end(status, -1, NULL, job, 1);
+    }
+    job->open = 0;
+    run_job_save(sim, job, sol_fp, schedule_fp, results, cache, error_fp);
+  }
 
-      free(solution->values);
-      solution->values = NULL;
-      free(solution);
-      solution = NULL;
+  if (known != NULL) {
+    for (size_t i = 0; i < instances->length; i++) {
+      cache_entry_free(&known[i]);
     }
-    free(solver_folder);
-    solver_folder = NULL;
+    free(known);
+    known = NULL;
   }
 
+  status_stop(status);
+  status = NULL;
+  schedule_free(schedule);
+  schedule = NULL;
+  if ((result = results_close(results)) != 0)
+    return result;
+
   if ((result = simulation_free(sim)) != 0)
     return result;
 
   fclose(error_fp);
   fclose(sol_fp);
+  fclose(schedule_fp);
   return result;
 }
 
+int run_job(simulation_t *sim, job_t *job, double limit,
+            const cache_entry_t *known, const run_options_t *options,
+            FILE *error_fp) {
+  int result = 0;
+  instance_t *instance = sim->instances->values[job->instance];
+  // Built when first run, or again when it was not kept to be resumed
+  if (instance->model == NULL) {
+    const int *start = known != NULL ? known->sequence : NULL;
+    long long start_value = start != NULL ? known->objective : -1;
+    // Resumed: the incumbent of its first run when better
+    if (job->solution != NULL && job->sequence != NULL) {
+      long long value = evaluate(instance, job->sequence, NULL);
+      if (start == NULL || value < start_value) {
+        start = job->sequence;
+        start_value = value;
+      }
+    }
+    double memory_limit = 0;
+    solution_t *solution = NULL;
+    // Options are only given to the first run, resumed models are kept
+    if (job->solution == NULL && options != NULL &&
+        (job->solver == DynamicProgramming ||
+         instance->number_of_jobs <= options->exact))
+      solution = run_job_dp(sim, job, limit, options->workers);
+    // The windows are always the plain time indexed model: the heuristics
+    // variant keeps its own row
+    else if (job->solution == NULL && options != NULL &&
+             options->refine > 0 &&
+             (job->solver == TimeIndexed ||
+              job->solver == CompactTimeIndexed) &&
+             refine_size(instance) > options->refine)
+      solution = run_job_refine(sim, job, limit);
+    // The search builds the base positional model: the heuristics variant
+    // keeps its own row
+    else if (job->solution == NULL && options != NULL && options->lns &&
+             job->solver == Positional &&
+             instance->number_of_jobs >= LNS_MIN_JOBS)
+      solution = run_job_lns(sim, job, limit, options->workers, start);
+    else if (job->solution == NULL && options != NULL && options->workers > 0)
+      solution = run_job_blocks(sim, job, limit, options->workers,
+                                options->exact);
+    if (solution == NULL && job->solver == DynamicProgramming) {
+      fprintf(error_fp, "%d,%d,Dynamic\n", job->solver, job->instance + 1);
+      run_job_free(sim, job);
+      return -1;
+    }
+    if (solution != NULL) {
+      job->runtime += solution->runtime;
+      limit -= solution->runtime;
+      // Without memory for the whole model the blocks schedule is kept
+      if (solution->status == STATUS_OPTIMAL ||
+          solution->status == STATUS_EXACT ||
+          solution->status == STATUS_REFINED ||
+          solution->status == STATUS_LNS || limit < SCHEDULE_MIN_LIMIT ||
+          run_job_admit(sim, job, &memory_limit, error_fp) != 0) {
+        solution->runtime = job->runtime;
+        job->solution = solution;
+        if (job->solver >= Heuristics_Precedence &&
+            job->solver <= Heuristics_TimeIndexed)
+          job->heuristic_value = evaluate(
+              instance, instance_orders(instance)->by_release, NULL);
+        solution->heuristic_value = job->heuristic_value;
+        return 0;
+      }
+      // The blocks overlap: their schedule starts the whole model
+      if (start == NULL || solution->objective_value < start_value) {
+        start = job->sequence;
+        start_value = solution->objective_value;
+      }
+      free(solution->values);
+      free(solution);
+      solution = NULL;
+    } else if (run_job_admit(sim, job, &memory_limit, error_fp) != 0) {
+      run_job_free(sim, job);
+      return -1;
+    }
+
+    if ((result = model_init(sim, job->instance, job->solver,
+                             &job->heuristic_value)) != 0) {
+      fprintf(error_fp, "%d,%d,Init\n", job->solver, job->instance + 1);
+      run_job_free(sim, job);
+      return result;
+    }
+    // Stopped by the backend before it takes the memory of the others
+    if (sim->memory != NULL &&
+        (result = sim->backend->set_dbl_param(
+             instance->model, PARAM_MEM_LIMIT, memory_limit)) != 0)
+      log_error(sim, result, "set_dbl_param(\"SoftMemLimit\")");
+    if (job->solution == NULL)
+      save_model(sim, job->instance, job->solver, "lp");
+    // A cached or blocks sequence replaces the heuristic start when better
+    if (start != NULL &&
+        (job->heuristic_value < 0 || start_value < job->heuristic_value) &&
+        model_set_start(sim, instance, job->solver, start) != 0)
+      fprintf(error_fp, "%d,%d,Start\n", job->solver, job->instance + 1);
+    // Only the schedules better than the best known one are searched, the
+    // start itself is kept (sum C_j is integer)
+    if (job->heuristic_value >= 0 &&
+        (start_value < 0 || job->heuristic_value < start_value))
+      start_value = job->heuristic_value;
+    if (start_value >= 0 &&
+        (result = sim->backend->set_dbl_param(instance->model, PARAM_CUTOFF,
+                                              start_value + 0.5)) != 0)
+      log_error(sim, result, "set_dbl_param(\"Cutoff\")");
+  }
+  if ((result = sim->backend->set_dbl_param(instance->model, PARAM_TIME_LIMIT,
+                                            limit)) != 0)
+    log_error(sim, result, "set_dbl_param(\"TimeLimit\")");
+
+  solution_t *solution = model_optimize(sim, job->instance, job->solver);
+  if (solution == NULL) {
+    fprintf(error_fp, "%d,%d,Optimize\n", job->solver, job->instance + 1);
+    if (job->solution == NULL)
+      run_job_free(sim, job);
+    return -1;
+  }
+  solution->heuristic_value = job->heuristic_value;
+  job->runtime += solution->runtime;
+  solution->runtime = job->runtime;
+  // A model built again may find nothing better than the incumbent of the
+  // first run, which is kept (see `run_job_sequence`)
+  long long kept = job->solution != NULL && job->sequence != NULL
+                       ? evaluate(instance, job->sequence, NULL)
+                       : -1;
+  if (kept >= 0 &&
+      (solution->objective_value < 0 || solution->objective_value > kept)) {
+    solution->objective_value = kept;
+    if (solution->bound >= 0)
+      solution->gap = fabs(solution->bound - kept) / kept; // sum C_j > 0
+  }
+  if (job->solution != NULL) {
+    free(job->solution->values);
+    free(job->solution);
+  }
+  job->solution = solution;
+  return 0;
+}
+
+solution_t *run_job_blocks(simulation_t *sim, job_t *job, double limit,
+                           int workers, int exact) {
+  instance_t *instance = sim->instances->values[job->instance];
+  blocks_t *blocks = blocks_split(instance);
+  if (blocks == NULL)
+    return NULL;
+  solution_t *solution = NULL;
+  if (blocks->instances->length > 1) {
+    free(job->sequence);
+    job->sequence = malloc(sizeof(*job->sequence) * instance->number_of_jobs);
+    if (job->sequence == NULL)
+      perror("Could not allocate memory for blocks sequence");
+    else
+      solution = blocks_solve(sim, instance, blocks, job->solver, limit,
+                              workers, exact, job->sequence);
+  }
+  blocks_free(blocks);
+  blocks = NULL;
+  return solution;
+}
+
+solution_t *run_job_refine(simulation_t *sim, job_t *job, double limit) {
+  instance_t *instance = sim->instances->values[job->instance];
+  free(job->sequence);
+  job->sequence = malloc(sizeof(*job->sequence) * instance->number_of_jobs);
+  if (job->sequence == NULL) {
+    perror("Could not allocate memory for refined sequence");
+    return NULL;
+  }
+  return refine_solve(sim, instance, job->solver, limit, job->sequence);
+}
+
+solution_t *run_job_lns(simulation_t *sim, job_t *job, double limit,
+                        int workers, const int *start) {
+  instance_t *instance = sim->instances->values[job->instance];
+  free(job->sequence);
+  job->sequence = malloc(sizeof(*job->sequence) * instance->number_of_jobs);
+  if (job->sequence == NULL) {
+    perror("Could not allocate memory for neighbourhood search sequence");
+    return NULL;
+  }
+  return lns_solve(sim, instance, job->solver, limit, workers, start,
+                   job->sequence);
+}
+
+solution_t *run_job_dp(simulation_t *sim, job_t *job, double limit,
+                       int workers) {
+  instance_t *instance = sim->instances->values[job->instance];
+  free(job->sequence);
+  job->sequence = malloc(sizeof(*job->sequence) * instance->number_of_jobs);
+  if (job->sequence == NULL) {
+    perror("Could not allocate memory for dynamic programming sequence");
+    return NULL;
+  }
+  solution_t *solution =
+      dp_solve(instance, job->solver, limit, workers, job->sequence);
+  // Not the formulation's own optimum, told apart from its rows
+  if (solution != NULL && job->solver != DynamicProgramming &&
+      solution->status == STATUS_OPTIMAL)
+    solution->status = STATUS_EXACT;
+  return solution;
+}
+
+int run_job_admit(simulation_t *sim, job_t *job, double *memory_limit,
+                  FILE *error_fp) {
+  if (sim->memory == NULL)
+    return 0;
+  instance_t *instance = sim->instances->values[job->instance];
+  double estimate = memory_estimate(sim->memory, instance, job->solver);
+  if (memory_acquire(sim->memory, estimate, memory_limit) != 0) {
+    fprintf(error_fp, "%d,%d,Memory\n", job->solver, job->instance + 1);
+    return 1;
+  }
+  job->memory = *memory_limit;
+  return 0;
+}
+
+void run_job_save(simulation_t *sim, job_t *job, FILE *sol_fp,
+                  FILE *schedule_fp, results_t *results, const char *cache,
+                  FILE *error_fp) {
+  solution_t *solution = job->solution;
+  instance_t *instance = sim->instances->values[job->instance];
+  int i = job->instance;
+  fprintf(sol_fp, "%d,%d,%d,%.2f,%.2f,%.2f\n", job->solver, i + 1,
+          solution->status, solution->runtime, solution->objective_value,
+          solution->heuristic_value);
+  result_t record = {.solver = job->solver,
+                     .instance = i + 1,
+                     .status = solution->status,
+                     .runtime = solution->runtime,
+                     .objective_value = solution->objective_value,
+                     .bound = solution->bound,
+                     .gap = solution->gap,
+                     .heuristic_value = solution->heuristic_value,
+                     .variables = -1,
+                     .nonzeros = -1,
+                     .memory = solution->memory,
+                     .key = cache_hash(instance)};
+  results_features(instance, &record);
+  // Solved by a model: its size explains its peak memory
+  if (solution->memory >= 0) {
+    long variables = 0, nonzeros = 0;
+    model_counts(instance, job->solver, &variables, &nonzeros);
+    record.variables = variables;
+    record.nonzeros = nonzeros;
+  }
+  // On disk at once: a crash later in the run keeps this solve
+  if (results_append(results, &record) != 0 || results_flush(results) != 0)
+    fprintf(error_fp, "%d,%d,Results\n", job->solver, i + 1);
+
+  // Models freed while waiting to be resumed have nothing to decode
+  int *sequence = NULL;
+  if (instance->model != NULL || job->sequence != NULL)
+    sequence = run_job_sequence(sim, job);
+  if (sequence != NULL)
+    run_job_schedule(sim, job, sequence, schedule_fp, error_fp);
+  if (cache != NULL)
+    run_job_cache(sim, job, sequence, cache, error_fp);
+  free(sequence);
+  run_job_free(sim, job);
+}
+
+void run_job_schedule(simulation_t *sim, job_t *job, const int *sequence,
+                      FILE *schedule_fp, FILE *error_fp) {
+  instance_t *instance = sim->instances->values[job->instance];
+  int n = instance->number_of_jobs;
+  int *c_hs = malloc(sizeof(*c_hs) * n);
+  if (c_hs == NULL) {
+    perror("Could not allocate memory for schedule");
+    return;
+  }
+  // Evaluated again from the sequence alone: the model may idle for nothing,
+  // never finish the jobs earlier than their decoded order does
+  long long objective = evaluate(instance, sequence, c_hs);
+  double reported = job->solution->objective_value;
+  if (reported >= 0 && objective > reported + 0.5)
+    fprintf(error_fp, "%d,%d,Check\n", job->solver, job->instance + 1);
+  fprintf(schedule_fp, "%d,%d,%lld,", job->solver, job->instance + 1,
+          objective);
+  for (size_t h = 0; h < n; h++) {
+    fprintf(schedule_fp, h > 0 ? " %d" : "%d", sequence[h] + 1);
+  }
+  fputc(',', schedule_fp);
+  for (size_t h = 0; h < n; h++) {
+    fprintf(schedule_fp, h > 0 ? " %d" : "%d",
+            c_hs[h] - instance->processing_times[sequence[h]]);
+  }
+  fputc(',', schedule_fp);
+  for (size_t h = 0; h < n; h++) {
+    fprintf(schedule_fp, h > 0 ? " %d" : "%d", c_hs[h]);
+  }
+  fputc('\n', schedule_fp);
+  free(c_hs);
+}
+
+void run_job_cache(simulation_t *sim, job_t *job, const int *sequence,
+                   const char *cache, FILE *error_fp) {
+  solution_t *solution = job->solution;
+  instance_t *instance = sim->instances->values[job->instance];
+  cache_entry_t entry = {.objective = -1,
+                         .bound = -1,
+                         .proven = solution->status == STATUS_OPTIMAL ||
+                                   solution->status == STATUS_EXACT,
+                         .sequence = NULL};
+  // Bounds of integer objectives round up
+  if (solution->bound >= 0)
+    entry.bound = ceil(solution->bound - 1e-6);
+  entry.sequence = (int *)sequence;
+  if (sequence != NULL)
+    entry.objective = evaluate(instance, sequence, NULL);
+  else
+    entry.proven = 0;
+  if ((entry.sequence != NULL || entry.bound >= 0) &&
+      cache_put(cache, instance, &entry) != 0)
+    fprintf(error_fp, "%d,%d,Cache\n", job->solver, job->instance + 1);
+}
+
+void run_job_incumbent(simulation_t *sim, job_t *job,
+                       cache_entry_t *incumbent) {
+  instance_t *instance = sim->instances->values[job->instance];
+  int *sequence = run_job_sequence(sim, job);
+  if (sequence == NULL)
+    return;
+  long long objective = evaluate(instance, sequence, NULL);
+  if (incumbent->sequence != NULL && objective >= incumbent->objective) {
+    free(sequence);
+    return;
+  }
+  free(incumbent->sequence);
+  incumbent->sequence = sequence;
+  incumbent->objective = objective;
+}
+
+int *run_job_sequence(simulation_t *sim, job_t *job) {
+  solution_t *solution = job->solution;
+  instance_t *instance = sim->instances->values[job->instance];
+  int n = instance->number_of_jobs;
+  if (solution->objective_value < 0 && job->sequence == NULL)
+    return NULL;
+  int *sequence = malloc(sizeof(*sequence) * n);
+  if (sequence == NULL) {
+    perror("Could not allocate memory for sequence");
+    return NULL;
+  }
+  // Solved without a model: the blocks schedule is the solution. A resumed
+  // model keeps the incumbent of its first run when it finds nothing better
+  if (instance->model != NULL && solution->objective_value >= 0 &&
+      model_sequence(sim, instance, job->solver, sequence) == 0 &&
+      (job->sequence == NULL || evaluate(instance, sequence, NULL) <=
+                                    evaluate(instance, job->sequence, NULL)))
+    return sequence;
+  if (job->sequence != NULL) {
+    memcpy(sequence, job->sequence, sizeof(*sequence) * n);
+    return sequence;
+  }
+  free(sequence);
+  return NULL;
+}
+
+void run_job_free(simulation_t *sim, job_t *job) {
+  int result = 0;
+  instance_t *instance = sim->instances->values[job->instance];
+  if (instance->model != NULL &&
+      (result = sim->backend->model_free(instance->model)) != 0)
+    log_error(sim, result, "model_free");
+  instance->model = NULL;
+  // Models kept to be resumed keep their memory
+  if (sim->memory != NULL && job->memory > 0 && job->model == NULL) {
+    memory_release(sim->memory, job->memory);
+    job->memory = 0;
+  }
+  if (job->solution != NULL && !job->open) {
+    free(job->solution->values);
+    job->solution->values = NULL;
+    free(job->solution);
+    job->solution = NULL;
+  }
+  if (!job->open) {
+    free(job->sequence);
+    job->sequence = NULL;
+  }
+}
+
+char *run_output(const run_options_t *options, const char *name) {
+  if (options->shards > 1)
+    return formatted_string(RUN_SHARD_OUTPUT, name, options->shard,
+                            options->shards);
+  return formatted_string("output/%s.csv", name);
+}
+
 simulation_t *environment_init(vector_t *instances) {
   int result = 0;
   printf("Initializing simulation...");
@@ -100,39 +645,74 @@ simulation_t *environment_init(vector_t *instances) {
     return NULL;
   }
   sim->instances = instances;
+  sim->env = NULL;
+  sim->memory = NULL;
+  sim->progress = NULL;
+  if ((sim->arena = arena_init(ARENA_CHUNK)) == NULL)
+    return NULL;
+  if ((sim->profiles = profiles_load(PROFILE_FILE)) == NULL)
+    return NULL;
 
-  if ((result = GRBemptyenv(&sim->env)) != 0) {
-    log_error(sim, result, "GRBemptyenv");
+  if ((sim->backend = backend_default()) == NULL) {
+    fprintf(stderr, "Unknown backend %s\n", getenv("AMOD_BACKEND"));
     return NULL;
   }
 
-  if ((result = GRBstartenv(sim->env)) != 0) {
-    log_error(sim, result, "GRBstartenv");
+  if ((result = sim->backend->env_init(&sim->env)) != 0) {
+    log_error(sim, result, "env_init");
     return NULL;
   }
 
-  printf("Environment started correctly\n");
+  printf("Environment started correctly (%s)\n", sim->backend->name);
 
   return sim;
 }
 
 int simulation_free(simulation_t *sim) {
+  for (size_t i = 0; i < sim->instances->length; i++) {
+    instance_orders_free(sim->instances->values[i]);
+  }
   vector_free(sim->instances);
   sim->instances = NULL;
-  GRBfreeenv(sim->env);
+  vector_free(sim->profiles);
+  sim->profiles = NULL;
+  memory_free(sim->memory);
+  sim->memory = NULL;
+  arena_free(sim->arena);
+  sim->arena = NULL;
+  sim->backend->env_free(sim->env);
   sim->env = NULL;
   free(sim);
   sim = NULL;
   return 0;
 }
 
+int simulation_worker_init(simulation_t *worker) {
+  worker->env = NULL;
+  if ((worker->arena = arena_init(ARENA_CHUNK)) == NULL)
+    return -1;
+  if (worker->backend->env_init(&worker->env) != 0) {
+    arena_free(worker->arena);
+    worker->arena = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+void simulation_worker_free(simulation_t *worker) {
+  worker->backend->env_free(worker->env);
+  worker->env = NULL;
+  arena_free(worker->arena);
+  worker->arena = NULL;
+}
+
 void save_model(simulation_t *sim, size_t i, solver_t solver, char *format) {
   int result = 0;
   instance_t *instance = sim->instances->values[i];
   char *name = formatted_string("output/%d/%ld.%s", solver, i, format);
   if (name != NULL) {
-    if ((result = GRBwrite(instance->model, name)) != 0)
-      log_error(sim, result, "GRBwrite");
+    if ((result = sim->backend->write(instance->model, name)) != 0)
+      log_error(sim, result, "write");
   }
   free(name);
   name = NULL;
@@ -2,7 +2,55 @@
 
 #include "../utils/entities.h"
 
-int run(const char *filename);
+// Outputs of shard k of N: output/<name>.shard-<k>-<N>.csv
+#define RUN_SHARD_OUTPUT "output/%s.shard-%d-%d.csv"
+// output/schedule.csv: decoded schedule of every solve, the jobs (from 1) in
+// processing order with their start and completion times, space separated
+#define RUN_SCHEDULE_HEADER "Solver,Instance,Objective,Sequence,Start,Completion"
+
+typedef struct {
+  const char *filename; // Instances to solve
+  double budget;        // Seconds for the whole run, <= 0: TIME_LIMIT a solve
+  const char *cache;    // Solution cache folder, NULL: not used
+  int transfer;         // Solves start from the best schedule of the run
+  int workers;          // Threads solving the blocks, 0: never split
+  long refine;          // Larger time indexed models are refined, 0: never
+  int exact;            // Instances and blocks of at most `exact` jobs are
+                        // solved by dynamic programming, 0: by the models
+  int lns;              // Positional models of LNS_MIN_JOBS jobs or more are
+                        // solved by neighbourhood search (see lns.h)
+  double memory;        // GB the models use together, <= 0: no limit
+  int shard;            // Shard of the instances, from 1
+  int shards;           // Number of shards, <= 1: the whole run
+  int status;           // Live metrics in a file and a socket (status.h)
+} run_options_t;
+
+// Solve every instance with every formulation. With a budget the longest
+// predicted solves go first, each with a share of the time left, and the
+// ones stopped by their limit are resumed with the time left over.
+// Instances proven optimal in the cache are skipped, the others start from
+// the best cached sequence and their results are merged back into the cache.
+// Every solve also starts from the best schedule found for its instance by
+// the solves before it, any formulation, and only looks for better ones.
+// Instances idling in their earliest release date schedule are solved block
+// by block first (see block.h), as a whole only when that is not enough.
+// Time indexed models too large to build are refined instead (see refine.h)
+// and models expected to exceed the memory left are not built (memory.h).
+// With `exact` small instances and blocks skip the models, solved exactly by
+// dp.h (status STATUS_EXACT).
+// With `lns` large positional models are searched by neighbourhoods.
+// A shard only solves its instances (see `schedule_shard`) and tags its
+// outputs. Shards only read the cache: every shard sees the entries a single
+// process would, and merged shards are the rows of that process
+int run(const run_options_t *options);
 
 simulation_t *environment_init(vector_t *instances);
 int simulation_free(simulation_t *simulation);
+// Give `worker`, a copy of a simulation for another thread, a backend
+// environment and an arena of its own: environments are not shared between
+// threads. Nothing is left to free when it fails
+int simulation_worker_init(simulation_t *worker);
+// Free the environment and arena of `simulation_worker_init`
+void simulation_worker_free(simulation_t *worker);
+// Export the model of instance `i` in output/<solver>/<i>.<format>
+void save_model(simulation_t *sim, size_t i, solver_t solver, char *format);
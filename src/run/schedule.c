@@ -0,0 +1,216 @@
+#include "schedule.h"
+#include "../utils/results.h"
+#include "../utils/utils.h"
+#include "dp.h"
+#include "model/model.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Least squares of log(runtime) over log(n) for every formulation
+typedef struct {
+  int points[NUMBER_OF_SOLVERS];
+  double sum_x[NUMBER_OF_SOLVERS], sum_xx[NUMBER_OF_SOLVERS];
+  double sum_y[NUMBER_OF_SOLVERS], sum_xy[NUMBER_OF_SOLVERS];
+} fit_t;
+
+// Instance of the whole run waiting for a shard, with all its jobs
+typedef struct {
+  double cost;
+  int instance;
+} shard_instance_t;
+
+int schedule_history(const results_block_t *block, void *data);
+int schedule_compare(const void *a, const void *b);
+int schedule_shard_compare(const void *a, const void *b);
+
+schedule_t *schedule_init(simulation_t *sim, double budget,
+                          const char *history) {
+  schedule_t *schedule = malloc(sizeof(*schedule));
+  if (schedule == NULL) {
+    perror("Could not allocate memory for schedule");
+    return NULL;
+  }
+  schedule->budget = budget;
+  // Every formulation, the dynamic programming only of the small instances
+  schedule->length = (NUMBER_OF_SOLVERS - 1) * sim->instances->length;
+  for (size_t i = 0; i < sim->instances->length; i++) {
+    const instance_t *instance = sim->instances->values[i];
+    if (instance->number_of_jobs <= DP_MAX_JOBS)
+      schedule->length += 1;
+  }
+  schedule->jobs = malloc(sizeof(*schedule->jobs) * schedule->length);
+  if (schedule->jobs == NULL) {
+    perror("Could not allocate memory for jobs");
+    free(schedule);
+    return NULL;
+  }
+
+  double a[NUMBER_OF_SOLVERS], b[NUMBER_OF_SOLVERS];
+  memcpy(a, SCHEDULE_DEFAULT_A, sizeof(a));
+  memcpy(b, SCHEDULE_DEFAULT_B, sizeof(b));
+  fit_t fit;
+  memset(&fit, 0, sizeof(fit));
+  FILE *fp = history != NULL ? fopen(history, "rb") : NULL;
+  if (fp != NULL) {
+    fclose(fp);
+    results_scan(history, schedule_history, &fit);
+  }
+  for (solver_t s = 0; s < NUMBER_OF_SOLVERS; s++) {
+    int points = fit.points[s];
+    double denominator = points * fit.sum_xx[s] - fit.sum_x[s] * fit.sum_x[s];
+    // At least two different sizes are needed for a slope
+    if (points < 2 || fabs(denominator) < 1e-9)
+      continue;
+    b[s] = (points * fit.sum_xy[s] - fit.sum_x[s] * fit.sum_y[s]) / denominator;
+    a[s] = exp((fit.sum_y[s] - b[s] * fit.sum_x[s]) / points);
+  }
+
+  // Jobs in the order of the runs without a budget: formulation by
+  // formulation
+  size_t k = 0;
+  for (solver_t s = Precedence; s < NUMBER_OF_SOLVERS; s++) {
+    for (size_t i = 0; i < sim->instances->length; i++) {
+      instance_t *instance = sim->instances->values[i];
+      if (s == DynamicProgramming && instance->number_of_jobs > DP_MAX_JOBS)
+        continue;
+      job_t *job = &schedule->jobs[k++];
+      memset(job, 0, sizeof(*job));
+      job->solver = s;
+      job->instance = i;
+      job->heuristic_value = -1;
+      job->predicted = fmax(a[s] * pow(instance->number_of_jobs, b[s]), 0.01);
+    }
+  }
+  if (budget > 0)
+    qsort(schedule->jobs, schedule->length, sizeof(*schedule->jobs),
+          schedule_compare);
+
+  measure_t now;
+  measure_now(&now);
+  schedule->start = now.wall;
+  return schedule;
+}
+
+int schedule_shard(simulation_t *sim, schedule_t *schedule, int shard,
+                   int shards) {
+  int length = schedule->length;
+  int instances = sim->instances->length;
+  shard_instance_t *order = calloc(instances, sizeof(*order));
+  double *loads = calloc(shards, sizeof(*loads));
+  char *kept = calloc(instances, sizeof(*kept));
+  if (order == NULL || loads == NULL || kept == NULL) {
+    perror("Could not allocate memory for shards");
+    free(order);
+    free(loads);
+    free(kept);
+    return -1;
+  }
+  double a[NUMBER_OF_SOLVERS], b[NUMBER_OF_SOLVERS];
+  memcpy(a, SCHEDULE_DEFAULT_A, sizeof(a));
+  memcpy(b, SCHEDULE_DEFAULT_B, sizeof(b));
+  for (size_t i = 0; i < instances; i++) {
+    order[i].instance = i;
+  }
+  for (size_t k = 0; k < length; k++) {
+    const job_t *job = &schedule->jobs[k];
+    const instance_t *instance = sim->instances->values[job->instance];
+    int s = job->solver;
+    order[job->instance].cost +=
+        fmax(a[s] * pow(instance->number_of_jobs, b[s]), 0.01);
+  }
+  qsort(order, instances, sizeof(*order), schedule_shard_compare);
+  // Longest processing time first on the least loaded shard
+  for (size_t k = 0; k < instances; k++) {
+    int least = 0;
+    for (size_t s = 1; s < shards; s++) {
+      if (loads[s] < loads[least])
+        least = s;
+    }
+    loads[least] += order[k].cost;
+    if (least == shard - 1)
+      kept[order[k].instance] = 1;
+  }
+
+  // Kept jobs stay in the order of the schedule
+  schedule->length = 0;
+  for (size_t k = 0; k < length; k++) {
+    if (kept[schedule->jobs[k].instance])
+      schedule->jobs[schedule->length++] = schedule->jobs[k];
+  }
+  free(order);
+  free(loads);
+  free(kept);
+  return 0;
+}
+
+double schedule_remaining(const schedule_t *schedule) {
+  measure_t now;
+  measure_now(&now);
+  return schedule->budget - (now.wall - schedule->start);
+}
+
+double schedule_limit(const schedule_t *schedule, int k, int resume) {
+  if (schedule->budget <= 0)
+    return TIME_LIMIT;
+
+  double remaining = schedule_remaining(schedule);
+  double pending = 0;
+  if (!resume) {
+    for (size_t j = k; j < schedule->length; j++) {
+      pending += schedule->jobs[j].predicted;
+    }
+  } else {
+    for (size_t j = 0; j <= k; j++) {
+      if (schedule->jobs[j].open)
+        pending += schedule->jobs[j].predicted;
+    }
+  }
+  double limit = remaining * schedule->jobs[k].predicted / pending;
+  // Small shares are raised, as long as the budget allows it
+  if (limit < SCHEDULE_MIN_LIMIT)
+    limit = fmin(SCHEDULE_MIN_LIMIT, remaining);
+  return limit;
+}
+
+void schedule_free(schedule_t *schedule) {
+  free(schedule->jobs);
+  schedule->jobs = NULL;
+  free(schedule);
+}
+
+int schedule_history(const results_block_t *block, void *data) {
+  fit_t *fit = data;
+  for (size_t k = 0; k < block->length; k++) {
+    int s = block->solver[k];
+    if (s < 0 || s >= NUMBER_OF_SOLVERS || block->runtime[k] <= 0 ||
+        block->number_of_jobs[k] <= 0)
+      continue;
+    double x = log(block->number_of_jobs[k]);
+    double y = log(block->runtime[k]);
+    fit->points[s] += 1;
+    fit->sum_x[s] += x;
+    fit->sum_xx[s] += x * x;
+    fit->sum_y[s] += y;
+    fit->sum_xy[s] += x * y;
+  }
+  return 0;
+}
+
+int schedule_compare(const void *a, const void *b) {
+  const job_t *job_a = a, *job_b = b;
+  if (job_a->predicted != job_b->predicted)
+    return job_a->predicted < job_b->predicted ? 1 : -1;
+  // Same order on every run
+  if (job_a->solver != job_b->solver)
+    return job_a->solver - job_b->solver;
+  return job_a->instance - job_b->instance;
+}
+
+int schedule_shard_compare(const void *a, const void *b) {
+  const shard_instance_t *instance_a = a, *instance_b = b;
+  if (instance_a->cost != instance_b->cost)
+    return instance_a->cost < instance_b->cost ? 1 : -1;
+  return instance_a->instance - instance_b->instance;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define SCHEDULE_MIN_LIMIT 1.0  // Seconds, shorter solves are not started
+#define SCHEDULE_OPEN_MODELS 64 // Timed out models kept in memory to resume
+// Runtime ~ a * n^b fitted on results/solution-*.csv, used when the results
+// store has no history for a formulation (the compact time indexed model
+// starts from the time indexed fit)
+#define SCHEDULE_DEFAULT_A                                                     \
+  (double[NUMBER_OF_SOLVERS]) { 0.001318, 0.002907, 0.001522, 0.002982,       \
+                                0.002947, 0.001522, 3.5e-14,  0.001522 }
+#define SCHEDULE_DEFAULT_B                                                     \
+  (double[NUMBER_OF_SOLVERS]) { 3.189, 0.863, 1.848, 0.919, 0.868, 1.848,      \
+                                9.45,  1.848 }
+
+typedef struct {
+  solver_t solver;
+  int instance;         // Index of the instance in the simulation
+  double predicted;     // Predicted seconds to optimality
+  double runtime;       // Seconds spent optimizing so far
+  int open;             // Stopped by its limit, can be resumed
+  int heuristic_value;  // -1 if it's not heuristics
+  void *model;          // Model kept to be resumed (NULL: built again)
+  solution_t *solution; // Solution of the last optimize
+  int *sequence;        // Stitched blocks schedule, NULL if not split
+  double memory;        // GB admitted to its model, 0 when not built
+} job_t;
+
+typedef struct {
+  double budget; // Seconds for the whole run, <= 0: TIME_LIMIT every solve
+  double start;  // Wall clock when the schedule was built
+  int length;    // Number of jobs
+  job_t *jobs;   // Longest predicted first when there is a budget
+} schedule_t;
+
+// Every (formulation, instance) of `sim`, and the dynamic programming of the
+// instances of at most DP_MAX_JOBS jobs, predicted from the runtimes in the
+// results store `history` (defaults when missing)
+schedule_t *schedule_init(simulation_t *sim, double budget,
+                          const char *history);
+// Keep the jobs of shard `shard` of `shards` (from 1): instances go, with
+// every formulation, longest first to the shard with the least predicted
+// time so far, so that their solves run in the order of a single process.
+// Predictions use the defaults only, every process splits the same way
+int schedule_shard(simulation_t *sim, schedule_t *schedule, int shard,
+                   int shards);
+// Seconds left in the budget
+double schedule_remaining(const schedule_t *schedule);
+// Time limit of jobs[k]: its share of the remaining budget, proportional to
+// the predictions of the jobs still to run (from k on, or the open jobs up
+// to k when resuming)
+double schedule_limit(const schedule_t *schedule, int k, int resume);
+void schedule_free(schedule_t *schedule);
@@ -0,0 +1,349 @@
+#include "status.h"
+#include "../utils/utils.h"
+#include "memory.h"
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#define STATUS_POLL 250 // Milliseconds the thread waits for a connection
+
+// Counters copied under the lock, rendered without it
+typedef struct {
+  double elapsed;
+  int total;
+  int done;
+  int completed[NUMBER_OF_SOLVERS];
+  double predicted_left;
+  double predicted_done;
+  double runtime_done;
+  status_slot_t slots[STATUS_SLOTS];
+} status_snapshot_t;
+
+void *status_thread(void *data);
+void status_report(backend_progress_t *progress, double objective,
+                   double bound);
+void status_write(status_t *status);
+int status_listen(const char *path);
+double status_now(void);
+
+status_t *status_start(const schedule_t *schedule, memory_t *memory,
+                       int shard, int shards) {
+  status_t *status = calloc(1, sizeof(*status));
+  if (status == NULL) {
+    perror("Could not allocate memory for status");
+    return NULL;
+  }
+  if (pthread_mutex_init(&status->lock, NULL) != 0) {
+    perror("Could not initialize status lock");
+    free(status);
+    return NULL;
+  }
+  status->schedule = schedule;
+  status->memory = memory;
+  status->start = status_now();
+  status->total = schedule->length;
+  for (int k = 0; k < schedule->length; k++) {
+    status->predicted_left += schedule->jobs[k].predicted;
+  }
+  for (int s = 0; s < STATUS_SLOTS; s++) {
+    status->slots[s].progress.report = status_report;
+    status->slots[s].status = status;
+  }
+  status->listener = -1;
+  if (shards > 1) {
+    status->file = formatted_string(STATUS_SHARD, shard, shards, "json");
+    status->socket = formatted_string(STATUS_SHARD, shard, shards, "sock");
+  } else {
+    status->file = formatted_string("%s", STATUS_FILE);
+    status->socket = formatted_string("%s", STATUS_SOCKET);
+  }
+  if (status->file == NULL || status->socket == NULL) {
+    status_stop(status);
+    return NULL;
+  }
+  // Without the socket the file is still written
+  status->listener = status_listen(status->socket);
+#ifndef _WIN32
+  // A client that leaves before reading must not kill the run
+  if (status->listener >= 0)
+    signal(SIGPIPE, SIG_IGN);
+#endif
+  status_write(status);
+
+  if (pthread_create(&status->thread, NULL, status_thread, status) != 0) {
+    perror("Could not create status thread");
+    status->thread = pthread_self();
+    status_stop(status);
+    return NULL;
+  }
+  return status;
+}
+
+int status_begin(status_t *status, simulation_t *sim, const job_t *job) {
+  int slot = -1;
+  if (status == NULL)
+    return slot;
+  pthread_mutex_lock(&status->lock);
+  for (int s = 0; s < STATUS_SLOTS && slot < 0; s++) {
+    if (!status->slots[s].used)
+      slot = s;
+  }
+  if (slot >= 0) {
+    status_slot_t *running = &status->slots[slot];
+    running->used = 1;
+    running->solver = job->solver;
+    running->instance = job->instance;
+    running->start = status_now();
+    running->objective = BACKEND_INFINITY;
+    running->bound = -BACKEND_INFINITY;
+    sim->progress = &running->progress;
+  }
+  pthread_mutex_unlock(&status->lock);
+  return slot;
+}
+
+void status_end(status_t *status, int slot, simulation_t *sim,
+                const job_t *job, int finished) {
+  if (sim != NULL)
+    sim->progress = NULL;
+  if (status == NULL)
+    return;
+  pthread_mutex_lock(&status->lock);
+  if (slot >= 0)
+    status->slots[slot].used = 0;
+  if (finished) {
+    status->done += 1;
+    status->completed[job->solver] += 1;
+    status->predicted_left -= job->predicted;
+    // Skipped jobs tell nothing about the speed of the run
+    if (job->runtime > 0) {
+      status->predicted_done += job->predicted;
+      status->runtime_done += job->runtime;
+    }
+  }
+  pthread_mutex_unlock(&status->lock);
+}
+
+void status_stop(status_t *status) {
+  if (status == NULL)
+    return;
+  if (status->file != NULL && status->socket != NULL) {
+    pthread_mutex_lock(&status->lock);
+    status->stop = 1;
+    pthread_mutex_unlock(&status->lock);
+    if (!pthread_equal(status->thread, pthread_self()))
+      pthread_join(status->thread, NULL);
+    // Last metrics of the run stay in the file
+    status_write(status);
+  }
+#ifndef _WIN32
+  if (status->listener >= 0) {
+    close(status->listener);
+    unlink(status->socket);
+  }
+#endif
+  pthread_mutex_destroy(&status->lock);
+  free(status->file);
+  free(status->socket);
+  free(status);
+}
+
+void status_print(status_t *status, FILE *fp) {
+  status_snapshot_t snapshot;
+  pthread_mutex_lock(&status->lock);
+  snapshot.elapsed = status_now() - status->start;
+  snapshot.total = status->total;
+  snapshot.done = status->done;
+  memcpy(snapshot.completed, status->completed, sizeof(snapshot.completed));
+  snapshot.predicted_left = status->predicted_left;
+  snapshot.predicted_done = status->predicted_done;
+  snapshot.runtime_done = status->runtime_done;
+  memcpy(snapshot.slots, status->slots, sizeof(snapshot.slots));
+  pthread_mutex_unlock(&status->lock);
+
+  double used = 0, budget = 0;
+  if (status->memory != NULL) {
+    pthread_mutex_lock(&status->memory->lock);
+    used = status->memory->used;
+    budget = status->memory->budget;
+    pthread_mutex_unlock(&status->memory->lock);
+  }
+  measure_t now;
+  measure_now(&now);
+
+  int running = 0;
+  for (int s = 0; s < STATUS_SLOTS; s++) {
+    running += snapshot.slots[s].used;
+  }
+  int queued = snapshot.total - snapshot.done - running;
+  double hours = snapshot.elapsed / 3600;
+  double rate = hours > 0 ? snapshot.done / hours : 0;
+  // Predictions of the queue scaled by how fast the predicted ones went
+  double eta = snapshot.predicted_left;
+  if (snapshot.predicted_done > 0)
+    eta *= snapshot.runtime_done / snapshot.predicted_done;
+  if (status->schedule->budget > 0) {
+    double remaining = schedule_remaining(status->schedule);
+    eta = remaining < eta ? remaining : eta;
+  }
+  if (eta < 0 || snapshot.done == snapshot.total)
+    eta = 0;
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"elapsed\": %.1f,\n", snapshot.elapsed);
+  fprintf(fp, "  \"total\": %d,\n", snapshot.total);
+  fprintf(fp, "  \"completed\": %d,\n", snapshot.done);
+  fprintf(fp, "  \"queued\": %d,\n", queued);
+  fprintf(fp, "  \"solves_per_hour\": %.2f,\n", rate);
+  fprintf(fp, "  \"eta_seconds\": %.0f,\n", eta);
+  fprintf(fp, "  \"formulations\": [\n");
+  for (solver_t s = Precedence; s < NUMBER_OF_SOLVERS; s++) {
+    fprintf(fp,
+            "    {\"solver\": %d, \"name\": \"%s\", \"completed\": %d}%s\n", s,
+            solver_name(s), snapshot.completed[s],
+            s + 1 < NUMBER_OF_SOLVERS ? "," : "");
+  }
+  fprintf(fp, "  ],\n");
+  fprintf(fp, "  \"running\": [");
+  int first = 1;
+  for (int s = 0; s < STATUS_SLOTS; s++) {
+    const status_slot_t *slot = &snapshot.slots[s];
+    if (!slot->used)
+      continue;
+    // Gurobi's gap, -1 until there are a schedule and a bound
+    double gap = -1;
+    if (slot->objective < BACKEND_INFINITY &&
+        slot->bound > -BACKEND_INFINITY)
+      gap = fabs(slot->objective - slot->bound) /
+            fmax(fabs(slot->objective), 1e-10);
+    fprintf(fp,
+            "%s\n    {\"solver\": %d, \"instance\": %d, \"elapsed\": %.1f, "
+            "\"objective\": %.2f, \"bound\": %.2f, \"gap\": %.6f}",
+            first ? "" : ",", slot->solver, slot->instance + 1,
+            now.wall - slot->start,
+            slot->objective < BACKEND_INFINITY ? slot->objective : -1,
+            slot->bound > -BACKEND_INFINITY ? slot->bound : -1, gap);
+    first = 0;
+  }
+  fprintf(fp, "%s],\n", first ? "" : "\n  ");
+  fprintf(fp, "  \"memory\": {\"used\": %.3f, \"budget\": %.3f, "
+              "\"peak_rss_kb\": %ld}\n",
+          used, budget, now.peak_rss);
+  fprintf(fp, "}\n");
+}
+
+void *status_thread(void *data) {
+  status_t *status = data;
+  double written = status_now();
+  while (1) {
+    pthread_mutex_lock(&status->lock);
+    int stop = status->stop;
+    pthread_mutex_unlock(&status->lock);
+    if (stop)
+      break;
+    if (status_now() - written >= STATUS_INTERVAL) {
+      status_write(status);
+      written = status_now();
+    }
+#ifndef _WIN32
+    if (status->listener < 0) {
+      usleep(STATUS_POLL * 1000);
+      continue;
+    }
+    // Every connection gets the metrics of now, then is closed
+    struct pollfd listener = {.fd = status->listener, .events = POLLIN};
+    if (poll(&listener, 1, STATUS_POLL) <= 0)
+      continue;
+    int client = accept(status->listener, NULL, NULL);
+    if (client < 0)
+      continue;
+    FILE *fp = fdopen(client, "w");
+    if (fp == NULL) {
+      close(client);
+      continue;
+    }
+    status_print(status, fp);
+    // Fails when the client left before reading, the next one is served
+    if (fclose(fp) != 0 && errno != EPIPE && errno != ECONNRESET)
+      perror("Could not answer a status client");
+#else
+    Sleep(STATUS_POLL);
+#endif
+  }
+  return NULL;
+}
+
+void status_report(backend_progress_t *progress, double objective,
+                   double bound) {
+  // The slot embeds the progress
+  status_slot_t *slot = (status_slot_t *)progress;
+  pthread_mutex_lock(&slot->status->lock);
+  slot->objective = objective;
+  slot->bound = bound;
+  pthread_mutex_unlock(&slot->status->lock);
+}
+
+void status_write(status_t *status) {
+  // Written aside then renamed, readers never see half the metrics
+  char *temporary = formatted_string("%s.tmp", status->file);
+  FILE *fp = temporary != NULL ? fopen(temporary, "w") : NULL;
+  if (fp == NULL) {
+    perror_formatted("Could not open %s", status->file);
+    free(temporary);
+    return;
+  }
+  status_print(status, fp);
+  if (fclose(fp) != 0) {
+    // The previous metrics stay rather than a truncated file
+    perror_formatted("Could not write %s", temporary);
+    remove(temporary);
+  } else if (rename(temporary, status->file) != 0)
+    perror_formatted("Could not rename %s", temporary);
+  free(temporary);
+}
+
+int status_listen(const char *path) {
+#ifndef _WIN32
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path %s is too long\n", path);
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("Could not create status socket");
+    return -1;
+  }
+  // Left behind by a run that did not stop
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(fd, 8) != 0) {
+    perror_formatted("Could not listen on %s", path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+#else
+  return -1;
+#endif
+}
+
+double status_now(void) {
+  measure_t now;
+  measure_now(&now);
+  return now.wall;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../utils/entities.h"
+#include "backend/backend.h"
+#include "schedule.h"
+#include <pthread.h>
+#include <stdio.h>
+
+#define STATUS_INTERVAL 5.0 // Seconds between two rewrites of the file
+#define STATUS_SLOTS 16     // Solves shown running at the same time
+// output/status.json and a socket answering every connection with the same
+// JSON, output/status.shard-<k>-<N>.{json,sock} for shard k of N
+#define STATUS_FILE "output/status.json"
+#define STATUS_SOCKET "output/status.sock"
+#define STATUS_SHARD "output/status.shard-%d-%d.%s"
+
+typedef struct status_t status_t;
+
+// A running solve, updated by the progress of its optimizes
+typedef struct {
+  backend_progress_t progress; // First, the backend reports to it
+  status_t *status;
+  int used;
+  solver_t solver;
+  int instance;
+  double start;     // Wall clock
+  double objective; // Best so far, BACKEND_INFINITY: none
+  double bound;     // Best so far, -BACKEND_INFINITY: none
+} status_slot_t;
+
+// Live metrics of a run. The solving thread only updates counters under the
+// lock; a thread of its own renders them, rewrites the file and answers the
+// socket, so that readers never wait on a solve nor a solve on a reader
+struct status_t {
+  pthread_mutex_t lock;
+  const schedule_t *schedule;
+  memory_t *memory; // NULL: no memory budget
+  double start;     // Wall clock
+  int total;        // Solves of the schedule
+  int done;         // Finished, skipped included
+  int completed[NUMBER_OF_SOLVERS]; // Finished with a solution
+  double predicted_left;            // Predicted seconds of the queue
+  double predicted_done;            // Predicted seconds of the finished
+  double runtime_done;              // Wall seconds they took
+  status_slot_t slots[STATUS_SLOTS];
+  pthread_t thread;
+  int listener; // Socket, -1: none
+  int stop;
+  char *file;
+  char *socket;
+};
+
+// Start reporting the jobs of `schedule`. Shard k of N (shards <= 1: none)
+// writes files of its own. Begin and end do nothing on a NULL status
+status_t *status_start(const schedule_t *schedule, memory_t *memory,
+                       int shard, int shards);
+// Job `job` starts running in `sim`: the progress of its optimizes goes to
+// the slot returned (-1 when every slot is taken, the job is only counted)
+int status_begin(status_t *status, simulation_t *sim, const job_t *job);
+// Job `job` leaves slot `slot` (-1: it never started), `finished` when it
+// will not be resumed
+void status_end(status_t *status, int slot, simulation_t *sim,
+                const job_t *job, int finished);
+// Write the last metrics and stop answering
+void status_stop(status_t *status);
+// Current metrics as JSON
+void status_print(status_t *status, FILE *fp);
@@ -0,0 +1,673 @@
+#include "serve.h"
+#include "../run/backend/backend.h"
+#include "../run/block.h"
+#include "../run/dominance.h"
+#include "../run/dp.h"
+#include "../run/memory.h"
+#include "../run/model/model.h"
+#include "../run/run.h"
+#include "../utils/evaluate.h"
+#include "../utils/queue.h"
+#include "../utils/results.h"
+#include "../utils/utils.h"
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#define SERVE_SEPARATORS " \t\r\n"
+
+typedef struct serve_t serve_t;
+typedef struct serve_client_t serve_client_t;
+
+// Connection the answers of its requests go to
+struct serve_client_t {
+  serve_t *server;
+  FILE *in;
+  FILE *out;
+  int fd;               // Socket, -1: stdin and stdout
+  pthread_mutex_t lock; // Guards `out` and `pending`
+  int pending;          // Requests not answered yet, + 1 while it is read
+  serve_client_t *next; // Connections still read
+};
+
+typedef struct {
+  char *id;
+  solver_t solver;
+  double limit;
+  double received; // Wall clock when the line was read
+  instance_t *instance;
+  serve_client_t *client;
+} serve_request_t;
+
+struct serve_t {
+  const serve_options_t *options;
+  queue_t queue;           // Requests read and not taken by a worker yet
+  pthread_mutex_t lock;    // Guards `clients` and `readers`
+  pthread_cond_t finished; // Signaled when a connection is read to its end
+  serve_client_t *clients;
+  int readers;
+};
+
+typedef struct {
+  serve_t *server;
+  simulation_t sim; // Own backend environment and arena, kept for every
+                    // request, which takes instance 0 while it is solved
+  int threads;      // Backend threads of every model, 0: default
+} serve_worker_t;
+
+static volatile sig_atomic_t serve_stopped = 0;
+
+int serve_accept(serve_t *server);
+int serve_listen(const char *path);
+void serve_stop(int number);
+void *serve_reader(void *data);
+void serve_read(serve_client_t *client);
+void serve_client_close(serve_client_t *client);
+void *serve_worker(void *data);
+const char *serve_parse(char *line, serve_request_t *request,
+                        const serve_options_t *options);
+int serve_reply(simulation_t *sim, serve_request_t *request,
+                const serve_options_t *options, int threads);
+void serve_reply_error(serve_client_t *client, const char *id,
+                       const char *error);
+solution_t *serve_solve(simulation_t *sim, serve_request_t *request,
+                        const serve_options_t *options, int threads,
+                        int *sequence, const char **error);
+void serve_request_free(serve_request_t *request);
+void serve_instance_free(instance_t *instance);
+serve_client_t *serve_client_init(serve_t *server, FILE *in, FILE *out,
+                                  int fd);
+void serve_client_release(serve_client_t *client);
+void serve_request_drop(void *item);
+
+int serve(const serve_options_t *options) {
+  int result = 0;
+  int workers = options->workers > 0 ? options->workers : 1;
+#ifdef _WIN32
+  if (options->socket != NULL) {
+    fprintf(stderr, "Unix sockets are not supported, use --stdin\n");
+    return -1;
+  }
+#endif
+  if ((result = create_folder("output")) != 0) {
+    perror("Could not create folder output");
+    return result;
+  }
+  // The answers keep stdout for themselves, the logs go to stderr
+  FILE *answers = stdout;
+#ifndef _WIN32
+  if (options->socket == NULL) {
+    int fd = dup(STDOUT_FILENO);
+    if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0 ||
+        (answers = fdopen(fd, "w")) == NULL) {
+      perror("Could not keep stdout for the answers");
+      return -1;
+    }
+  }
+#endif
+
+  vector_t *instances = vector_init();
+  if (instances == NULL)
+    return -1;
+  simulation_t *sim = environment_init(instances);
+  if (sim == NULL)
+    return -1;
+  // Shared by the workers, as by the blocks of a run
+  if (options->memory > 0 &&
+      (sim->memory = memory_init(options->memory, RESULTS_STORE)) == NULL)
+    return -1;
+
+  serve_t server = {.options = options, .clients = NULL, .readers = 0};
+  serve_worker_t *pool_workers = calloc(workers, sizeof(*pool_workers));
+  pthread_t *threads = malloc(sizeof(*threads) * workers);
+  if (pool_workers == NULL || threads == NULL) {
+    perror("Could not allocate memory for workers");
+    return -1;
+  }
+  if (queue_init(&server.queue, SERVE_QUEUE * workers,
+                 sizeof(serve_request_t *)) != 0 ||
+      pthread_mutex_init(&server.lock, NULL) != 0 ||
+      pthread_cond_init(&server.finished, NULL) != 0)
+    return -1;
+
+  // Every worker keeps its environment for as long as the daemon runs, the
+  // concurrent models share the processors
+  int processors = blocks_workers();
+  int started = 0;
+  for (size_t w = 0; w < workers; w++) {
+    serve_worker_t *worker = &pool_workers[w];
+    instance_t *none = NULL;
+    worker->server = &server;
+    worker->sim = *sim;
+    worker->sim.progress = NULL;
+    worker->threads =
+        workers > 1 ? (processors > workers ? processors / workers : 1) : 0;
+    worker->sim.instances = vector_init();
+    if (worker->sim.instances == NULL ||
+        vector_add(worker->sim.instances, (void **)&none) != 0 ||
+        simulation_worker_init(&worker->sim) != 0)
+      break;
+    if (pthread_create(&threads[w], NULL, serve_worker, worker) != 0) {
+      simulation_worker_free(&worker->sim);
+      break;
+    }
+    started += 1;
+  }
+  if (started == 0) {
+    fprintf(stderr, "Could not start the serve workers\n");
+    result = -1;
+  } else {
+    fprintf(stderr, "Serving on %s with %d workers\n",
+            options->socket != NULL ? options->socket : "stdin", started);
+  }
+
+  if (result == 0 && options->socket != NULL) {
+    result = serve_accept(&server);
+  } else if (result == 0) {
+    serve_client_t *client = serve_client_init(&server, stdin, answers, -1);
+    if (client != NULL)
+      serve_read(client);
+    else
+      result = -1;
+  }
+  // The queued requests are still answered
+  queue_close(&server.queue);
+
+  for (size_t w = 0; w < started; w++) {
+    pthread_join(threads[w], NULL);
+    simulation_worker_free(&pool_workers[w].sim);
+  }
+  // Including the vector of a worker whose start failed
+  for (size_t w = 0; w <= started && w < workers; w++) {
+    if (pool_workers[w].sim.instances != NULL)
+      vector_free(pool_workers[w].sim.instances);
+  }
+
+  queue_free(&server.queue, serve_request_drop);
+  pthread_mutex_destroy(&server.lock);
+  pthread_cond_destroy(&server.finished);
+  free(pool_workers);
+  free(threads);
+  if (answers != stdout)
+    fclose(answers);
+  if (simulation_free(sim) != 0)
+    result = -1;
+  return result;
+}
+
+int serve_line(simulation_t *sim, char *line, const serve_options_t *options,
+               FILE *fp) {
+  serve_client_t client = {.in = NULL, .out = fp, .fd = -1, .pending = 1};
+  if (pthread_mutex_init(&client.lock, NULL) != 0)
+    return -1;
+  measure_t now;
+  measure_now(&now);
+  serve_request_t request = {.received = now.wall, .client = &client};
+  int result = 0;
+  const char *error = serve_parse(line, &request, options);
+  if (error != NULL) {
+    serve_reply_error(&client, request.id, error);
+    result = -1;
+  } else {
+    result = serve_reply(sim, &request, options, 0);
+  }
+  free(request.id);
+  serve_instance_free(request.instance);
+  pthread_mutex_destroy(&client.lock);
+  return result;
+}
+
+int serve_accept(serve_t *server) {
+#ifndef _WIN32
+  const char *path = server->options->socket;
+  int listener = serve_listen(path);
+  if (listener < 0)
+    return -1;
+  signal(SIGINT, serve_stop);
+  signal(SIGTERM, serve_stop);
+  // A client gone before its answers does not stop the daemon
+  signal(SIGPIPE, SIG_IGN);
+
+  while (!serve_stopped) {
+    struct pollfd pending = {.fd = listener, .events = POLLIN};
+    if (poll(&pending, 1, SERVE_POLL) <= 0)
+      continue;
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0)
+      continue;
+    // Read and written through streams of their own
+    int out_fd = dup(fd);
+    FILE *in = fdopen(fd, "r");
+    FILE *out = out_fd >= 0 ? fdopen(out_fd, "w") : NULL;
+    serve_client_t *client = in != NULL && out != NULL
+                                 ? serve_client_init(server, in, out, fd)
+                                 : NULL;
+    if (client == NULL) {
+      perror("Could not accept a connection");
+      if (in != NULL)
+        fclose(in);
+      else
+        close(fd);
+      if (out != NULL)
+        fclose(out);
+      else if (out_fd >= 0)
+        close(out_fd);
+      continue;
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, serve_reader, client) != 0) {
+      perror("Could not create a connection thread");
+      serve_client_close(client);
+      continue;
+    }
+    pthread_detach(thread);
+  }
+  close(listener);
+  unlink(path);
+
+  // The connections still read stop, their requests are answered
+  pthread_mutex_lock(&server->lock);
+  for (serve_client_t *client = server->clients; client != NULL;
+       client = client->next) {
+    shutdown(client->fd, SHUT_RD);
+  }
+  while (server->readers > 0)
+    pthread_cond_wait(&server->finished, &server->lock);
+  pthread_mutex_unlock(&server->lock);
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+int serve_listen(const char *path) {
+#ifndef _WIN32
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path %s is too long\n", path);
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("Could not create serve socket");
+    return -1;
+  }
+  // Left behind by a daemon that did not stop
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    perror_formatted("Could not listen on %s", path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+#else
+  return -1;
+#endif
+}
+
+void serve_stop(int number) {
+  (void)number;
+  serve_stopped = 1;
+}
+
+void *serve_reader(void *data) {
+  serve_read(data);
+  return NULL;
+}
+
+void serve_read(serve_client_t *client) {
+  serve_t *server = client->server;
+  char *line = NULL;
+  size_t size = 0;
+  while (getline(&line, &size, client->in) >= 0) {
+    if (strspn(line, SERVE_SEPARATORS) == strlen(line))
+      continue;
+    measure_t now;
+    measure_now(&now);
+    serve_request_t *request = calloc(1, sizeof(*request));
+    if (request == NULL) {
+      perror("Could not allocate memory for a request");
+      break;
+    }
+    request->received = now.wall;
+    request->client = client;
+    const char *error = serve_parse(line, request, server->options);
+    if (error != NULL) {
+      serve_reply_error(client, request->id, error);
+      serve_request_free(request);
+      continue;
+    }
+    pthread_mutex_lock(&client->lock);
+    client->pending += 1;
+    pthread_mutex_unlock(&client->lock);
+    // Waits while every worker has its share of requests queued
+    queue_push(&server->queue, &request);
+  }
+  free(line);
+  serve_client_close(client);
+}
+
+void serve_client_close(serve_client_t *client) {
+  serve_t *server = client->server;
+  pthread_mutex_lock(&server->lock);
+  serve_client_t **link = &server->clients;
+  while (*link != NULL && *link != client)
+    link = &(*link)->next;
+  if (*link != NULL)
+    *link = client->next;
+  pthread_mutex_unlock(&server->lock);
+  // The answers are written on a stream of their own
+  if (client->fd >= 0)
+    fclose(client->in);
+  client->in = NULL;
+  serve_client_release(client);
+
+  pthread_mutex_lock(&server->lock);
+  server->readers -= 1;
+  pthread_cond_broadcast(&server->finished);
+  pthread_mutex_unlock(&server->lock);
+}
+
+void *serve_worker(void *data) {
+  serve_worker_t *worker = data;
+  serve_request_t *request;
+  while (queue_pop(&worker->server->queue, &request)) {
+    serve_client_t *client = request->client;
+    serve_reply(&worker->sim, request, worker->server->options,
+                worker->threads);
+    serve_request_free(request);
+    serve_client_release(client);
+  }
+  return NULL;
+}
+
+const char *serve_parse(char *line, serve_request_t *request,
+                        const serve_options_t *options) {
+  char *save = NULL, *end = NULL;
+  char *token = strtok_r(line, SERVE_SEPARATORS, &save);
+  if (token == NULL)
+    return "empty request";
+  if ((request->id = strdup(token)) == NULL)
+    return "out of memory";
+
+  long values[3];
+  double limit = 0;
+  // Solver, limit and number of jobs
+  for (size_t k = 0; k < 3; k++) {
+    if ((token = strtok_r(NULL, SERVE_SEPARATORS, &save)) == NULL)
+      return "expected <id> <solver> <seconds> <n> and the jobs";
+    if (k == 1)
+      limit = strtod(token, &end);
+    else
+      values[k] = strtol(token, &end, 10);
+    if (*end != '\0')
+      return "malformed number";
+  }
+  // strtod also reads nan and inf
+  if (!isfinite(limit))
+    return "time limit not finite";
+  if (values[0] < 0 || values[0] >= NUMBER_OF_SOLVERS)
+    return "unknown solver";
+  if (values[2] < 1 || values[2] > SERVE_MAX_JOBS)
+    return "number of jobs out of range";
+  request->solver = values[0];
+  request->limit = limit > 0 ? limit : options->time_limit;
+
+  int n = values[2];
+  instance_t *instance = malloc(sizeof(*instance));
+  if (instance == NULL)
+    return "out of memory";
+  instance->number_of_jobs = n;
+  instance->processing_times = malloc(sizeof(*instance->processing_times) * n);
+  instance->release_dates = malloc(sizeof(*instance->release_dates) * n);
+  instance->orders = NULL;
+  instance->model = NULL;
+  request->instance = instance;
+  if (instance->processing_times == NULL || instance->release_dates == NULL)
+    return "out of memory";
+  for (size_t j = 0; j < n; j++) {
+    for (size_t k = 0; k < 2; k++) {
+      if ((token = strtok_r(NULL, SERVE_SEPARATORS, &save)) == NULL)
+        return "fewer jobs than announced";
+      long value = strtol(token, &end, 10);
+      long minimum = k == 0 ? 1 : 0;
+      if (*end != '\0' || value < minimum || value > SERVE_MAX_TIME)
+        return "job times out of range";
+      if (k == 0)
+        instance->processing_times[j] = value;
+      else
+        instance->release_dates[j] = value;
+    }
+  }
+  if (strtok_r(NULL, SERVE_SEPARATORS, &save) != NULL)
+    return "more jobs than announced";
+  return NULL;
+}
+
+int serve_reply(simulation_t *sim, serve_request_t *request,
+                const serve_options_t *options, int threads) {
+  serve_client_t *client = request->client;
+  int n = request->instance->number_of_jobs;
+  int *sequence = malloc(sizeof(*sequence) * n);
+  const char *error = "out of memory";
+  solution_t *solution =
+      sequence != NULL
+          ? serve_solve(sim, request, options, threads, sequence, &error)
+          : NULL;
+  if (solution == NULL) {
+    serve_reply_error(client, request->id, error);
+    free(sequence);
+    return -1;
+  }
+
+  measure_t now;
+  measure_now(&now);
+  pthread_mutex_lock(&client->lock);
+  fprintf(client->out, "%s %d %.0f %.2f %.4f %.4f", request->id,
+          solution->status, solution->objective_value, solution->bound,
+          solution->runtime, now.wall - request->received);
+  for (size_t h = 0; h < n; h++) {
+    fprintf(client->out, " %d", sequence[h] + 1);
+  }
+  fprintf(client->out, "\n");
+  fflush(client->out);
+  pthread_mutex_unlock(&client->lock);
+
+  free(solution->values);
+  free(solution);
+  free(sequence);
+  return 0;
+}
+
+void serve_reply_error(serve_client_t *client, const char *id,
+                       const char *error) {
+  pthread_mutex_lock(&client->lock);
+  fprintf(client->out, "%s error %s\n", id != NULL ? id : "-", error);
+  fflush(client->out);
+  pthread_mutex_unlock(&client->lock);
+}
+
+solution_t *serve_solve(simulation_t *sim, serve_request_t *request,
+                        const serve_options_t *options, int threads,
+                        int *sequence, const char **error) {
+  int result = 0;
+  const backend_t *backend = sim->backend;
+  instance_t *instance = request->instance;
+  int n = instance->number_of_jobs;
+  solver_t solver = request->solver;
+
+  // Small instances skip the models, as in `run`
+  if (solver == DynamicProgramming || n <= options->exact) {
+    solution_t *solution =
+        dp_solve(instance, solver, request->limit, 1, sequence);
+    if (solution != NULL || solver == DynamicProgramming) {
+      *error = "dynamic programming found no schedule";
+      return solution;
+    }
+  }
+
+  // A request could ask for more than the node has, or than the builders
+  // can index
+  long variables = 0, nonzeros = 0;
+  model_counts(instance, solver, &variables, &nonzeros);
+  if (variables > SERVE_MAX_SIZE || nonzeros > SERVE_MAX_SIZE) {
+    *error = "model too large";
+    return NULL;
+  }
+  double memory_limit = 0;
+  if (sim->memory != NULL &&
+      memory_acquire(sim->memory,
+                     memory_estimate(sim->memory, instance, solver),
+                     &memory_limit) != 0) {
+    *error = "model does not fit in the memory left";
+    return NULL;
+  }
+
+  // Best of the simple orders: the start of the model, and the answer when
+  // it finds nothing better
+  const orders_t *orders = instance_orders(instance);
+  int *start = malloc(sizeof(*start) * n);
+  if (orders == NULL || start == NULL) {
+    *error = "out of memory";
+    free(start);
+    if (sim->memory != NULL)
+      memory_release(sim->memory, memory_limit);
+    return NULL;
+  }
+  const int *candidates[3] = {orders->by_release, orders->by_processing,
+                              orders->by_completion};
+  long long start_value = -1;
+  for (size_t c = 0; c < 3; c++) {
+    memcpy(sequence, candidates[c], sizeof(*sequence) * n);
+    if (dominance_repair(instance, sequence) != 0)
+      continue;
+    long long value = evaluate(instance, sequence, NULL);
+    if (start_value < 0 || value < start_value) {
+      memcpy(start, sequence, sizeof(*start) * n);
+      start_value = value;
+    }
+  }
+  if (start_value < 0)
+    memcpy(start, orders->by_release, sizeof(*start) * n);
+
+  sim->instances->values[0] = instance;
+  int heuristic_value = -1;
+  solution_t *solution = NULL;
+  if ((result = model_init(sim, 0, solver, &heuristic_value)) != 0) {
+    *error = "model could not be built";
+  } else {
+    if ((result = backend->set_dbl_param(instance->model, PARAM_TIME_LIMIT,
+                                         request->limit)) != 0 ||
+        (threads > 0 &&
+         (result = backend->set_int_param(instance->model, PARAM_THREADS,
+                                          threads)) != 0) ||
+        (sim->memory != NULL &&
+         (result = backend->set_dbl_param(instance->model, PARAM_MEM_LIMIT,
+                                          memory_limit)) != 0))
+      log_error(sim, result, "set_param");
+    // Only the schedules better than the start are searched, the start
+    // itself is kept (sum C_j is integer)
+    if ((heuristic_value < 0 || start_value < heuristic_value) &&
+        model_set_start(sim, instance, solver, start) != 0)
+      fprintf(stderr, "Could not set the start of request %s\n",
+              request->id);
+    long long cutoff = heuristic_value >= 0 && heuristic_value < start_value
+                           ? heuristic_value
+                           : start_value;
+    if (cutoff >= 0 &&
+        (result = backend->set_dbl_param(instance->model, PARAM_CUTOFF,
+                                         cutoff + 0.5)) != 0)
+      log_error(sim, result, "set_dbl_param(\"Cutoff\")");
+    if ((solution = model_optimize(sim, 0, solver)) == NULL)
+      *error = "model could not be solved";
+  }
+  if (solution != NULL) {
+    if (solution->objective_value < 0 ||
+        model_sequence(sim, instance, solver, sequence) != 0)
+      memcpy(sequence, start, sizeof(*sequence) * n);
+    solution->objective_value = evaluate(instance, sequence, NULL);
+  }
+
+  if (instance->model != NULL &&
+      (result = backend->model_free(instance->model)) != 0)
+    log_error(sim, result, "model_free");
+  instance->model = NULL;
+  if (sim->memory != NULL)
+    memory_release(sim->memory, memory_limit);
+  sim->instances->values[0] = NULL;
+  free(start);
+  return solution;
+}
+
+void serve_request_free(serve_request_t *request) {
+  free(request->id);
+  serve_instance_free(request->instance);
+  free(request);
+}
+
+void serve_instance_free(instance_t *instance) {
+  if (instance == NULL)
+    return;
+  instance_orders_free(instance);
+  free(instance->processing_times);
+  free(instance->release_dates);
+  free(instance);
+}
+
+serve_client_t *serve_client_init(serve_t *server, FILE *in, FILE *out,
+                                  int fd) {
+  serve_client_t *client = malloc(sizeof(*client));
+  if (client == NULL) {
+    perror("Could not allocate memory for a connection");
+    return NULL;
+  }
+  if (pthread_mutex_init(&client->lock, NULL) != 0) {
+    perror("Could not initialize a connection lock");
+    free(client);
+    return NULL;
+  }
+  client->server = server;
+  client->in = in;
+  client->out = out;
+  client->fd = fd;
+  client->pending = 1;
+  pthread_mutex_lock(&server->lock);
+  client->next = server->clients;
+  server->clients = client;
+  server->readers += 1;
+  pthread_mutex_unlock(&server->lock);
+  return client;
+}
+
+void serve_client_release(serve_client_t *client) {
+  pthread_mutex_lock(&client->lock);
+  int pending = --client->pending;
+  pthread_mutex_unlock(&client->lock);
+  if (pending > 0)
+    return;
+  // Read to its end and every request answered
+  if (client->fd >= 0)
+    fclose(client->out);
+  pthread_mutex_destroy(&client->lock);
+  free(client);
+}
+
+void serve_request_drop(void *item) {
+  serve_request_t *request = *(serve_request_t **)item;
+  serve_client_t *client = request->client;
+  serve_request_free(request);
+  serve_client_release(client);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../utils/entities.h"
+#include <stdio.h>
+
+#define SERVE_SOCKET "output/amod.sock"
+#define SERVE_TIME_LIMIT 10.0 // Seconds of the requests without a limit
+#define SERVE_QUEUE 4         // Requests waiting for every worker at most
+#define SERVE_POLL 250        // Milliseconds between two checks of a stop
+#define SERVE_MAX_JOBS 100000 // Jobs of a request at most
+#define SERVE_MAX_TIME 10000  // p_j and r_j at most: completions fit an int
+// Variables and nonzeros of a model at most: its indices fit an int
+#define SERVE_MAX_SIZE 100000000
+
+typedef struct {
+  const char *socket; // Unix socket, NULL: requests on stdin, answers on
+                      // stdout
+  int workers;        // Threads solving the requests, each with its own
+                      // backend environment
+  double time_limit;  // Seconds of the requests without a limit
+  int exact;          // Instances of at most `exact` jobs are solved by
+                      // dynamic programming, 0: by the models
+  double memory;      // GB of the models solved at once, 0: no limit
+} serve_options_t;
+
+// Solve the instances of the requests until stdin ends or SIGINT/SIGTERM.
+// The environments, arenas and profiles are set up once, then every request
+// only pays for its model. A request is a line
+//   <id> <solver> <seconds> <n> <p_1> <r_1> ... <p_n> <r_n>
+// (<seconds> <= 0: the default limit) answered, in any order, by a line
+//   <id> <status> <objective> <bound> <runtime> <latency> <j_1> ... <j_n>
+// with the jobs from 1 in processing order, the seconds of the solve and
+// since the request was read, or `<id> error <reason>` (among others when
+// its model is larger than SERVE_MAX_SIZE or the memory left)
+int serve(const serve_options_t *options);
+// Answer the request `line` on `fp` with instance 0 of `sim`, which must
+// have one, as a worker does
+int serve_line(simulation_t *sim, char *line, const serve_options_t *options,
+               FILE *fp);
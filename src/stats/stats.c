@@ -0,0 +1,291 @@
+#include "stats.h"
+#include "../generate/generate.h"
+#include "../run/backend/backend.h"
+#include "../run/model/model.h"
+#include "../run/run.h"
+#include "../utils/csv.h"
+#include "../utils/utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUMBER_OF_METRICS 5
+
+typedef struct {
+  solver_t solver;
+  int jobs_class; // -1 when grouping only by p and r (extrapolation)
+  int p_class;
+  int r_class;
+  int count;
+  double sum[NUMBER_OF_METRICS];
+  double max[NUMBER_OF_METRICS];
+  // Least squares of log(metric) over log(n), zeros are left out
+  int points[NUMBER_OF_METRICS];
+  double sum_x[NUMBER_OF_METRICS], sum_xx[NUMBER_OF_METRICS];
+  double sum_y[NUMBER_OF_METRICS], sum_xy[NUMBER_OF_METRICS];
+} group_t;
+
+int stats_build(simulation_t *sim, size_t i, solver_t solver,
+                model_stats_t *stats);
+group_t *stats_group(group_t *groups, int *length, solver_t solver,
+                     int jobs_class, int p_class, int r_class);
+void stats_metrics(const model_stats_t *stats, double *metrics);
+int stats_write(const model_stats_t *records, int length, const int *targets,
+                int targets_size);
+
+int stats(const char *filename, const int *targets, int targets_size) {
+  int result = 0;
+
+  vector_t *instances = vector_init();
+  if (instances == NULL)
+    return -1;
+  if ((result = load_csv(filename, instances)) != 0)
+    return result;
+  if ((result = create_folder("output")) != 0) {
+    perror("Could not create folder output");
+    return result;
+  }
+
+  simulation_t *sim = environment_init(instances);
+  if (sim == NULL)
+    return -1;
+
+  int length = 0;
+  model_stats_t *records =
+      malloc(sizeof(*records) * sim->instances->length * NUMBER_OF_SOLVERS);
+  if (records == NULL) {
+    perror("Could not allocate memory for model statistics");
+    return -1;
+  }
+  // The heuristic variants build the same models, only with a start
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    if (solver_formulation(solver) != solver || solver == DynamicProgramming)
+      continue;
+    printf("Building %s models\n", solver_name(solver));
+    for (size_t i = 0; i < sim->instances->length; i++) {
+      if (stats_build(sim, i, solver, &records[length]) == 0)
+        length += 1;
+    }
+  }
+
+  result = stats_write(records, length, targets, targets_size);
+
+  free(records);
+  records = NULL;
+  if (simulation_free(sim) != 0)
+    return -1;
+  return result;
+}
+
+int stats_build(simulation_t *sim, size_t i, solver_t solver,
+                model_stats_t *stats) {
+  int result = 0;
+  instance_t *instance = sim->instances->values[i];
+  measure_t start, end;
+
+  memset(stats, 0, sizeof(*stats));
+  stats->solver = solver;
+  stats->instance = i + 1;
+  stats->number_of_jobs = instance->number_of_jobs;
+  for (size_t j = 0; j < instance->number_of_jobs; j++) {
+    if (instance->processing_times[j] > stats->max_p_j)
+      stats->max_p_j = instance->processing_times[j];
+    if (instance->release_dates[j] > stats->max_r_j)
+      stats->max_r_j = instance->release_dates[j];
+  }
+
+  measure_now(&start);
+  if ((result = model_init(sim, i, solver, NULL)) != 0) {
+    fprintf(stderr, "Could not build %s model of instance %ld\n",
+            solver_name(solver), i + 1);
+    return result;
+  }
+  // Gurobi builds lazily: the update is part of the construction cost
+  const backend_t *backend = sim->backend;
+  if ((result = backend->update(instance->model)) != 0)
+    log_error(sim, result, "update");
+  measure_now(&end);
+  stats->build_time = end.wall - start.wall;
+
+  if (result == 0 &&
+      (result = backend->get_int_attr(instance->model, ATTR_NUM_VARS,
+                                      &stats->vars)) != 0)
+    log_error(sim, result, "get_int_attr(\"NumVars\")");
+  if (result == 0 &&
+      (result = backend->get_int_attr(instance->model, ATTR_NUM_CONSTRS,
+                                      &stats->constrs)) != 0)
+    log_error(sim, result, "get_int_attr(\"NumConstrs\")");
+  if (result == 0 &&
+      (result = backend->get_int_attr(instance->model, ATTR_NUM_NZS,
+                                      &stats->nonzeros)) != 0)
+    log_error(sim, result, "get_int_attr(\"NumNZs\")");
+  if (result == 0 &&
+      (result = backend->get_dbl_attr(instance->model, ATTR_MEM_USED,
+                                      &stats->memory)) != 0)
+    log_error(sim, result, "get_dbl_attr(\"MemUsed\")");
+  if (result == 0 &&
+      (stats->fixed = model_dominance(NULL, instance, solver)) < 0)
+    result = -1;
+
+  int free_result = 0;
+  if ((free_result = backend->model_free(instance->model)) != 0)
+    log_error(sim, free_result, "model_free");
+  instance->model = NULL;
+  return result;
+}
+
+int stats_write(const model_stats_t *records, int length, const int *targets,
+                int targets_size) {
+  char *filename = STATS_OUTPUT ".csv";
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL) {
+    perror("Could not open " STATS_OUTPUT ".csv");
+    return -1;
+  }
+  fprintf(fp, "Solver,Instance,Jobs,MaxProcessingTime,MaxReleaseDate,Vars,"
+              "Constrs,NZs,MemoryGB,BuildTime,Fixed\n");
+
+  // Every group is both a (n, p, r) class and a (p, r) extrapolation class
+  group_t *groups = malloc(sizeof(*groups) * length * 2);
+  if (groups == NULL) {
+    perror("Could not allocate memory for groups");
+    fclose(fp);
+    return -1;
+  }
+  int groups_length = 0;
+
+  for (size_t k = 0; k < length; k++) {
+    const model_stats_t *s = &records[k];
+    fprintf(fp, "%d,%d,%d,%d,%d,%d,%d,%d,%.6f,%.6f,%d\n", s->solver,
+            s->instance, s->number_of_jobs, s->max_p_j, s->max_r_j, s->vars,
+            s->constrs, s->nonzeros, s->memory, s->build_time, s->fixed);
+
+    int jobs_class = stats_class(s->number_of_jobs, NUMBER_OF_JOBS_UL);
+    int p_class = stats_class(s->max_p_j, PROCESSING_TIMES_UL);
+    int r_class = stats_class(s->max_r_j, RELEASE_DATES_UL);
+    double metrics[NUMBER_OF_METRICS];
+    stats_metrics(s, metrics);
+
+    group_t *group = stats_group(groups, &groups_length, s->solver,
+                                 jobs_class, p_class, r_class);
+    group_t *fit =
+        stats_group(groups, &groups_length, s->solver, -1, p_class, r_class);
+    double x = log(s->number_of_jobs);
+    for (size_t m = 0; m < NUMBER_OF_METRICS; m++) {
+      group->sum[m] += metrics[m];
+      if (metrics[m] > group->max[m])
+        group->max[m] = metrics[m];
+      if (metrics[m] <= 0)
+        continue;
+      double y = log(metrics[m]);
+      fit->points[m] += 1;
+      fit->sum_x[m] += x;
+      fit->sum_xx[m] += x * x;
+      fit->sum_y[m] += y;
+      fit->sum_xy[m] += x * y;
+    }
+    group->count += 1;
+    fit->count += 1;
+  }
+  fclose(fp);
+  printf("Model statistics saved in %s\n", filename);
+
+  filename = STATS_OUTPUT "-groups.csv";
+  if ((fp = fopen(filename, "w")) == NULL) {
+    perror("Could not open " STATS_OUTPUT "-groups.csv");
+    free(groups);
+    return -1;
+  }
+  fprintf(fp, "Solver,JobsClass,ProcessingTimeClass,ReleaseDateClass,Count,"
+              "MeanVars,MaxVars,MeanConstrs,MaxConstrs,MeanNZs,MaxNZs,"
+              "MeanMemoryGB,MaxMemoryGB,MeanBuildTime,MaxBuildTime\n");
+  for (size_t g = 0; g < groups_length; g++) {
+    group_t *group = &groups[g];
+    if (group->jobs_class < 0)
+      continue;
+    fprintf(fp, "%d,%d,%d,%d,%d", group->solver, group->jobs_class,
+            group->p_class, group->r_class, group->count);
+    for (size_t m = 0; m < NUMBER_OF_METRICS; m++) {
+      fprintf(fp, ",%.6f,%.6f", group->sum[m] / group->count, group->max[m]);
+    }
+    fprintf(fp, "\n");
+  }
+  fclose(fp);
+  printf("Model statistics by class saved in %s\n", filename);
+
+  filename = STATS_OUTPUT "-extrapolation.csv";
+  if ((fp = fopen(filename, "w")) == NULL) {
+    perror("Could not open " STATS_OUTPUT "-extrapolation.csv");
+    free(groups);
+    return -1;
+  }
+  // metric ~ a * n^b fitted on every (solver, p class, r class)
+  fprintf(fp, "Solver,ProcessingTimeClass,ReleaseDateClass,Jobs,Vars,Constrs,"
+              "NZs,MemoryGB,BuildTime\n");
+  for (size_t g = 0; g < groups_length; g++) {
+    group_t *fit = &groups[g];
+    if (fit->jobs_class >= 0)
+      continue;
+    for (size_t t = 0; t < targets_size; t++) {
+      fprintf(fp, "%d,%d,%d,%d", fit->solver, fit->p_class, fit->r_class,
+              targets[t]);
+      for (size_t m = 0; m < NUMBER_OF_METRICS; m++) {
+        int points = fit->points[m];
+        double denominator =
+            points * fit->sum_xx[m] - fit->sum_x[m] * fit->sum_x[m];
+        // At least two different sizes are needed for a slope
+        if (points < 2 || fabs(denominator) < 1e-9) {
+          fprintf(fp, ",");
+          continue;
+        }
+        double b =
+            (points * fit->sum_xy[m] - fit->sum_x[m] * fit->sum_y[m]) /
+            denominator;
+        double a = (fit->sum_y[m] - b * fit->sum_x[m]) / points;
+        fprintf(fp, ",%.6f", exp(a + b * log(targets[t])));
+      }
+      fprintf(fp, "\n");
+    }
+  }
+  fclose(fp);
+  printf("Model statistics extrapolation saved in %s\n", filename);
+
+  free(groups);
+  return 0;
+}
+
+group_t *stats_group(group_t *groups, int *length, solver_t solver,
+                     int jobs_class, int p_class, int r_class) {
+  for (size_t g = 0; g < *length; g++) {
+    if (groups[g].solver == solver && groups[g].jobs_class == jobs_class &&
+        groups[g].p_class == p_class && groups[g].r_class == r_class)
+      return &groups[g];
+  }
+  group_t *group = &groups[(*length)++];
+  memset(group, 0, sizeof(*group));
+  group->solver = solver;
+  group->jobs_class = jobs_class;
+  group->p_class = p_class;
+  group->r_class = r_class;
+  return group;
+}
+
+void stats_metrics(const model_stats_t *stats, double *metrics) {
+  metrics[0] = stats->vars;
+  metrics[1] = stats->constrs;
+  metrics[2] = stats->nonzeros;
+  metrics[3] = stats->memory;
+  metrics[4] = stats->build_time;
+}
+
+int stats_class(int value, const int *upper_limits) {
+  for (size_t i = 0; i < ARRAY_SIZE + 1; i++) {
+    if (value <= upper_limits[i])
+      return upper_limits[i];
+  }
+  int upper_limit = upper_limits[ARRAY_SIZE];
+  while (upper_limit < value)
+    upper_limit *= 2;
+  return upper_limit;
+}
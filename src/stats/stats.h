@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define STATS_OUTPUT "output/stats"
+// Default sizes (number of jobs) the statistics are extrapolated to
+#define STATS_TARGETS                                                          \
+  (int[3]) { 200, 500, 1000 }
+#define STATS_TARGETS_SIZE 3
+
+typedef struct {
+  solver_t solver;
+  int instance;
+  int number_of_jobs;
+  int max_p_j;
+  int max_r_j;
+  int vars;
+  int constrs;
+  int nonzeros;
+  int fixed;         // Variables fixed by the dominance rules
+  double memory;     // GB reported by Gurobi after the build
+  double build_time; // Seconds spent in model_init and the model update
+} model_stats_t;
+
+// Build every formulation of every instance in `filename` without optimizing,
+// writing per instance statistics, per class summaries and their
+// extrapolation to `targets` jobs in output/stats*.csv
+int stats(const char *filename, const int *targets, int targets_size);
+
+// Class of a value: the smallest generator upper limit containing it, next
+// power of two past the largest one
+int stats_class(int value, const int *upper_limits);
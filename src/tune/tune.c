@@ -0,0 +1,251 @@
+#include "tune.h"
+#include "../generate/generate.h"
+#include "../run/backend/backend.h"
+#include "../run/model/model.h"
+#include "../run/profile.h"
+#include "../run/run.h"
+#include "../stats/stats.h"
+#include "../utils/csv.h"
+#include "../utils/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUMBER_OF_PARAMS 5
+#define MAX_VALUES 5
+#define MAX_SAMPLES 20
+
+// Values tried for every parameter
+typedef struct {
+  const char *name;
+  int count;
+  double values[MAX_VALUES];
+} space_t;
+
+static const space_t SPACE[NUMBER_OF_PARAMS] = {
+    {PARAM_MIP_FOCUS, 4, {0, 1, 2, 3}},
+    {PARAM_PRESOLVE, 4, {-1, 0, 1, 2}},
+    {PARAM_CUTS, 5, {-1, 0, 1, 2, 3}},
+    {PARAM_HEURISTICS, 4, {0, 0.05, 0.2, 0.5}},
+    {PARAM_METHOD, 4, {-1, 0, 1, 2}}};
+
+// Instances of a class split in training and held out ones
+typedef struct {
+  int train[MAX_SAMPLES];
+  int train_length;
+  int held_out[MAX_SAMPLES];
+  int held_out_length;
+} sample_t;
+
+double tune_score(simulation_t *sim, const tune_options_t *options,
+                  const int *instances, int length, const profile_t *profile,
+                  double cutoff);
+void tune_set(profile_t *profile, int param, double value);
+double tune_get(const profile_t *profile, int param);
+int tune_sample(simulation_t *sim, const tune_options_t *options,
+                int jobs_class, sample_t *sample);
+int tune_store(vector_t *profiles, const profile_t *tuned);
+
+int tune(const tune_options_t *options) {
+  int result = 0;
+  vector_t *instances = vector_init();
+  if (instances == NULL)
+    return -1;
+  if ((result = load_csv(options->filename, instances)) != 0)
+    return result;
+  if ((result = create_folder("output")) != 0) {
+    perror("Could not create folder output");
+    return result;
+  }
+  simulation_t *sim = environment_init(instances);
+  if (sim == NULL)
+    return -1;
+  vector_t *profiles = profiles_load(options->profiles);
+  if (profiles == NULL)
+    return -1;
+
+  FILE *fp = fopen(TUNE_REPORT, "w");
+  if (fp == NULL) {
+    perror("Could not open " TUNE_REPORT);
+    return -1;
+  }
+  fprintf(fp, "Solver,JobsClass,Train,HeldOut,MIPFocus,Presolve,Cuts,"
+              "Heuristics,Method,TrainDefault,TrainTuned,HeldOutDefault,"
+              "HeldOutTuned,Saved\n");
+
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    // The heuristic variants use the profiles of their formulation
+    if (solver_formulation(solver) != solver || solver == DynamicProgramming)
+      continue;
+    for (size_t c = 0; c < ARRAY_SIZE + 1; c++) {
+      int jobs_class = NUMBER_OF_JOBS_UL[c];
+      sample_t sample;
+      if (tune_sample(sim, options, jobs_class, &sample) != 0)
+        continue;
+      printf("Tuning %s on %d jobs instances (%d + %d held out)\n",
+             solver_name(solver), jobs_class, sample.train_length,
+             sample.held_out_length);
+
+      profile_t defaults = PROFILE_DEFAULT(solver, jobs_class);
+      profile_t best = defaults;
+      double train_default = tune_score(sim, options, sample.train,
+                                        sample.train_length, &best, -1);
+      double best_score = train_default;
+      // One parameter at a time, the others fixed at the best so far
+      for (size_t param = 0; param < NUMBER_OF_PARAMS; param++) {
+        double current = tune_get(&best, param);
+        for (size_t v = 0; v < SPACE[param].count; v++) {
+          if (SPACE[param].values[v] == current)
+            continue;
+          profile_t candidate = best;
+          tune_set(&candidate, param, SPACE[param].values[v]);
+          double score = tune_score(sim, options, sample.train,
+                                    sample.train_length, &candidate,
+                                    best_score);
+          if (score >= 0 && score < best_score) {
+            best = candidate;
+            best_score = score;
+          }
+        }
+      }
+
+      double held_out_default = tune_score(
+          sim, options, sample.held_out, sample.held_out_length, &defaults, -1);
+      double held_out_tuned = tune_score(sim, options, sample.held_out,
+                                         sample.held_out_length, &best, -1);
+      int saved = held_out_tuned < held_out_default;
+      if (saved && (result = tune_store(profiles, &best)) != 0)
+        break;
+      fprintf(fp, "%d,%d,%d,%d,%d,%d,%d,%.2f,%d,%.4f,%.4f,%.4f,%.4f,%d\n",
+              solver, jobs_class, sample.train_length, sample.held_out_length,
+              best.mip_focus, best.presolve, best.cuts, best.heuristics,
+              best.method, train_default, best_score, held_out_default,
+              held_out_tuned, saved);
+      printf("Held out mean runtime %.3fs -> %.3fs (%s)\n", held_out_default,
+             held_out_tuned, saved ? "saved" : "kept defaults");
+    }
+  }
+  fclose(fp);
+
+  if (result == 0 && (result = profiles_save(options->profiles, profiles)) == 0)
+    printf("Profiles saved in %s, report in " TUNE_REPORT "\n",
+           options->profiles);
+  vector_free(profiles);
+  profiles = NULL;
+  if (simulation_free(sim) != 0)
+    return -1;
+  return result;
+}
+
+double tune_score(simulation_t *sim, const tune_options_t *options,
+                  const int *instances, int length, const profile_t *profile,
+                  double cutoff) {
+  const backend_t *backend = sim->backend;
+  double total = 0;
+  int runs = length * options->seeds;
+  for (size_t k = 0; k < length; k++) {
+    int i = instances[k];
+    instance_t *instance = sim->instances->values[i];
+    for (size_t seed = 0; seed < options->seeds; seed++) {
+      if (model_init(sim, i, profile->solver, NULL) != 0)
+        return -1;
+      if (profile_apply(sim, instance, profile) != 0 ||
+          backend->set_int_param(instance->model, PARAM_SEED, seed) != 0 ||
+          backend->set_dbl_param(instance->model, PARAM_TIME_LIMIT,
+                                 options->time_limit) != 0) {
+        backend->model_free(instance->model);
+        instance->model = NULL;
+        return -1;
+      }
+      solution_t *solution = model_optimize(sim, i, profile->solver);
+      backend->model_free(instance->model);
+      instance->model = NULL;
+      if (solution == NULL)
+        return -1;
+      total += solution->status == STATUS_OPTIMAL ? solution->runtime
+                                                  : 2 * options->time_limit;
+      free(solution->values);
+      free(solution);
+      // Already slower than the best candidate: no need to finish
+      if (cutoff >= 0 && total / runs >= cutoff)
+        return total / runs;
+    }
+  }
+  return runs > 0 ? total / runs : 0;
+}
+
+void tune_set(profile_t *profile, int param, double value) {
+  switch (param) {
+  case 0:
+    profile->mip_focus = value;
+    break;
+  case 1:
+    profile->presolve = value;
+    break;
+  case 2:
+    profile->cuts = value;
+    break;
+  case 3:
+    profile->heuristics = value;
+    break;
+  case 4:
+    profile->method = value;
+    break;
+  }
+}
+
+double tune_get(const profile_t *profile, int param) {
+  switch (param) {
+  case 0:
+    return profile->mip_focus;
+  case 1:
+    return profile->presolve;
+  case 2:
+    return profile->cuts;
+  case 3:
+    return profile->heuristics;
+  default:
+    return profile->method;
+  }
+}
+
+int tune_sample(simulation_t *sim, const tune_options_t *options,
+                int jobs_class, sample_t *sample) {
+  int samples = options->samples;
+  if (samples > MAX_SAMPLES)
+    samples = MAX_SAMPLES;
+  sample->train_length = 0;
+  sample->held_out_length = 0;
+  // Instances of the class alternate between the two sets
+  int members = 0;
+  for (size_t i = 0; i < sim->instances->length; i++) {
+    instance_t *instance = sim->instances->values[i];
+    if (stats_class(instance->number_of_jobs, NUMBER_OF_JOBS_UL) != jobs_class)
+      continue;
+    if (members++ % 2 == 0) {
+      if (sample->train_length < samples)
+        sample->train[sample->train_length++] = i;
+    } else if (sample->held_out_length < samples) {
+      sample->held_out[sample->held_out_length++] = i;
+    }
+  }
+  return sample->train_length > 0 && sample->held_out_length > 0 ? 0 : -1;
+}
+
+int tune_store(vector_t *profiles, const profile_t *tuned) {
+  for (size_t k = 0; k < profiles->length; k++) {
+    profile_t *profile = profiles->values[k];
+    if (profile->solver == tuned->solver &&
+        profile->jobs_class == tuned->jobs_class) {
+      *profile = *tuned;
+      return 0;
+    }
+  }
+  profile_t *profile = malloc(sizeof(*profile));
+  if (profile == NULL) {
+    perror("Could not allocate memory for profile");
+    return -1;
+  }
+  *profile = *tuned;
+  return vector_add(profiles, (void **)&profile);
+}
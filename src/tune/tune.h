@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../utils/entities.h"
+
+#define TUNE_SAMPLES 5        // Instances tuned on (and held out) by class
+#define TUNE_SEEDS 3          // Solves of every instance with other seeds
+#define TUNE_TIME_LIMIT 10.0  // Seconds, unsolved runs count twice as much
+#define TUNE_REPORT "output/tune.csv"
+
+typedef struct {
+  const char *filename; // Instances to sample
+  int samples;          // Training (and held out) instances by class
+  int seeds;            // Seeds of every solve
+  double time_limit;    // Time limit of every solve
+  const char *profiles; // Profile file updated with the tuned classes
+} tune_options_t;
+
+// Search MIPFocus, Presolve, Cuts, Heuristics and Method for every
+// (formulation, size class) one parameter at a time, scoring the mean
+// runtime (unsolved: twice the limit) over the training instances and seeds.
+// A profile is saved only when it is also faster on the held out instances
+int tune(const tune_options_t *options);
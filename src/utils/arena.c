@@ -0,0 +1,120 @@
+#include "arena.h"
+#include <stdalign.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct arena_chunk_t {
+  arena_chunk_t *next;
+  size_t size; // Bytes of `data`
+  size_t used;
+  max_align_t data[];
+};
+
+arena_chunk_t *arena_chunk(arena_t *arena, size_t size);
+
+arena_t *arena_init(size_t capacity) {
+  arena_t *arena = malloc(sizeof(*arena));
+  if (arena == NULL) {
+    perror("Could not allocate memory for arena");
+    return NULL;
+  }
+  arena->chunks = NULL;
+  arena->capacity = 0;
+  arena->used = 0;
+  arena->peak = 0;
+  arena->allocations = 0;
+  arena->heap_allocations = 0;
+  if (capacity > 0 && arena_chunk(arena, capacity) == NULL) {
+    free(arena);
+    return NULL;
+  }
+  return arena;
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+  // Rounded so that every buffer starts aligned
+  size_t align = alignof(max_align_t);
+  size = (size + align - 1) / align * align;
+  if (size == 0)
+    size = align;
+
+  arena_chunk_t *chunk = arena->chunks;
+  if (chunk == NULL || chunk->size - chunk->used < size) {
+    // At least doubling the arena, so that it grows a few times at most
+    size_t grow = arena->capacity > ARENA_CHUNK ? arena->capacity : ARENA_CHUNK;
+    if ((chunk = arena_chunk(arena, size > grow ? size : grow)) == NULL)
+      return NULL;
+  }
+  void *buffer = (char *)chunk->data + chunk->used;
+  chunk->used += size;
+  arena->used += size;
+  if (arena->used > arena->peak)
+    arena->peak = arena->used;
+  arena->allocations += 1;
+  return buffer;
+}
+
+char *arena_printf(arena_t *arena, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+  if (length < 0)
+    return NULL;
+
+  char *string = arena_alloc(arena, length + 1);
+  if (string == NULL)
+    return NULL;
+  va_start(args, format);
+  vsnprintf(string, length + 1, format, args);
+  va_end(args);
+  return string;
+}
+
+void arena_reset(arena_t *arena) {
+  arena->used = 0;
+  if (arena->chunks == NULL)
+    return;
+  if (arena->chunks->next == NULL) {
+    arena->chunks->used = 0;
+    return;
+  }
+
+  size_t capacity = arena->capacity;
+  while (arena->chunks != NULL) {
+    arena_chunk_t *next = arena->chunks->next;
+    free(arena->chunks);
+    arena->chunks = next;
+  }
+  arena->capacity = 0;
+  // Without it the next allocation grows the arena again
+  arena_chunk(arena, capacity);
+}
+
+void arena_free(arena_t *arena) {
+  if (arena == NULL)
+    return;
+  while (arena->chunks != NULL) {
+    arena_chunk_t *next = arena->chunks->next;
+    free(arena->chunks);
+    arena->chunks = next;
+  }
+  free(arena);
+}
+
+arena_chunk_t *arena_chunk(arena_t *arena, size_t size) {
+  arena_chunk_t *chunk = malloc(sizeof(*chunk) + size);
+  if (chunk == NULL) {
+    perror("Could not allocate memory for arena chunk");
+    return NULL;
+  }
+  chunk->next = arena->chunks;
+  chunk->size = size;
+  chunk->used = 0;
+  arena->chunks = chunk;
+  arena->capacity += size;
+  arena->heap_allocations += 1;
+  return chunk;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+
+#define ARENA_CHUNK (1 << 20) // Smallest chunk requested from the heap, 1 MB
+
+typedef struct arena_chunk_t arena_chunk_t;
+
+// Linear allocator for the scratch buffers of the model builds of a thread.
+// Allocations are only released together by `arena_reset`, which keeps the
+// memory: once an arena has grown to the largest build, building a model
+// no longer goes through the heap
+typedef struct arena_t {
+  arena_chunk_t *chunks; // Newest first, allocations come from the first one
+  size_t capacity;       // Bytes of every chunk together
+  size_t used;           // Bytes allocated since the last reset
+  size_t peak;           // Most bytes allocated between two resets
+  long allocations;      // Buffers handed out
+  long heap_allocations; // Chunks requested from malloc
+} arena_t;
+
+// Arena with a first chunk of `capacity` bytes (0: on the first allocation)
+arena_t *arena_init(size_t capacity);
+// `size` bytes aligned for any type, valid until the next reset
+void *arena_alloc(arena_t *arena, size_t size);
+char *arena_printf(arena_t *arena, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+// Release every allocation. An arena that had to grow is merged into a
+// single chunk of its capacity, allocated once
+void arena_reset(arena_t *arena);
+void arena_free(arena_t *arena);
@@ -10,7 +10,7 @@ int load_csv(const char *filename, vector_t *vector) {
   FILE *fp = fopen(filename, "r");
   int result = 0;
   if (fp == NULL) {
-    perror(formatted_string("Could not open %s", filename));
+    perror_formatted("Could not open %s", filename);
     return -1;
   }
 
@@ -59,6 +59,8 @@ int load_csv(const char *filename, vector_t *vector) {
       instance->number_of_jobs = number_of_jobs;
       instance->processing_times = p_js;
       instance->release_dates = r_js;
+      instance->orders = NULL;
+      instance->model = NULL;
       if ((result = vector_add(vector, (void **)&instance)) != 0)
         return result;
 
@@ -86,6 +88,8 @@ int load_csv(const char *filename, vector_t *vector) {
   instance->number_of_jobs = number_of_jobs;
   instance->processing_times = p_js;
   instance->release_dates = r_js;
+  instance->orders = NULL;
+  instance->model = NULL;
 
   if ((result = vector_add(vector, (void **)&instance)) != 0)
     return result;
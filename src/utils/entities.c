@@ -3,6 +3,34 @@
 #include <stdlib.h>
 #include <string.h>
 
+const char *solver_name(solver_t solver) {
+  switch (solver) {
+  case Precedence:
+    return "Precedence";
+  case Positional:
+    return "Positional";
+  case TimeIndexed:
+    return "TimeIndexed";
+  case Heuristics_Precedence:
+    return "Heuristics_Precedence";
+  case Heuristics_Positional:
+    return "Heuristics_Positional";
+  case Heuristics_TimeIndexed:
+    return "Heuristics_TimeIndexed";
+  case DynamicProgramming:
+    return "DynamicProgramming";
+  case CompactTimeIndexed:
+    return "CompactTimeIndexed";
+  }
+  return "Unknown";
+}
+
+solver_t solver_formulation(solver_t solver) {
+  if (solver >= Heuristics_Precedence && solver <= Heuristics_TimeIndexed)
+    return solver - Heuristics_Precedence;
+  return solver;
+}
+
 vector_t *vector_init() {
   vector_t *vector = malloc(sizeof(*vector));
   if (vector == NULL) {
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "gurobi_c.h"
+#include <stddef.h>
 #define VECTOR_DEFAULT_SIZE 32
 
 typedef enum {
@@ -9,14 +9,25 @@ typedef enum {
   TimeIndexed,
   Heuristics_Precedence,
   Heuristics_Positional,
-  Heuristics_TimeIndexed
+  Heuristics_TimeIndexed,
+  DynamicProgramming, // Exact without a model, small instances (run/dp.h)
+  CompactTimeIndexed  // Time indexed on "started by t" variables
 } solver_t;
+#define NUMBER_OF_SOLVERS 8
+
+// Permutations of the job indexes, never reordering the instance itself
+typedef struct {
+  int *by_release;    // Sorted by r_j (ties by p_j)
+  int *by_processing; // Sorted by p_j (ties by r_j)
+  int *by_completion; // Sorted by r_j + p_j (ties by p_j)
+} orders_t;
 
 typedef struct {
   int number_of_jobs;
   int *processing_times;
   int *release_dates;
-  GRBmodel *model;
+  orders_t *orders; // Built once by `instance_orders`
+  void *model;      // Model of the simulation backend
 } instance_t;
 
 typedef struct {
@@ -25,21 +36,49 @@ typedef struct {
   void **values;
 } vector_t;
 
+// Engine building and solving the models (see run/backend/backend.h)
+typedef struct backend_t backend_t;
+typedef struct backend_progress_t backend_progress_t;
+// Memory admitted to the solves (see run/memory.h)
+typedef struct memory_t memory_t;
+// Scratch memory of the model builds (see utils/arena.h)
+typedef struct arena_t arena_t;
+
 typedef struct {
-  GRBenv *env;
+  const backend_t *backend;
+  void *env; // Environment of `backend`
   vector_t *instances;
+  vector_t *profiles; // Tuned parameters (see run/profile.h)
+  memory_t *memory;   // Node memory budget, NULL: models are not admitted
+  arena_t *arena;     // Model build buffers, every thread needs its own
+  backend_progress_t *progress; // Told about the next optimize, NULL: none
 } simulation_t;
 
 typedef struct {
   size_t size;            // Number of variables
   solver_t solver;        // Type of model used
-  int status;             // Status code from Gurobi
+  int status;             // Status code from the backend
   double runtime;         // Execution time
-  double objective_value; // z*
-  double *values;         // x*
+  double objective_value; // z*, -1 without a solution
+  double bound;           // Best bound, -1 if not available
+  double gap;             // |bound - z*| / |z*|, -1 if not available
+  double *values;         // C_j of every job in the decoded schedule
   double heuristic_value; // -1 if it's not heuristics
+  double memory;          // Peak GB used by the backend, -1 if not available
 } solution_t;
 
+typedef struct {
+  double wall;   // Wall clock seconds
+  double cpu;    // User + system CPU seconds
+  long peak_rss; // Peak resident set size of the process (KB)
+} measure_t;
+
+// Human readable name of `solver`
+const char *solver_name(solver_t solver);
+// Model built by `solver`: the heuristic variants build the model of their
+// formulation, with a start
+solver_t solver_formulation(solver_t solver);
+
 // Create new vector
 vector_t *vector_init();
 // Add `value` to `vector` (resizing if necessary)
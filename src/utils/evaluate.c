@@ -0,0 +1,315 @@
+#include "evaluate.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EVALUATE_X86
+#include <immintrin.h>
+#endif
+
+// Release date and processing time of a job packed in a single int32, so the
+// SIMD kernels need one gather per position instead of two
+#define PACK_BITS 16
+#define PACK_MASK ((1 << PACK_BITS) - 1)
+
+typedef void (*kernel_t)(const int *packed, int flush, const batch_t *batch,
+                         int to);
+
+void kernel_scalar(const int *r_js, const int *p_js, const batch_t *batch,
+                   int to);
+#ifdef EVALUATE_X86
+void kernel_avx2(const int *packed, int flush, const batch_t *batch, int to);
+void kernel_avx512(const int *packed, int flush, const batch_t *batch, int to);
+#endif
+kernel_t kernel_select(const char **name);
+void kernel_init(void);
+int *batch_block(const batch_t *batch, int k);
+int batch_pack(const instance_t *instance, batch_t *batch);
+
+// Selected once, whichever thread evaluates first
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+static kernel_t kernel = NULL;
+static const char *kernel_name = NULL;
+
+batch_t *batch_init(int number_of_jobs, int capacity) {
+  batch_t *batch = malloc(sizeof(*batch));
+  if (batch == NULL) {
+    perror("Could not allocate memory for batch");
+    return NULL;
+  }
+  // Rounding up to full SIMD blocks, padding lanes are never reported
+  capacity = (capacity + EVALUATE_LANES - 1) / EVALUATE_LANES * EVALUATE_LANES;
+  if (capacity == 0)
+    capacity = EVALUATE_LANES;
+  batch->number_of_jobs = number_of_jobs;
+  batch->capacity = capacity;
+  batch->length = 0;
+  batch->sequences =
+      malloc(sizeof(*batch->sequences) * number_of_jobs * capacity);
+  batch->objectives = malloc(sizeof(*batch->objectives) * capacity);
+  batch->packed = malloc(sizeof(*batch->packed) * number_of_jobs);
+  if (batch->sequences == NULL || batch->objectives == NULL ||
+      batch->packed == NULL) {
+    perror("Could not allocate memory for batch candidates");
+    batch_free(batch);
+    return NULL;
+  }
+  // Padding lanes point to a valid job so gathers stay in bounds
+  memset(batch->sequences, 0,
+         sizeof(*batch->sequences) * number_of_jobs * capacity);
+  return batch;
+}
+
+int batch_add(batch_t *batch, const int *sequence) {
+  if (batch->length == batch->capacity) {
+    fprintf(stderr, "Batch is full (%d candidates)\n", batch->capacity);
+    return -1;
+  }
+  int k = batch->length++;
+  int *block = batch_block(batch, k);
+  for (size_t h = 0; h < batch->number_of_jobs; h++) {
+    block[h * EVALUATE_LANES + k % EVALUATE_LANES] = sequence[h];
+  }
+  return 0;
+}
+
+void batch_clear(batch_t *batch) { batch->length = 0; }
+
+void batch_free(batch_t *batch) {
+  if (batch == NULL)
+    return;
+  free(batch->sequences);
+  batch->sequences = NULL;
+  free(batch->objectives);
+  batch->objectives = NULL;
+  free(batch->packed);
+  batch->packed = NULL;
+  free(batch);
+}
+
+int evaluate_batch(const instance_t *instance, batch_t *batch) {
+  if (instance->number_of_jobs != batch->number_of_jobs) {
+    fprintf(stderr, "Batch has %d jobs, instance has %d\n",
+            batch->number_of_jobs, instance->number_of_jobs);
+    return -1;
+  }
+  pthread_once(&kernel_once, kernel_init);
+
+  int blocks = (batch->length + EVALUATE_LANES - 1) / EVALUATE_LANES;
+  int flush = 0;
+  if (kernel != NULL && (flush = batch_pack(instance, batch)) > 0)
+    kernel(batch->packed, flush, batch, blocks * EVALUATE_LANES);
+  else
+    kernel_scalar(instance->release_dates, instance->processing_times, batch,
+                  blocks * EVALUATE_LANES);
+  return 0;
+}
+
+const char *evaluate_kernel(void) {
+  pthread_once(&kernel_once, kernel_init);
+  return kernel_name;
+}
+
+long long evaluate(const instance_t *instance, const int *sequence, int *c_hs) {
+  long long sum = 0;
+  int c_h = 0;
+  for (size_t h = 0; h < instance->number_of_jobs; h++) {
+    int j = sequence[h];
+    // The next job is not released -> adding idle time until it's released
+    if (c_h < instance->release_dates[j])
+      c_h = instance->release_dates[j];
+    c_h += instance->processing_times[j];
+    if (c_hs != NULL)
+      c_hs[h] = c_h;
+    sum += c_h;
+  }
+  return sum;
+}
+
+long long evaluate_swap_delta(const instance_t *instance, const int *sequence,
+                              const int *c_hs, int a, int b) {
+  if (a > b) {
+    int t = a;
+    a = b;
+    b = t;
+  }
+  long long delta = 0;
+  int c_h = a > 0 ? c_hs[a - 1] : 0;
+  for (int h = a; h < instance->number_of_jobs; h++) {
+    int j = sequence[h];
+    if (h == a)
+      j = sequence[b];
+    else if (h == b)
+      j = sequence[a];
+    if (c_h < instance->release_dates[j])
+      c_h = instance->release_dates[j];
+    c_h += instance->processing_times[j];
+    delta += c_h - c_hs[h];
+    // Same jobs and same completion time: the rest of the schedule is equal
+    if (h > b && c_h == c_hs[h])
+      break;
+  }
+  return delta;
+}
+
+long long evaluate_insert_delta(const instance_t *instance, const int *sequence,
+                                const int *c_hs, int from, int to) {
+  int low = from < to ? from : to;
+  int high = from < to ? to : from;
+  long long delta = 0;
+  int c_h = low > 0 ? c_hs[low - 1] : 0;
+  for (int h = low; h < instance->number_of_jobs; h++) {
+    int j = sequence[h];
+    if (h == to)
+      j = sequence[from];
+    else if (h >= low && h <= high)
+      // Jobs between the two positions shift towards `from`
+      j = from < to ? sequence[h + 1] : sequence[h - 1];
+    if (c_h < instance->release_dates[j])
+      c_h = instance->release_dates[j];
+    c_h += instance->processing_times[j];
+    delta += c_h - c_hs[h];
+    if (h > high && c_h == c_hs[h])
+      break;
+  }
+  return delta;
+}
+
+int *batch_block(const batch_t *batch, int k) {
+  return batch->sequences +
+         (size_t)(k / EVALUATE_LANES) * batch->number_of_jobs * EVALUATE_LANES;
+}
+
+kernel_t kernel_select(const char **name) {
+#ifdef EVALUATE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    *name = "avx512";
+    return kernel_avx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    *name = "avx2";
+    return kernel_avx2;
+  }
+#endif
+  *name = "scalar";
+  return NULL;
+}
+
+void kernel_init(void) { kernel = kernel_select(&kernel_name); }
+
+int batch_pack(const instance_t *instance, batch_t *batch) {
+  // Upper bound on every completion time: max r_j + sum p_j
+  long long bound = 0;
+  int max_r_j = 0;
+  for (size_t j = 0; j < instance->number_of_jobs; j++) {
+    int r_j = instance->release_dates[j];
+    int p_j = instance->processing_times[j];
+    if (r_j < 0 || r_j > PACK_MASK || p_j < 0 || p_j > PACK_MASK)
+      return 0;
+    batch->packed[j] = r_j | p_j << PACK_BITS;
+    bound += p_j;
+    if (r_j > max_r_j)
+      max_r_j = r_j;
+  }
+  bound += max_r_j;
+  if (bound == 0)
+    return INT_MAX;
+  if (bound > INT_MAX)
+    return 0;
+  // Positions that can be summed in int32 without overflowing
+  return INT_MAX / bound;
+}
+
+void kernel_scalar(const int *r_js, const int *p_js, const batch_t *batch,
+                   int to) {
+  for (int k = 0; k < to; k += EVALUATE_LANES) {
+    const int *block = batch_block(batch, k);
+    int c[EVALUATE_LANES] = {0};
+    long long sum[EVALUATE_LANES] = {0};
+    for (size_t h = 0; h < batch->number_of_jobs; h++) {
+      const int *jobs = block + h * EVALUATE_LANES;
+      for (size_t l = 0; l < EVALUATE_LANES; l++) {
+        int r_j = r_js[jobs[l]];
+        if (c[l] < r_j)
+          c[l] = r_j;
+        c[l] += p_js[jobs[l]];
+        sum[l] += c[l];
+      }
+    }
+    memcpy(batch->objectives + k, sum, sizeof(sum));
+  }
+}
+
+#ifdef EVALUATE_X86
+__attribute__((target("avx2"))) void kernel_avx2(const int *packed, int flush,
+                                                 const batch_t *batch, int to) {
+  const __m256i mask = _mm256_set1_epi32(PACK_MASK);
+  for (int k = 0; k < to; k += 8) {
+    // Two 8 lanes halves for every block of EVALUATE_LANES candidates
+    const int *block = batch_block(batch, k) + k % EVALUATE_LANES;
+    __m256i c = _mm256_setzero_si256();
+    __m256i partial = _mm256_setzero_si256();
+    __m256i sum_low = _mm256_setzero_si256();
+    __m256i sum_high = _mm256_setzero_si256();
+    int steps = 0;
+    for (size_t h = 0; h < batch->number_of_jobs; h++) {
+      __m256i jobs =
+          _mm256_loadu_si256((const __m256i *)(block + h * EVALUATE_LANES));
+      __m256i rp_j = _mm256_i32gather_epi32(packed, jobs, 4);
+      __m256i r_j = _mm256_and_si256(rp_j, mask);
+      __m256i p_j = _mm256_srli_epi32(rp_j, PACK_BITS);
+      c = _mm256_add_epi32(_mm256_max_epi32(c, r_j), p_j);
+      partial = _mm256_add_epi32(partial, c);
+      // Widening to 64 bits before the int32 partial sums can overflow
+      if (++steps == flush || h + 1 == batch->number_of_jobs) {
+        sum_low = _mm256_add_epi64(
+            sum_low, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(partial)));
+        sum_high = _mm256_add_epi64(
+            sum_high,
+            _mm256_cvtepi32_epi64(_mm256_extracti128_si256(partial, 1)));
+        partial = _mm256_setzero_si256();
+        steps = 0;
+      }
+    }
+    _mm256_storeu_si256((__m256i *)(batch->objectives + k), sum_low);
+    _mm256_storeu_si256((__m256i *)(batch->objectives + k + 4), sum_high);
+  }
+}
+
+__attribute__((target("avx512f"))) void
+kernel_avx512(const int *packed, int flush, const batch_t *batch, int to) {
+  const __m512i mask = _mm512_set1_epi32(PACK_MASK);
+  for (int k = 0; k < to; k += 16) {
+    const int *block = batch_block(batch, k);
+    __m512i c = _mm512_setzero_si512();
+    __m512i partial = _mm512_setzero_si512();
+    __m512i sum_low = _mm512_setzero_si512();
+    __m512i sum_high = _mm512_setzero_si512();
+    int steps = 0;
+    for (size_t h = 0; h < batch->number_of_jobs; h++) {
+      __m512i jobs = _mm512_loadu_si512(block + h * EVALUATE_LANES);
+      __m512i rp_j = _mm512_i32gather_epi32(jobs, packed, 4);
+      __m512i r_j = _mm512_and_si512(rp_j, mask);
+      __m512i p_j = _mm512_srli_epi32(rp_j, PACK_BITS);
+      c = _mm512_add_epi32(_mm512_max_epi32(c, r_j), p_j);
+      partial = _mm512_add_epi32(partial, c);
+      if (++steps == flush || h + 1 == batch->number_of_jobs) {
+        sum_low = _mm512_add_epi64(
+            sum_low, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(partial)));
+        sum_high = _mm512_add_epi64(
+            sum_high,
+            _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(partial, 1)));
+        partial = _mm512_setzero_si512();
+        steps = 0;
+      }
+    }
+    _mm512_storeu_si512(batch->objectives + k, sum_low);
+    _mm512_storeu_si512(batch->objectives + k + 8, sum_high);
+  }
+}
+#endif
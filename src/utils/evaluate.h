@@ -0,0 +1,45 @@
+#pragma once
+
+#include "entities.h"
+
+// Candidates per block: widest supported SIMD kernel (AVX-512, 16 x int32)
+#define EVALUATE_LANES 16
+
+// Batch of candidate permutations in SoA layout, blocked by EVALUATE_LANES
+// candidates: the job in position h of candidate k is at
+// `sequences[(k / LANES * number_of_jobs + h) * LANES + k % LANES]`, so each
+// SIMD lane walks one candidate while every block stays contiguous in memory
+typedef struct {
+  int number_of_jobs;
+  int capacity;          // Allocated candidates (multiple of EVALUATE_LANES)
+  int length;            // Candidates added so far
+  int *sequences;        // number_of_jobs * capacity job indexes
+  long long *objectives; // sum C_j of every candidate after `evaluate_batch`
+  int *packed;           // r_j | p_j << 16 of the evaluated instance
+} batch_t;
+
+// Create new batch able to hold `capacity` candidates
+batch_t *batch_init(int number_of_jobs, int capacity);
+// Add `sequence` as the next candidate (transposing it into the SoA layout)
+int batch_add(batch_t *batch, const int *sequence);
+// Remove every candidate, keeping the allocated memory
+void batch_clear(batch_t *batch);
+void batch_free(batch_t *batch);
+
+// Compute sum C_j of every candidate in `batch` with the best kernel for the
+// running CPU: C_[h] = max(C_[h-1], r_[h]) + p_[h]. The SIMD kernels need
+// r_j, p_j < 2^16, other instances fall back to the scalar kernel
+int evaluate_batch(const instance_t *instance, batch_t *batch);
+// Name of the kernel selected by `evaluate_batch` ("avx512", "avx2", "scalar")
+const char *evaluate_kernel(void);
+
+// Sum C_j of a single `sequence`, if `c_hs` is not NULL it's filled with the
+// completion time of every position
+long long evaluate(const instance_t *instance, const int *sequence, int *c_hs);
+// Change in sum C_j when swapping positions `a` and `b` of `sequence`, given
+// `c_hs` from `evaluate`; only the positions that actually change are visited
+long long evaluate_swap_delta(const instance_t *instance, const int *sequence,
+                              const int *c_hs, int a, int b);
+// Change in sum C_j when moving the job in position `from` to position `to`
+long long evaluate_insert_delta(const instance_t *instance, const int *sequence,
+                                const int *c_hs, int from, int to);
@@ -0,0 +1,72 @@
+#include "queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int queue_init(queue_t *queue, int capacity, size_t size) {
+  queue->items = malloc(size * capacity);
+  if (queue->items == NULL) {
+    perror("Could not allocate memory for the queue");
+    return -1;
+  }
+  queue->size = size;
+  queue->capacity = capacity;
+  queue->head = 0;
+  queue->length = 0;
+  queue->closed = 0;
+  if (pthread_mutex_init(&queue->lock, NULL) != 0 ||
+      pthread_cond_init(&queue->not_empty, NULL) != 0 ||
+      pthread_cond_init(&queue->not_full, NULL) != 0) {
+    perror("Could not initialize the queue");
+    free(queue->items);
+    return -1;
+  }
+  return 0;
+}
+
+void queue_free(queue_t *queue, void (*item_free)(void *item)) {
+  while (queue->length > 0) {
+    if (item_free != NULL)
+      item_free(queue->items + queue->head * queue->size);
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->length -= 1;
+  }
+  pthread_mutex_destroy(&queue->lock);
+  pthread_cond_destroy(&queue->not_empty);
+  pthread_cond_destroy(&queue->not_full);
+  free(queue->items);
+  queue->items = NULL;
+}
+
+void queue_push(queue_t *queue, const void *item) {
+  pthread_mutex_lock(&queue->lock);
+  while (queue->length == queue->capacity)
+    pthread_cond_wait(&queue->not_full, &queue->lock);
+  int tail = (queue->head + queue->length) % queue->capacity;
+  memcpy(queue->items + tail * queue->size, item, queue->size);
+  queue->length += 1;
+  pthread_cond_signal(&queue->not_empty);
+  pthread_mutex_unlock(&queue->lock);
+}
+
+int queue_pop(queue_t *queue, void *item) {
+  pthread_mutex_lock(&queue->lock);
+  while (queue->length == 0 && !queue->closed)
+    pthread_cond_wait(&queue->not_empty, &queue->lock);
+  int popped = queue->length > 0;
+  if (popped) {
+    memcpy(item, queue->items + queue->head * queue->size, queue->size);
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->length -= 1;
+    pthread_cond_signal(&queue->not_full);
+  }
+  pthread_mutex_unlock(&queue->lock);
+  return popped;
+}
+
+void queue_close(queue_t *queue) {
+  pthread_mutex_lock(&queue->lock);
+  queue->closed = 1;
+  pthread_cond_broadcast(&queue->not_empty);
+  pthread_mutex_unlock(&queue->lock);
+}
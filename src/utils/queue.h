@@ -0,0 +1,28 @@
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+
+// Bounded FIFO of items of `size` bytes between a producer and the worker
+// threads: pushing waits for room, popping for an item
+typedef struct {
+  char *items;
+  size_t size; // Bytes of an item
+  int capacity;
+  int head;
+  int length;
+  int closed; // Nothing else will be pushed
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+} queue_t;
+
+int queue_init(queue_t *queue, int capacity, size_t size);
+// `item_free` gets the items left over, only there when no worker could
+// start (NULL: nothing to free)
+void queue_free(queue_t *queue, void (*item_free)(void *item));
+void queue_push(queue_t *queue, const void *item);
+// Copy the next item to `item`, 0 once the queue is closed and empty
+int queue_pop(queue_t *queue, void *item);
+// Wake the workers waiting for an item that will never come
+void queue_close(queue_t *queue);
@@ -0,0 +1,245 @@
+#include "results.h"
+#include "utils.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t length;
+  uint32_t bytes; // Payload following the header
+} block_header_t;
+
+typedef struct {
+  size_t offset; // Offset of the column in results_block_t
+  size_t size;   // Size of one element
+} column_t;
+
+#define INT_COLUMN(name)                                                       \
+  { offsetof(results_block_t, name), sizeof(int) }
+#define DOUBLE_COLUMN(name)                                                    \
+  { offsetof(results_block_t, name), sizeof(double) }
+#define KEY_COLUMN(name)                                                       \
+  { offsetof(results_block_t, name), sizeof(unsigned long long) }
+
+// Order of the columns on disk, new versions only append columns
+static const column_t COLUMNS[] = {
+    INT_COLUMN(solver),          INT_COLUMN(instance),
+    INT_COLUMN(status),          INT_COLUMN(number_of_jobs),
+    INT_COLUMN(min_p_j),         INT_COLUMN(max_p_j),
+    INT_COLUMN(min_r_j),         INT_COLUMN(max_r_j),
+    DOUBLE_COLUMN(runtime),      DOUBLE_COLUMN(objective_value),
+    DOUBLE_COLUMN(bound),        DOUBLE_COLUMN(gap),
+    DOUBLE_COLUMN(heuristic_value),
+    DOUBLE_COLUMN(variables),    DOUBLE_COLUMN(nonzeros),
+    DOUBLE_COLUMN(memory),       KEY_COLUMN(key)};
+#define NUMBER_OF_COLUMNS (sizeof(COLUMNS) / sizeof(*COLUMNS))
+#define VERSION_1_COLUMNS 13
+#define VERSION_2_COLUMNS 16
+
+size_t results_columns(uint32_t version);
+size_t results_record_size(size_t columns);
+
+results_t *results_open(const char *filename) {
+  results_t *results = malloc(sizeof(*results));
+  if (results == NULL) {
+    perror("Could not allocate memory for results");
+    return NULL;
+  }
+  results->block = malloc(sizeof(*results->block));
+  results->buffer =
+      malloc(sizeof(block_header_t) +
+             results_record_size(NUMBER_OF_COLUMNS) * RESULTS_BLOCK);
+  if (results->block == NULL || results->buffer == NULL) {
+    perror("Could not allocate memory for results block");
+    free(results->block);
+    free(results->buffer);
+    free(results);
+    return NULL;
+  }
+  results->block->length = 0;
+
+  if ((results->fp = fopen(filename, "ab")) == NULL) {
+    perror_formatted("Could not open %s", filename);
+    free(results->block);
+    free(results->buffer);
+    free(results);
+    return NULL;
+  }
+  // One fwrite must be one write
+  setvbuf(results->fp, NULL, _IONBF, 0);
+  return results;
+}
+
+int results_append(results_t *results, const result_t *result) {
+  results_block_t *block = results->block;
+  int k = block->length;
+  block->solver[k] = result->solver;
+  block->instance[k] = result->instance;
+  block->status[k] = result->status;
+  block->number_of_jobs[k] = result->number_of_jobs;
+  block->min_p_j[k] = result->min_p_j;
+  block->max_p_j[k] = result->max_p_j;
+  block->min_r_j[k] = result->min_r_j;
+  block->max_r_j[k] = result->max_r_j;
+  block->runtime[k] = result->runtime;
+  block->objective_value[k] = result->objective_value;
+  block->bound[k] = result->bound;
+  block->gap[k] = result->gap;
+  block->heuristic_value[k] = result->heuristic_value;
+  block->variables[k] = result->variables;
+  block->nonzeros[k] = result->nonzeros;
+  block->memory[k] = result->memory;
+  block->key[k] = result->key;
+  block->length += 1;
+
+  if (block->length == RESULTS_BLOCK)
+    return results_flush(results);
+  return 0;
+}
+
+int results_flush(results_t *results) {
+  results_block_t *block = results->block;
+  if (block->length == 0)
+    return 0;
+
+  block_header_t header = {.magic = RESULTS_MAGIC,
+                           .version = RESULTS_VERSION,
+                           .length = block->length,
+                           .bytes = results_record_size(NUMBER_OF_COLUMNS) *
+                                    block->length};
+  char *cursor = results->buffer;
+  memcpy(cursor, &header, sizeof(header));
+  cursor += sizeof(header);
+  for (size_t c = 0; c < NUMBER_OF_COLUMNS; c++) {
+    size_t bytes = COLUMNS[c].size * block->length;
+    memcpy(cursor, (char *)block + COLUMNS[c].offset, bytes);
+    cursor += bytes;
+  }
+
+  size_t size = cursor - results->buffer;
+  if (fwrite(results->buffer, 1, size, results->fp) != size) {
+    perror("Could not append results block");
+    return -1;
+  }
+  block->length = 0;
+  return 0;
+}
+
+int results_close(results_t *results) {
+  int result = results_flush(results);
+  fclose(results->fp);
+  free(results->block);
+  results->block = NULL;
+  free(results->buffer);
+  results->buffer = NULL;
+  free(results);
+  return result;
+}
+
+int results_scan(const char *filename, results_callback_t callback,
+                 void *data) {
+  FILE *fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    perror_formatted("Could not open %s", filename);
+    return -1;
+  }
+  results_block_t *block = malloc(sizeof(*block));
+  if (block == NULL) {
+    perror("Could not allocate memory for results block");
+    fclose(fp);
+    return -1;
+  }
+
+  int result = 0;
+  block_header_t header;
+  while (result == 0 && fread(&header, sizeof(header), 1, fp) == 1) {
+    if (header.magic != RESULTS_MAGIC) {
+      fprintf(stderr, "%s is not a results store\n", filename);
+      result = -1;
+      break;
+    }
+    // Blocks of unknown versions are skipped as a whole
+    size_t columns = results_columns(header.version);
+    if (columns == 0 || header.length > RESULTS_BLOCK ||
+        header.bytes != results_record_size(columns) * header.length) {
+      if (fseek(fp, header.bytes, SEEK_CUR) != 0) {
+        result = -1;
+        break;
+      }
+      continue;
+    }
+
+    block->length = header.length;
+    // Columns appended after the version of the block are not available
+    for (size_t c = columns; c < NUMBER_OF_COLUMNS; c++) {
+      if (COLUMNS[c].offset == offsetof(results_block_t, key)) {
+        memset(block->key, 0, sizeof(*block->key) * block->length);
+        continue;
+      }
+      double *column = (double *)((char *)block + COLUMNS[c].offset);
+      for (size_t k = 0; k < block->length; k++) {
+        column[k] = -1;
+      }
+    }
+    for (size_t c = 0; c < columns; c++) {
+      char *column = (char *)block + COLUMNS[c].offset;
+      if (fread(column, COLUMNS[c].size, block->length, fp) != block->length) {
+        // Block cut by a worker that did not finish its write
+        fprintf(stderr, "Truncated block in %s\n", filename);
+        result = -1;
+        break;
+      }
+    }
+    if (result == 0)
+      result = callback(block, data);
+  }
+
+  free(block);
+  block = NULL;
+  fclose(fp);
+  return result;
+}
+
+void results_features(const instance_t *instance, result_t *result) {
+  result->number_of_jobs = instance->number_of_jobs;
+  result->min_p_j = instance->processing_times[0];
+  result->max_p_j = instance->processing_times[0];
+  result->min_r_j = instance->release_dates[0];
+  result->max_r_j = instance->release_dates[0];
+  for (size_t j = 1; j < instance->number_of_jobs; j++) {
+    int p_j = instance->processing_times[j];
+    int r_j = instance->release_dates[j];
+    if (p_j < result->min_p_j)
+      result->min_p_j = p_j;
+    if (p_j > result->max_p_j)
+      result->max_p_j = p_j;
+    if (r_j < result->min_r_j)
+      result->min_r_j = r_j;
+    if (r_j > result->max_r_j)
+      result->max_r_j = r_j;
+  }
+}
+
+size_t results_columns(uint32_t version) {
+  switch (version) {
+  case 1:
+    return VERSION_1_COLUMNS;
+  case 2:
+    return VERSION_2_COLUMNS;
+  case RESULTS_VERSION:
+    return NUMBER_OF_COLUMNS;
+  default:
+    return 0;
+  }
+}
+
+size_t results_record_size(size_t columns) {
+  size_t size = 0;
+  for (size_t c = 0; c < columns; c++) {
+    size += COLUMNS[c].size;
+  }
+  return size;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "entities.h"
+#include <stdio.h>
+
+#define RESULTS_STORE "output/results.amod"
+#define RESULTS_BLOCK 4096 // Records buffered before a block is appended
+#define RESULTS_MAGIC 0x53524d41 // "AMRS"
+// Version 1 blocks lack the model size columns, version 2 the instance key
+#define RESULTS_VERSION 3
+
+// One solve: the instance features are kept so that the store can be
+// aggregated without the instance files
+typedef struct {
+  solver_t solver;
+  int instance; // Number of the instance in its file (starting from 1)
+  int status;
+  int number_of_jobs;
+  int min_p_j;
+  int max_p_j;
+  int min_r_j;
+  int max_r_j;
+  double runtime;
+  double objective_value; // -1 without a solution
+  double bound;           // Best bound, -1 if not available
+  double gap;             // |bound - z| / |z|, -1 if not available
+  double heuristic_value; // -1 if it's not heuristics
+  double variables;       // Size of the model, -1 if not built
+  double nonzeros;
+  double memory; // Peak GB used by the backend, -1 if not available
+  // Hash of the jobs (`cache_hash`): the numbers of the instances of
+  // different files, pipeline sweeps and imports collide, 0 if not available
+  unsigned long long key;
+} result_t;
+
+// Records stored column by column: a block on disk is a header (magic,
+// version, number of records, payload bytes) followed by every column
+typedef struct {
+  int length;
+  int solver[RESULTS_BLOCK];
+  int instance[RESULTS_BLOCK];
+  int status[RESULTS_BLOCK];
+  int number_of_jobs[RESULTS_BLOCK];
+  int min_p_j[RESULTS_BLOCK];
+  int max_p_j[RESULTS_BLOCK];
+  int min_r_j[RESULTS_BLOCK];
+  int max_r_j[RESULTS_BLOCK];
+  double runtime[RESULTS_BLOCK];
+  double objective_value[RESULTS_BLOCK];
+  double bound[RESULTS_BLOCK];
+  double gap[RESULTS_BLOCK];
+  double heuristic_value[RESULTS_BLOCK];
+  double variables[RESULTS_BLOCK];
+  double nonzeros[RESULTS_BLOCK];
+  double memory[RESULTS_BLOCK];
+  unsigned long long key[RESULTS_BLOCK];
+} results_block_t;
+
+// Appender of a store: every block is written with a single write on a file
+// opened in append mode, so concurrent workers (each with its own appender)
+// never interleave their records
+typedef struct {
+  FILE *fp;
+  results_block_t *block;
+  char *buffer; // Serialized block
+} results_t;
+
+typedef int (*results_callback_t)(const results_block_t *block, void *data);
+
+// Open `filename` for appending, creating it if needed
+results_t *results_open(const char *filename);
+// Buffer a record, appending the block when it is full. Writers of slow
+// records flush after each, so that a crash keeps what was finished
+int results_append(results_t *results, const result_t *result);
+// Append the buffered records
+int results_flush(results_t *results);
+// Flush and close
+int results_close(results_t *results);
+// Call `callback` on every block of `filename` in order, stopping at the
+// first non zero value returned
+int results_scan(const char *filename, results_callback_t callback,
+                 void *data);
+// Fill the instance features of `result`
+void results_features(const instance_t *instance, result_t *result);
@@ -1,12 +1,16 @@
 #include "utils.h"
 #include "entities.h"
+#include "../run/backend/backend.h"
 
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #ifdef __linux__
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #elif _WIN32
@@ -14,9 +18,9 @@
 #include <windows.h>
 #endif
 
-void quicksort(instance_t *instance, int *indexes, int low, int high);
-int partition(instance_t *instance, int *indexes, int low, int high);
-void swap(int *a, int *b);
+#define RADIX_BITS 16
+#define RADIX_BUCKETS (1u << RADIX_BITS)
+#define MESSAGE_LENGTH 512 // Longer perror_formatted messages are cut
 
 char *formatted_string(const char *format, ...) {
   va_list arg;
@@ -35,10 +39,22 @@ char *formatted_string(const char *format, ...) {
   return buf;
 }
 
+void perror_formatted(const char *format, ...) {
+  // The errno of the failure, not one of the formatting
+  int error = errno;
+  char message[MESSAGE_LENGTH];
+  va_list arg;
+  va_start(arg, format);
+  vsnprintf(message, sizeof(message), format, arg);
+  va_end(arg);
+  errno = error;
+  perror(message);
+}
+
 void log_error(simulation_t *sim, int result, const char *cause) {
-  const char *error = GRBgeterrormsg(sim->env);
-  perror(formatted_string("Error %s (code: %d) caused by: %s", error, result,
-                          cause));
+  const char *error = sim->backend->error_message(sim->env);
+  perror_formatted("Error %s (code: %d) caused by: %s", error, result,
+                   cause);
 }
 
 int create_folder(const char *path) {
@@ -63,42 +79,152 @@ int create_folder(const char *path) {
   return result;
 }
 
-void sort(instance_t *instance, int *indexes) {
-  quicksort(instance, indexes, 0, instance->number_of_jobs - 1);
+void measure_now(measure_t *measure) {
+#ifdef __linux__
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  measure->wall = ts.tv_sec + ts.tv_nsec / 1e9;
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  measure->cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                 usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+  measure->peak_rss = usage.ru_maxrss;
+#else
+  measure->wall = (double)time(NULL);
+  measure->cpu = (double)clock() / CLOCKS_PER_SEC;
+  measure->peak_rss = 0;
+#endif
 }
 
-void quicksort(instance_t *instance, int *indexes, int low, int high) {
-  if (low >= high)
-    return;
-  int pi = partition(instance, indexes, low, high);
-
-  quicksort(instance, indexes, low, pi - 1);
-  quicksort(instance, indexes, pi + 1, high);
+void measure_add(measure_t *total, const measure_t *start,
+                 const measure_t *end) {
+  total->wall += end->wall - start->wall;
+  total->cpu += end->cpu - start->cpu;
+  if (end->peak_rss > total->peak_rss)
+    total->peak_rss = end->peak_rss;
 }
 
-int partition(instance_t *instance, int *indexes, int low, int high) {
-  int pivot = instance->release_dates[high];
+const orders_t *instance_orders(instance_t *instance) {
+  if (instance->orders != NULL)
+    return instance->orders;
 
-  int i = low - 1;
+  int n = instance->number_of_jobs;
+  int *r_js = instance->release_dates;
+  int *p_js = instance->processing_times;
+  orders_t *orders = malloc(sizeof(*orders));
+  if (orders == NULL) {
+    perror("Could not allocate memory for orders");
+    return NULL;
+  }
+  int *c_js = malloc(sizeof(*c_js) * n);
+  orders->by_release = malloc(sizeof(*orders->by_release) * n);
+  orders->by_processing = malloc(sizeof(*orders->by_processing) * n);
+  orders->by_completion = malloc(sizeof(*orders->by_completion) * n);
+  if (c_js == NULL || orders->by_release == NULL ||
+      orders->by_processing == NULL || orders->by_completion == NULL) {
+    perror("Could not allocate memory for orders");
+    free(c_js);
+    free(orders->by_release);
+    free(orders->by_processing);
+    free(orders->by_completion);
+    free(orders);
+    return NULL;
+  }
 
-  for (int j = low; j < high; j++) {
-    if (instance->release_dates[j] < pivot) {
-      i += 1;
-      swap(&instance->release_dates[i], &instance->release_dates[j]);
-      swap(&instance->processing_times[i], &instance->processing_times[j]);
-      swap(&indexes[i], &indexes[j]);
-    }
+  for (int j = 0; j < n; j++) {
+    c_js[j] = r_js[j] + p_js[j];
+    orders->by_release[j] = j;
+    orders->by_processing[j] = j;
+    orders->by_completion[j] = j;
   }
 
-  swap(&instance->release_dates[i + 1], &instance->release_dates[high]);
-  swap(&instance->processing_times[i + 1], &instance->processing_times[high]);
-  swap(&indexes[i + 1], &indexes[high]);
+  // LSD: sorting by the tie breaker first, the stable pass keeps it
+  int result = 0;
+  if ((result = radix_sort(p_js, orders->by_release, n)) == 0)
+    result = radix_sort(r_js, orders->by_release, n);
+  if (result == 0 && (result = radix_sort(r_js, orders->by_processing, n)) == 0)
+    result = radix_sort(p_js, orders->by_processing, n);
+  if (result == 0 && (result = radix_sort(p_js, orders->by_completion, n)) == 0)
+    result = radix_sort(c_js, orders->by_completion, n);
+  free(c_js);
+  c_js = NULL;
 
-  return i + 1;
+  instance->orders = orders;
+  if (result != 0) {
+    instance_orders_free(instance);
+    return NULL;
+  }
+  return orders;
+}
+
+void instance_orders_free(instance_t *instance) {
+  orders_t *orders = instance->orders;
+  if (orders == NULL)
+    return;
+  free(orders->by_release);
+  free(orders->by_processing);
+  free(orders->by_completion);
+  free(orders);
+  instance->orders = NULL;
 }
 
-void swap(int *a, int *b) {
-  int t = *a;
-  *a = *b;
-  *b = t;
+int radix_sort(const int *keys, int *indexes, int n) {
+  if (n <= 1)
+    return 0;
+
+  int min = keys[indexes[0]];
+  int max = min;
+  for (int i = 1; i < n; i++) {
+    int key = keys[indexes[i]];
+    if (key < min)
+      min = key;
+    if (key > max)
+      max = key;
+  }
+  unsigned int range = (unsigned int)max - (unsigned int)min;
+  // Small ranges (like the generated ones) are sorted in a single pass
+  size_t buckets = RADIX_BUCKETS;
+  if (range < RADIX_BUCKETS)
+    buckets = range + 1;
+
+  size_t *count = malloc(sizeof(*count) * buckets);
+  int *scratch = malloc(sizeof(*scratch) * n);
+  if (count == NULL || scratch == NULL) {
+    perror("Could not allocate memory for radix sort");
+    free(count);
+    free(scratch);
+    return -1;
+  }
+
+  int *from = indexes;
+  int *to = scratch;
+  unsigned int shift = 0;
+  do {
+    memset(count, 0, sizeof(*count) * buckets);
+    for (int i = 0; i < n; i++) {
+      unsigned int key = (unsigned int)keys[from[i]] - (unsigned int)min;
+      count[(key >> shift) & (RADIX_BUCKETS - 1)] += 1;
+    }
+    size_t total = 0;
+    for (size_t b = 0; b < buckets; b++) {
+      size_t c = count[b];
+      count[b] = total;
+      total += c;
+    }
+    for (int i = 0; i < n; i++) {
+      unsigned int key = (unsigned int)keys[from[i]] - (unsigned int)min;
+      to[count[(key >> shift) & (RADIX_BUCKETS - 1)]++] = from[i];
+    }
+    int *t = from;
+    from = to;
+    to = t;
+    shift += RADIX_BITS;
+  } while (shift < sizeof(range) * 8 && (range >> shift) != 0);
+
+  if (from != indexes)
+    memcpy(indexes, from, sizeof(*indexes) * n);
+
+  free(count);
+  free(scratch);
+  return 0;
 }
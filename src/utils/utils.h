@@ -4,9 +4,23 @@
 
 char *formatted_string(const char *format, ...)
     __attribute__((format(printf, 1, 2)));
+// perror of a formatted message, without allocating it
+void perror_formatted(const char *format, ...)
+    __attribute__((format(printf, 1, 2)));
 
 void log_error(simulation_t *sim, int result, const char *cause);
 
 int create_folder(const char *path);
 
-void sort(instance_t *instance, int *indexes);
+// Current process usage, subtract two readings to measure a stage
+void measure_now(measure_t *measure);
+// Add the usage between `start` and `end` to `total` (peak RSS is the max)
+void measure_add(measure_t *total, const measure_t *start,
+                 const measure_t *end);
+
+// Sorted views of the instance jobs (built on first use, then shared)
+const orders_t *instance_orders(instance_t *instance);
+void instance_orders_free(instance_t *instance);
+
+// Stable sort of `indexes` by `keys[indexes[i]]` in O(n + range)
+int radix_sort(const int *keys, int *indexes, int n);
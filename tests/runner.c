@@ -1,10 +1,30 @@
+#include <pthread.h>
 #include <stdio.h>
+#include <stdalign.h>
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "../src/merge/merge.h"
+#include "../src/online/online.h"
+#include "../src/report/report.h"
+#include "../src/run/backend/backend.h"
+#include "../src/run/block.h"
+#include "../src/run/cache.h"
+#include "../src/run/dominance.h"
+#include "../src/run/dp.h"
+#include "../src/run/lns.h"
+#include "../src/run/memory.h"
 #include "../src/run/model/model.h"
+#include "../src/run/refine.h"
 #include "../src/run/run.h"
+#include "../src/run/status.h"
+#include "../src/serve/serve.h"
+#include "../src/utils/arena.h"
 #include "../src/utils/entities.h"
-#include "gurobi_c.h"
+#include "../src/utils/evaluate.h"
+#include "../src/utils/results.h"
+#include "../src/utils/utils.h"
 
 solution_t *model_precedence_test(simulation_t *simulation);
 solution_t *model_positional_test(simulation_t *simulation);
@@ -12,6 +32,27 @@ solution_t *model_timeindexed_test(simulation_t *simulation);
 solution_t *model_heuristics_precedence_test(simulation_t *simulation);
 solution_t *model_heuristics_positional_test(simulation_t *simulation);
 solution_t *model_heuristics_time_indexed_test(simulation_t *simulation);
+solution_t *model_compact_time_indexed_test(simulation_t *simulation);
+int orders_test(instance_t *instance);
+int evaluate_test(instance_t *instance);
+int results_test(instance_t *instance);
+int results_count(const results_block_t *block, void *data);
+int report_test(void);
+int cache_test(instance_t *instance);
+void *cache_put_thread(void *data);
+int blocks_test(simulation_t *sim, instance_t *instance);
+int dominance_test(void);
+int refine_test(simulation_t *sim, instance_t *instance);
+int memory_test(simulation_t *sim, instance_t *instance);
+int lns_test(simulation_t *sim, instance_t *instance);
+int relax_test(simulation_t *sim);
+int online_test(simulation_t *sim);
+int serve_test(simulation_t *sim);
+int dp_test(instance_t *instance);
+int arena_test(simulation_t *sim);
+int status_test(simulation_t *sim);
+int shard_test(void);
+int shard_rows(const char *filename, double rows[][4], int length);
 
 int main(void) {
   int result = 0;
@@ -25,6 +66,7 @@ int main(void) {
   dummy_instance->number_of_jobs = 3;
   dummy_instance->processing_times = processing_times;
   dummy_instance->release_dates = release_dates;
+  dummy_instance->orders = NULL;
   dummy_instance->model = NULL;
 
   vector_t *instances = vector_init();
@@ -32,11 +74,117 @@ int main(void) {
     return -1;
   if ((result = vector_add(instances, (void **)&dummy_instance)) != 0)
     return result;
+  if ((result = create_folder("output")) != 0)
+    return result;
   simulation_t *sim = environment_init(instances);
+  if (sim == NULL)
+    return -1;
   solution_t *solution;
 
   // Execute tests
   printf("---------------------------\n");
+  printf("Orders Test\n");
+  if (orders_test(dummy_instance) != 0) {
+    result = -1;
+    perror("Orders Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Evaluate Test\n");
+  if (evaluate_test(dummy_instance) != 0) {
+    result = -1;
+    perror("Evaluate Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Results Test\n");
+  if (results_test(dummy_instance) != 0) {
+    result = -1;
+    perror("Results Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Report Test\n");
+  if (report_test() != 0) {
+    result = -1;
+    perror("Report Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Cache Test\n");
+  if (cache_test(dummy_instance) != 0) {
+    result = -1;
+    perror("Cache Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Blocks Test\n");
+  if (blocks_test(sim, dummy_instance) != 0) {
+    result = -1;
+    perror("Blocks Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Dominance Test\n");
+  if (dominance_test() != 0) {
+    result = -1;
+    perror("Dominance Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Refine Test\n");
+  if (refine_test(sim, dummy_instance) != 0) {
+    result = -1;
+    perror("Refine Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Relax Test\n");
+  if (relax_test(sim) != 0) {
+    result = -1;
+    perror("Relax Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Online Test\n");
+  if (online_test(sim) != 0) {
+    result = -1;
+    perror("Online Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Serve Test\n");
+  if (serve_test(sim) != 0) {
+    result = -1;
+    perror("Serve Test failed");
+  }
+  printf("---------------------------\n");
+  printf("LNS Test\n");
+  if (lns_test(sim, dummy_instance) != 0) {
+    result = -1;
+    perror("LNS Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Memory Test\n");
+  if (memory_test(sim, dummy_instance) != 0) {
+    result = -1;
+    perror("Memory Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Dynamic Programming Test\n");
+  if (dp_test(dummy_instance) != 0) {
+    result = -1;
+    perror("Dynamic Programming Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Arena Test\n");
+  if (arena_test(sim) != 0) {
+    result = -1;
+    perror("Arena Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Status Test\n");
+  if (status_test(sim) != 0) {
+    result = -1;
+    perror("Status Test failed");
+  }
+  printf("---------------------------\n");
+  printf("Shard Test\n");
+  if (shard_test() != 0) {
+    result = -1;
+    perror("Shard Test failed");
+  }
+  printf("---------------------------\n");
   printf("Model Precedence Test");
   solution = model_precedence_test(sim);
   if (solution == NULL) {
@@ -79,6 +227,13 @@ int main(void) {
     perror("Model Heuristics Time Indexed Test failed");
   }
   printf("---------------------------\n");
+  printf("Model Compact Time Indexed Test\n");
+  solution = model_compact_time_indexed_test(sim);
+  if (solution == NULL) {
+    result = -1;
+    perror("Model Compact Time Indexed Test failed");
+  }
+  printf("---------------------------\n");
 
   // Teardown
   if (solution != NULL) {
@@ -99,10 +254,21 @@ solution_t *model_precedence_test(simulation_t *simulation) {
     return NULL;
   }
 
-  if (GRBwrite(instance->model, "output/precedence.lp") != 0) {
+  if (simulation->backend->write(instance->model, "output/precedence.lp") != 0) {
     perror("Could not write precedence.lp");
     return NULL;
   }
+  // n C_j + n (n - 1) / 2 x_(i j), release and two big M rows per pair
+  int vars = 0, constrs = 0;
+  const backend_t *backend = simulation->backend;
+  if (backend->update(instance->model) != 0 ||
+      backend->get_int_attr(instance->model, ATTR_NUM_VARS, &vars) != 0 ||
+      backend->get_int_attr(instance->model, ATTR_NUM_CONSTRS, &constrs) != 0 ||
+      vars != 6 || constrs != 9) {
+    fprintf(stderr, "Precedence model has %d vars and %d constrs\n", vars,
+            constrs);
+    return NULL;
+  }
   return model_optimize(simulation, 0, Precedence);
 }
 
@@ -113,7 +279,7 @@ solution_t *model_positional_test(simulation_t *simulation) {
     return NULL;
   }
 
-  if (GRBwrite(instance->model, "output/positional.lp") != 0) {
+  if (simulation->backend->write(instance->model, "output/positional.lp") != 0) {
     perror("Could not write positional.lp");
     return NULL;
   }
@@ -127,7 +293,7 @@ solution_t *model_timeindexed_test(simulation_t *simulation) {
     return NULL;
   }
 
-  if (GRBwrite(instance->model, "output/timeindexed.lp") != 0) {
+  if (simulation->backend->write(instance->model, "output/timeindexed.lp") != 0) {
     perror("Could not write timeindexed.lp");
     return NULL;
   }
@@ -143,7 +309,7 @@ solution_t *model_heuristics_precedence_test(simulation_t *simulation) {
     return NULL;
   }
 
-  if (GRBwrite(instance->model, "output/heuristic_precedence.lp") != 0) {
+  if (simulation->backend->write(instance->model, "output/heuristic_precedence.lp") != 0) {
     perror("Could not write heuristic_precedence.lp");
     return NULL;
   }
@@ -161,7 +327,7 @@ solution_t *model_heuristics_positional_test(simulation_t *simulation) {
     return NULL;
   }
 
-  if (GRBwrite(instance->model, "output/heuristic_positional.lp") != 0) {
+  if (simulation->backend->write(instance->model, "output/heuristic_positional.lp") != 0) {
     perror("Could not write heuristic_positional.lp");
     return NULL;
   }
@@ -180,7 +346,7 @@ solution_t *model_heuristics_time_indexed_test(simulation_t *simulation) {
     return NULL;
   }
 
-  if (GRBwrite(instance->model, "output/heuristic_time_indexed.lp") != 0) {
+  if (simulation->backend->write(instance->model, "output/heuristic_time_indexed.lp") != 0) {
     perror("Could not write heuristic_time_indexed.lp");
     return NULL;
   }
@@ -189,3 +355,811 @@ solution_t *model_heuristics_time_indexed_test(simulation_t *simulation) {
     solution->heuristic_value = heuristic_value;
   return solution;
 }
+
+int orders_test(instance_t *instance) {
+  int r_js[3] = {5, 0, 2};
+  int by_release[3] = {1, 2, 0};
+  int by_processing[3] = {1, 0, 2};
+  int by_completion[3] = {1, 2, 0};
+  const orders_t *orders = instance_orders(instance);
+  if (orders == NULL)
+    return -1;
+  if (instance_orders(instance) != orders)
+    return -1;
+  for (size_t i = 0; i < instance->number_of_jobs; i++) {
+    // The instance itself must not be reordered
+    if (instance->release_dates[i] != r_js[i])
+      return -1;
+    if (orders->by_release[i] != by_release[i] ||
+        orders->by_processing[i] != by_processing[i] ||
+        orders->by_completion[i] != by_completion[i])
+      return -1;
+  }
+  return 0;
+}
+
+int evaluate_test(instance_t *instance) {
+  int sequences[3][3] = {{1, 2, 0}, {0, 1, 2}, {2, 0, 1}};
+  long long objectives[3] = {16, 30, 25};
+  int c_hs[3];
+  batch_t *batch = batch_init(instance->number_of_jobs, 3);
+  if (batch == NULL)
+    return -1;
+  for (size_t k = 0; k < 3; k++) {
+    if (evaluate(instance, sequences[k], c_hs) != objectives[k])
+      return -1;
+    if (batch_add(batch, sequences[k]) != 0)
+      return -1;
+  }
+  if (evaluate_batch(instance, batch) != 0)
+    return -1;
+  for (size_t k = 0; k < 3; k++) {
+    if (batch->objectives[k] != objectives[k])
+      return -1;
+  }
+  // {1, 2, 0} -> {0, 2, 1} and {1, 2, 0} -> {2, 1, 0}
+  evaluate(instance, sequences[0], c_hs);
+  if (evaluate_swap_delta(instance, sequences[0], c_hs, 0, 2) != 33 - 16)
+    return -1;
+  if (evaluate_insert_delta(instance, sequences[0], c_hs, 1, 0) != 23 - 16)
+    return -1;
+  batch_free(batch);
+  return 0;
+}
+
+int results_test(instance_t *instance) {
+  char *filename = "output/results-test.amod";
+  remove(filename);
+  // Two blocks: a full one and the records left at close
+  results_t *results = results_open(filename);
+  if (results == NULL)
+    return -1;
+  result_t record = {.solver = Positional, .status = 2, .runtime = 0.5};
+  results_features(instance, &record);
+  if (record.min_p_j != 1 || record.max_p_j != 4 || record.max_r_j != 5)
+    return -1;
+  for (size_t k = 0; k < RESULTS_BLOCK + 3; k++) {
+    record.instance = k + 1;
+    if (results_append(results, &record) != 0)
+      return -1;
+  }
+  if (results_close(results) != 0)
+    return -1;
+
+  long counts[2] = {0, 0}; // Records, blocks
+  if (results_scan(filename, results_count, counts) != 0)
+    return -1;
+  if (counts[0] != RESULTS_BLOCK + 3 || counts[1] != 2) {
+    fprintf(stderr, "Scanned %ld records in %ld blocks\n", counts[0],
+            counts[1]);
+    return -1;
+  }
+
+  // Flushed records are on disk before close, a crash keeps them
+  if ((results = results_open(filename)) == NULL)
+    return -1;
+  record.instance = RESULTS_BLOCK + 4;
+  int appended = results_append(results, &record) || results_flush(results);
+  counts[0] = counts[1] = 0;
+  int scanned = results_scan(filename, results_count, counts);
+  if (results_close(results) != 0 || appended != 0 || scanned != 0)
+    return -1;
+  if (counts[0] != RESULTS_BLOCK + 4 || counts[1] != 3) {
+    fprintf(stderr, "Scanned %ld records in %ld blocks before close\n",
+            counts[0], counts[1]);
+    return -1;
+  }
+  return 0;
+}
+
+int results_count(const results_block_t *block, void *data) {
+  long *counts = data;
+  for (size_t k = 0; k < block->length; k++) {
+    if (block->instance[k] != counts[0] + 1 || block->solver[k] != Positional)
+      return -1;
+    counts[0] += 1;
+  }
+  counts[1] += 1;
+  return 0;
+}
+
+int report_test(void) {
+  // Instance 1 of two campaigns: each formulation is the fastest on one
+  char *filename = "output/report-test.amod";
+  remove(filename);
+  results_t *results = results_open(filename);
+  if (results == NULL)
+    return -1;
+  double runtimes[2][2] = {{1, 2}, {4, 2}};
+  int result = 0;
+  for (size_t c = 0; c < 2; c++) {
+    for (solver_t s = 0; s < 2; s++) {
+      result_t record = {.solver = s,
+                         .instance = 1,
+                         .status = STATUS_OPTIMAL,
+                         .runtime = runtimes[c][s],
+                         .key = c + 1};
+      if (results_append(results, &record) != 0)
+        result = -1;
+    }
+  }
+  if (results_close(results) != 0 || result != 0)
+    return -1;
+  report_options_t options = {.store = filename,
+                              .imports_length = 0,
+                              .output = "output/report-test"};
+  if (report(&options) != 0)
+    return -1;
+  FILE *fp = fopen("output/report-test-profile.csv", "r");
+  if (fp == NULL)
+    return -1;
+  double tau = 0, profiles[2] = {0, 0};
+  if (fscanf(fp, "%*[^\n]\n%lf,%lf,%lf", &tau, &profiles[0],
+             &profiles[1]) != 3 ||
+      tau != 1 || profiles[0] != 0.5 || profiles[1] != 0.5)
+    result = -1;
+  fclose(fp);
+  return result;
+}
+
+int cache_test(instance_t *instance) {
+  char *folder = "output/cache-test";
+  // Same jobs in another order: job j of `instance` is job (j + 1) % 3
+  int processing_times[3] = {4, 3, 1};
+  int release_dates[3] = {2, 5, 0};
+  instance_t permuted = {.number_of_jobs = 3,
+                         .processing_times = processing_times,
+                         .release_dates = release_dates,
+                         .orders = NULL,
+                         .model = NULL};
+  int result = cache_hash(instance) == cache_hash(&permuted) ? 0 : -1;
+
+  int best[3] = {1, 2, 0}, worse[3] = {0, 1, 2};
+  cache_entry_t entry = {.objective = evaluate(instance, best, NULL),
+                         .bound = 5,
+                         .proven = 0,
+                         .sequence = best};
+  char *filename = formatted_string("%s/%016llx", folder, cache_hash(instance));
+  if (filename != NULL)
+    remove(filename);
+  free(filename);
+  if (result != 0 || cache_put(folder, instance, &entry) != 0)
+    result = -1;
+  entry.objective = evaluate(instance, worse, NULL);
+  entry.bound = 3;
+  entry.sequence = worse;
+  if (result != 0 || cache_put(folder, instance, &entry) != 0)
+    result = -1;
+
+  // The best sequence and bound are kept, translated to the permuted jobs
+  cache_entry_t cached;
+  if (result == 0 && cache_get(folder, &permuted, &cached) == 0) {
+    for (size_t h = 0; h < 3; h++) {
+      if (cached.sequence == NULL || cached.sequence[h] != (best[h] + 1) % 3)
+        result = -1;
+    }
+    if (cached.objective != evaluate(instance, best, NULL) ||
+        cached.bound != 5 || cached.proven)
+      result = -1;
+    cache_entry_free(&cached);
+  } else {
+    result = -1;
+  }
+
+  // A sequence that is not a permutation makes the entry missing
+  filename = formatted_string("%s/%016llx", folder, cache_hash(instance));
+  FILE *fp = filename != NULL ? fopen(filename, "w") : NULL;
+  if (fp != NULL) {
+    fprintf(fp, "%d 3\n0 1\n2 4\n5 3\n16 5 0\n0 0 2\n", CACHE_VERSION);
+    fclose(fp);
+  }
+  if (result != 0 || fp == NULL || cache_get(folder, instance, &cached) != 1 ||
+      cached.sequence != NULL || cached.objective != -1 || cached.bound != -1)
+    result = -1;
+  cache_entry_free(&cached);
+
+  // Threads merging the same entry keep every update: the highest bound
+  if (filename != NULL)
+    remove(filename);
+  free(filename);
+  pthread_t threads[4];
+  int firsts[4] = {1, 2, 3, 4}; // Thread t puts the bounds t, t + 4, ...
+  int started = 0;
+  for (; result == 0 && started < 4; started++) {
+    if (pthread_create(&threads[started], NULL, cache_put_thread,
+                       &firsts[started]) != 0)
+      break;
+  }
+  for (int t = 0; t < started; t++) {
+    void *failed = NULL;
+    pthread_join(threads[t], &failed);
+    if (failed != NULL)
+      result = -1;
+  }
+  if (result != 0 || started != 4 ||
+      cache_get(folder, instance, &cached) != 0 || cached.bound != 4 * 16)
+    result = -1;
+  cache_entry_free(&cached);
+  instance_orders_free(&permuted);
+  return result;
+}
+
+void *cache_put_thread(void *data) {
+  // Same jobs as the dummy instance, orders of its own
+  int processing_times[3] = {3, 1, 4};
+  int release_dates[3] = {5, 0, 2};
+  instance_t instance = {.number_of_jobs = 3,
+                         .processing_times = processing_times,
+                         .release_dates = release_dates,
+                         .orders = NULL,
+                         .model = NULL};
+  void *failed = NULL;
+  for (int k = 0; k < 16 && failed == NULL; k++) {
+    cache_entry_t entry = {.objective = -1,
+                           .bound = *(int *)data + 4 * k,
+                           .proven = 0,
+                           .sequence = NULL};
+    if (cache_put("output/cache-test", &instance, &entry) != 0)
+      failed = data;
+  }
+  instance_orders_free(&instance);
+  return failed;
+}
+
+int blocks_test(simulation_t *sim, instance_t *instance) {
+  // Job 1 is done at 1, the machine idles until job 2 is released at 2: the
+  // second block starts at 0, 2 earlier
+  blocks_t *blocks = blocks_split(instance);
+  if (blocks == NULL)
+    return -1;
+  int result = 0;
+  if (blocks->instances->length != 2 || blocks->jobs[0][0] != 1 ||
+      blocks->jobs[1][0] != 2 || blocks->jobs[1][1] != 0) {
+    result = -1;
+  } else {
+    instance_t *block = blocks->instances->values[1];
+    if (block->number_of_jobs != 2 || block->release_dates[0] != 0 ||
+        block->release_dates[1] != 3 || block->processing_times[1] != 3 ||
+        blocks->offsets[1] != 2)
+      result = -1;
+  }
+  // Solved exactly, the shifted block optima add up to the optimum 16
+  int sequence[3];
+  solution_t *solution =
+      result == 0 ? blocks_solve(sim, instance, blocks, Positional, 10, 1, 20,
+                                 sequence)
+                  : NULL;
+  if (solution == NULL || solution->status != STATUS_OPTIMAL ||
+      solution->objective_value != 16 || solution->bound != 16)
+    result = -1;
+  if (solution != NULL)
+    free(solution->values);
+  free(solution);
+  blocks_free(blocks);
+  return result;
+}
+
+int dominance_test(void) {
+  // Jobs 0 and 1 take as long, job 1 is released first
+  int processing_times[3] = {2, 2, 1};
+  int release_dates[3] = {3, 0, 0};
+  instance_t instance = {.number_of_jobs = 3,
+                         .processing_times = processing_times,
+                         .release_dates = release_dates,
+                         .orders = NULL,
+                         .model = NULL};
+  dominance_t *dominance = dominance_init(&instance);
+  if (dominance == NULL)
+    return -1;
+  int result = 0;
+  if (!dominance_before(dominance, 1, 0) || dominance_before(dominance, 0, 1) ||
+      dominance_before(dominance, 2, 0) || dominance->heads[0] != 3 ||
+      dominance->tails[1] != 2 || dominance->predecessors[0] != 1)
+    result = -1;
+  dominance_free(dominance);
+
+  int sequence[3] = {0, 2, 1};
+  long long before = evaluate(&instance, sequence, NULL);
+  if (result == 0 && dominance_repair(&instance, sequence) != 0)
+    result = -1;
+  if (sequence[0] != 1 || sequence[1] != 2 || sequence[2] != 0 ||
+      evaluate(&instance, sequence, NULL) > before)
+    result = -1;
+  instance_orders_free(&instance);
+  return result;
+}
+
+int refine_test(simulation_t *sim, instance_t *instance) {
+  // T = 14: 12 + 14 + 11 start times
+  if (refine_size(instance) != 37)
+    return -1;
+  // The recorder never solves: the earliest release date order is kept
+  int sequence[3];
+  solution_t *solution = refine_solve(sim, instance, TimeIndexed, 10, sequence);
+  if (solution == NULL)
+    return -1;
+  int result = 0;
+  const int *by_release = instance_orders(instance)->by_release;
+  long long expected = evaluate(instance, by_release, NULL);
+  if (solution->status != STATUS_REFINED ||
+      solution->objective_value != expected || solution->values[0] != 9 ||
+      sequence[0] != by_release[0])
+    result = -1;
+  free(solution->values);
+  free(solution);
+  return result;
+}
+
+int relax_test(simulation_t *sim) {
+  instance_t *instance = sim->instances->values[0];
+  const backend_t *backend = sim->backend;
+  if (model_init(sim, 0, Positional, NULL) != 0)
+    return -1;
+  // Same rows and bounds, no integer variable left
+  void *relaxed = NULL;
+  int result = backend->relax(instance->model, &relaxed);
+  int counts[3][2];
+  const char *attributes[3] = {ATTR_NUM_VARS, ATTR_NUM_CONSTRS, ATTR_NUM_NZS};
+  for (size_t a = 0; a < 3 && result == 0; a++) {
+    if (backend->get_int_attr(instance->model, attributes[a],
+                              &counts[a][0]) != 0 ||
+        backend->get_int_attr(relaxed, attributes[a], &counts[a][1]) != 0 ||
+        counts[a][0] != counts[a][1])
+      result = -1;
+  }
+  double ub[2];
+  if (result == 0 &&
+      (backend->get_dbl_array(relaxed, ATTR_UB, 3, 1, &ub[0]) != 0 ||
+       backend->get_dbl_array(instance->model, ATTR_UB, 3, 1, &ub[1]) != 0 ||
+       ub[0] != ub[1] || ub[0] != 1))
+    result = -1;
+  char buffer[4096];
+  FILE *fp = NULL;
+  if (result == 0 &&
+      (backend->write(relaxed, "output/relaxed.lp") != 0 ||
+       (fp = fopen("output/relaxed.lp", "r")) == NULL))
+    result = -1;
+  if (fp != NULL) {
+    size_t length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+    buffer[length] = '\0';
+    fclose(fp);
+    // Both sections are written, empty
+    if (strstr(buffer, "Generals\nBinaries\nEnd") == NULL)
+      result = -1;
+  }
+  backend->model_free(relaxed);
+  backend->model_free(instance->model);
+  instance->model = NULL;
+  return result;
+}
+
+int online_test(simulation_t *sim) {
+  // Job 0 (p 5, r 0) and job 1 (p 1, r 1): known only at its release, job 1
+  // finds job 0 started (5 + 6), known one unit earlier it goes first (2 + 7)
+  int processing_times[2] = {5, 1};
+  int release_dates[2] = {0, 1};
+  instance_t instance = {.number_of_jobs = 2,
+                         .processing_times = processing_times,
+                         .release_dates = release_dates};
+  instance_t *pointer = &instance;
+  vector_t instances = {.allocated_length = 1, .length = 1,
+                        .values = (void **)&pointer};
+  simulation_t online_sim = *sim;
+  online_sim.instances = &instances;
+  FILE *fp = fopen("output/online-test.csv", "w");
+  if (fp == NULL)
+    return -1;
+  int result = 0;
+  const long long expected[2] = {11, 9};
+  for (int lead = 0; lead < 2 && result == 0; lead++) {
+    online_options_t options = {.budget = ONLINE_BUDGET / 1000,
+                                .lead = lead,
+                                .exact = ONLINE_EXACT,
+                                .solver = -1};
+    online_stats_t stats;
+    double latencies[2];
+    if (online_replay(&online_sim, 0, &options, fp, latencies, &stats) != 0 ||
+        stats.arrivals != 2 - lead || stats.objective != expected[lead] ||
+        stats.offline != 9)
+      result = -1;
+  }
+  fclose(fp);
+  instance_orders_free(&instance);
+  return result;
+}
+
+int serve_test(simulation_t *sim) {
+  // The dummy instance, by dynamic programming then by the model (the
+  // recorder finds nothing, the best simple order is the answer)
+  char requests[4][64] = {"a 1 5 3 3 5 1 0 4 2\n", "b 1 5 3 3 5 1 0\n",
+                          "c 1 5 3 3 5 1 0 4 2\n", "d 1 nan 1 3 0\n"};
+  instance_t *none = NULL;
+  vector_t instances = {.allocated_length = 1, .length = 1,
+                        .values = (void **)&none};
+  simulation_t serve_sim = *sim;
+  serve_sim.instances = &instances;
+  serve_options_t options = {.time_limit = SERVE_TIME_LIMIT, .exact = 20};
+  FILE *fp = fopen("output/serve-test.txt", "w+");
+  if (fp == NULL)
+    return -1;
+  int result = 0;
+  if (serve_line(&serve_sim, requests[0], &options, fp) != 0 ||
+      serve_line(&serve_sim, requests[1], &options, fp) == 0)
+    result = -1;
+  options.exact = 0;
+  if (serve_line(&serve_sim, requests[2], &options, fp) != 0 ||
+      serve_line(&serve_sim, requests[3], &options, fp) == 0)
+    result = -1;
+  // Time-indexed model of 1000 jobs of 10000: 10^10 variables, then the
+  // positional model of the dummy instance in a budget smaller than any model
+  char *large = malloc(16 + 8 * 1000);
+  if (large == NULL)
+    result = -1;
+  else {
+    int length = sprintf(large, "e 2 5 1000");
+    for (int j = 0; j < 1000; j++) {
+      length += sprintf(large + length, " 10000 0");
+    }
+    sprintf(large + length, "\n");
+    if (serve_line(&serve_sim, large, &options, fp) == 0)
+      result = -1;
+    free(large);
+  }
+  char small[64] = "f 1 5 3 3 5 1 0 4 2\n";
+  if ((serve_sim.memory = memory_init(0.01, NULL)) == NULL ||
+      serve_line(&serve_sim, small, &options, fp) == 0)
+    result = -1;
+  memory_free(serve_sim.memory);
+  rewind(fp);
+  char id[3][8], sequence[3][64];
+  int status = 0;
+  long long objective[2];
+  if (result == 0 &&
+      (fscanf(fp, "%7s %d %lld %*f %*f %*f %63[0-9 ]\n", id[0], &status,
+              &objective[0], sequence[0]) != 4 ||
+       fscanf(fp, "%7s %63[^\n]\n", id[1], sequence[1]) != 2 ||
+       fscanf(fp, "%7s %*d %lld %*f %*f %*f %63[0-9 ]\n", id[2],
+              &objective[1], sequence[2]) != 3))
+    result = -1;
+  char errors[3][64];
+  for (size_t k = 0; k < 3 && result == 0; k++) {
+    if (fscanf(fp, "%*s %63[^\n]\n", errors[k]) != 1)
+      result = -1;
+  }
+  if (result == 0 && (strcmp(errors[1], "error model too large") != 0 ||
+                      strcmp(errors[2], "error model does not fit in the "
+                                        "memory left") != 0))
+    result = -1;
+  if (result == 0 &&
+      (strcmp(id[0], "a") != 0 || status != STATUS_OPTIMAL ||
+       objective[0] != 16 || strcmp(sequence[0], "2 3 1") != 0 ||
+       strcmp(id[1], "b") != 0 || strncmp(sequence[1], "error", 5) != 0 ||
+       strcmp(id[2], "c") != 0 || objective[1] != 16 ||
+       strcmp(sequence[2], "2 3 1") != 0 || none != NULL))
+    result = -1;
+  fclose(fp);
+  return result;
+}
+
+int lns_test(simulation_t *sim, instance_t *instance) {
+  // The recorder never solves: the best of the start (sum C_j 30) and the
+  // simple orders is kept, the earliest release date one (16)
+  int start[3] = {0, 1, 2};
+  int sequence[3];
+  solution_t *solution =
+      lns_solve(sim, instance, Positional, 10, 2, start, sequence);
+  if (solution == NULL)
+    return -1;
+  int result = 0;
+  const int *by_release = instance_orders(instance)->by_release;
+  if (solution->status != STATUS_LNS || solution->objective_value != 16 ||
+      memcmp(sequence, by_release, sizeof(sequence)) != 0 ||
+      solution->values[0] != 9 || instance->model != NULL)
+    result = -1;
+  free(solution->values);
+  free(solution);
+  return result;
+}
+
+solution_t *model_compact_time_indexed_test(simulation_t *simulation) {
+  instance_t *instance = simulation->instances->values[0];
+  if (model_init(simulation, 0, CompactTimeIndexed, NULL) != 0) {
+    perror("Could not init model");
+    return NULL;
+  }
+
+  if (simulation->backend->write(instance->model,
+                                 "output/compact_timeindexed.lp") != 0) {
+    perror("Could not write compact_timeindexed.lp");
+    return NULL;
+  }
+
+  // Fewer nonzeros than the time indexed model once p_j > 2
+  int processing_times[2] = {40, 25};
+  int release_dates[2] = {0, 3};
+  instance_t large = {.number_of_jobs = 2,
+                      .processing_times = processing_times,
+                      .release_dates = release_dates};
+  long variables = 0, nonzeros = 0, compact_variables = 0, compact_nonzeros = 0;
+  model_counts(&large, TimeIndexed, &variables, &nonzeros);
+  model_counts(&large, CompactTimeIndexed, &compact_variables,
+               &compact_nonzeros);
+  if (compact_variables != variables || compact_nonzeros * 4 > nonzeros)
+    return NULL;
+
+  return model_optimize(simulation, 0, CompactTimeIndexed);
+}
+
+int memory_test(simulation_t *sim, instance_t *instance) {
+  int result = 0;
+  // The estimates use the sizes of the models without building them
+  for (solver_t solver = Precedence; solver < NUMBER_OF_SOLVERS; solver++) {
+    if (solver_formulation(solver) != solver || solver == DynamicProgramming)
+      continue;
+    long variables = 0, nonzeros = 0;
+    int built_variables = 0, built_nonzeros = 0;
+    model_counts(instance, solver, &variables, &nonzeros);
+    if (model_init(sim, 0, solver, NULL) != 0 ||
+        sim->backend->get_int_attr(instance->model, ATTR_NUM_VARS,
+                                   &built_variables) != 0 ||
+        sim->backend->get_int_attr(instance->model, ATTR_NUM_NZS,
+                                   &built_nonzeros) != 0 ||
+        built_variables != variables || built_nonzeros != nonzeros)
+      result = -1;
+    if (instance->model != NULL)
+      sim->backend->model_free(instance->model);
+    instance->model = NULL;
+  }
+
+  // Limits of the admitted models never add up to more than the budget
+  memory_t *memory = memory_init(2, NULL);
+  if (memory == NULL)
+    return -1;
+  double limit = 0, last = 0;
+  if (memory_acquire(memory, 0.75, &limit) != 0 || limit != 0.9375 ||
+      memory_acquire(memory, 0.75, &limit) != 0 || limit != 0.9375 ||
+      memory_acquire(memory, 0.125, &last) != 0 || last != 0.125 ||
+      memory_acquire(memory, 0.125, &limit) != 1)
+    result = -1;
+  memory_release(memory, last);
+  if (memory_acquire(memory, 0.125, &limit) != 0 || limit != 0.125)
+    result = -1;
+  memory_free(memory);
+  return result;
+}
+
+int dp_test(instance_t *instance) {
+  // Job 1 at 0, job 2 at 2, job 0 at 6: 1 + 6 + 9
+  int sequence[7];
+  solution_t *solution =
+      dp_solve(instance, DynamicProgramming, 10, 1, sequence);
+  if (solution == NULL)
+    return -1;
+  int result = 0;
+  if (solution->status != STATUS_OPTIMAL || solution->objective_value != 16 ||
+      sequence[0] != 1 || sequence[1] != 2 || sequence[2] != 0)
+    result = -1;
+  free(solution->values);
+  free(solution);
+
+  // Equal processing times and idle time to fill: every order is compared
+  int processing_times[7] = {2, 2, 5, 1, 3, 2, 4};
+  int release_dates[7] = {0, 9, 1, 4, 4, 12, 0};
+  instance_t other = {.number_of_jobs = 7,
+                      .processing_times = processing_times,
+                      .release_dates = release_dates,
+                      .orders = NULL,
+                      .model = NULL};
+  solution = dp_solve(&other, DynamicProgramming, 10, 2, sequence);
+  if (solution == NULL) {
+    instance_orders_free(&other);
+    return -1;
+  }
+  int order[7] = {0, 1, 2, 3, 4, 5, 6};
+  long long best = evaluate(&other, order, NULL);
+  // Next permutation in lexicographic order until the last one
+  for (;;) {
+    int i = 5;
+    while (i >= 0 && order[i] > order[i + 1])
+      i--;
+    if (i < 0)
+      break;
+    int j = 6;
+    while (order[j] < order[i])
+      j--;
+    int swap = order[i];
+    order[i] = order[j];
+    order[j] = swap;
+    for (int a = i + 1, b = 6; a < b; a++, b--) {
+      swap = order[a];
+      order[a] = order[b];
+      order[b] = swap;
+    }
+    long long value = evaluate(&other, order, NULL);
+    if (value < best)
+      best = value;
+  }
+  if (solution->objective_value != best ||
+      evaluate(&other, sequence, NULL) != best)
+    result = -1;
+  free(solution->values);
+  free(solution);
+  instance_orders_free(&other);
+  return result;
+}
+
+int arena_test(simulation_t *sim) {
+  int result = 0;
+  arena_t *arena = arena_init(64);
+  if (arena == NULL)
+    return -1;
+  // Aligned buffers, growing past the first chunk
+  char *small = arena_alloc(arena, 3);
+  double *large = arena_alloc(arena, sizeof(*large) * ARENA_CHUNK);
+  char *name = arena_printf(arena, "x_(%d,%d)", 12, 345);
+  if (small == NULL || large == NULL || name == NULL ||
+      (size_t)large % alignof(max_align_t) != 0 || strcmp(name, "x_(12,345)"))
+    result = -1;
+  large[ARENA_CHUNK - 1] = 1;
+  arena_reset(arena);
+  // Merged into one chunk: the same allocations no longer reach the heap
+  long heap_allocations = arena->heap_allocations;
+  if (arena->used != 0 || arena_alloc(arena, 3) == NULL ||
+      arena_alloc(arena, sizeof(*large) * ARENA_CHUNK) == NULL ||
+      arena_printf(arena, "x_(%d,%d)", 12, 345) == NULL ||
+      arena->heap_allocations != heap_allocations)
+    result = -1;
+  arena_free(arena);
+
+  // Building the same models again does not grow the arena
+  for (int round = 0; round < 2 && result == 0; round++) {
+    heap_allocations = sim->arena->heap_allocations;
+    for (solver_t solver = Precedence; solver <= Heuristics_TimeIndexed;
+         solver++) {
+      int heuristic_value = -1;
+      instance_t *instance = sim->instances->values[0];
+      if (model_init(sim, 0, solver, &heuristic_value) != 0)
+        result = -1;
+      sim->backend->model_free(instance->model);
+      instance->model = NULL;
+    }
+    if (round == 1 && sim->arena->heap_allocations != heap_allocations)
+      result = -1;
+  }
+  if (sim->arena->used != 0)
+    result = -1;
+  return result;
+}
+
+int shard_test(void) {
+  // Instances of 3 to 6 jobs, solved by 3 shards then by a single process
+  char *filename = "output/shard-test.csv";
+  FILE *fp = fopen(filename, "w");
+  if (fp == NULL)
+    return -1;
+  fprintf(fp, "Instance,ProcessingTime,ReleaseDate\n");
+  for (int i = 1; i <= 4; i++) {
+    for (int j = 0; j < i + 2; j++) {
+      fprintf(fp, "%d,%d,%d\n", i, 1 + (i * 7 + j * 3) % 5, (j * i) % 4);
+    }
+  }
+  fclose(fp);
+  run_options_t options = {.filename = filename,
+                           .budget = 0,
+                           .cache = "output/cache-shard-test",
+                           .transfer = 1,
+                           .workers = 0,
+                           .refine = REFINE_MAX_VARS,
+                           .exact = 0,
+                           .lns = 0,
+                           .memory = 0,
+                           .shard = 1,
+                           .shards = 3,
+                           .status = 0};
+  // Solver, instance, status and sum C_j of every row (runtimes differ)
+  double merged[64][4], single[64][4], sharded[64][4];
+  int owners[8] = {0};
+  int result = 0;
+  for (int k = 1; k <= 3 && result == 0; k++) {
+    options.shard = k;
+    char shard_file[64];
+    snprintf(shard_file, sizeof(shard_file), RUN_SHARD_OUTPUT, "solution", k,
+             3);
+    int length = run(&options) == 0 ? shard_rows(shard_file, sharded, 64)
+                                      : -1;
+    // Every formulation of an instance in the same shard
+    for (int r = 0; r < length; r++) {
+      int i = sharded[r][1];
+      if (i < 1 || i > 7 || (owners[i] != 0 && owners[i] != k))
+        result = -1;
+      owners[i] = k;
+    }
+    if (length < 0)
+      result = -1;
+  }
+  int length = result == 0 && merge(3) == 0
+                   ? shard_rows("output/solution.csv", merged, 64)
+                   : -1;
+  options.shard = 1;
+  options.shards = 1;
+  if (length <= 0 || run(&options) != 0 ||
+      shard_rows("output/solution.csv", single, 64) != length)
+    return -1;
+  for (int r = 0; r < length; r++) {
+    for (int c = 0; c < 4; c++) {
+      if (merged[r][c] != single[r][c]) {
+        fprintf(stderr, "Row %d differs: %g against %g\n", r + 1,
+                merged[r][c], single[r][c]);
+        result = -1;
+      }
+    }
+  }
+  return result;
+}
+
+int shard_rows(const char *filename, double rows[][4], int length) {
+  FILE *fp = fopen(filename, "r");
+  if (fp == NULL)
+    return -1;
+  fscanf(fp, "%*[^\n]\n");
+  int solver = 0, instance = 0, status = 0, k = 0;
+  double objective = 0;
+  while (k < length && fscanf(fp, "%d,%d,%d,%*f,%lf,%*f\n", &solver,
+                              &instance, &status, &objective) == 4) {
+    rows[k][0] = solver;
+    rows[k][1] = instance;
+    rows[k][2] = status;
+    rows[k][3] = objective;
+    k += 1;
+  }
+  fclose(fp);
+  return k;
+}
+
+int status_test(simulation_t *sim) {
+  int result = 0;
+  job_t jobs[2] = {{.solver = Precedence, .instance = 0, .predicted = 2},
+                   {.solver = TimeIndexed, .instance = 0, .predicted = 3}};
+  schedule_t schedule = {.budget = 0, .length = 2, .jobs = jobs};
+  status_t *status = status_start(&schedule, NULL, 1, 1);
+  if (status == NULL)
+    return -1;
+  // The backend reports to the slot of the running job
+  int slot = status_begin(status, sim, &jobs[0]);
+  if (slot < 0 || sim->progress == NULL)
+    result = -1;
+  else
+    sim->progress->report(sim->progress, 10, 8);
+  char buffer[4096];
+  FILE *fp = tmpfile();
+  if (fp == NULL) {
+    status_stop(status);
+    return -1;
+  }
+  status_print(status, fp);
+  rewind(fp);
+  size_t length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+  buffer[length] = '\0';
+  fclose(fp);
+  if (strstr(buffer, "\"gap\": 0.200000") == NULL ||
+      strstr(buffer, "\"queued\": 1,") == NULL)
+    result = -1;
+
+  jobs[0].runtime = 4;
+  status_end(status, slot, sim, &jobs[0], 1);
+  if (sim->progress != NULL)
+    result = -1;
+  // The queue left at the speed of the finished job: 3 * 4 / 2
+  status_stop(status);
+  fp = fopen(STATUS_FILE, "r");
+  if (fp == NULL)
+    return -1;
+  length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+  buffer[length] = '\0';
+  fclose(fp);
+  if (strstr(buffer, "\"completed\": 1,") == NULL ||
+      strstr(buffer, "\"eta_seconds\": 6,") == NULL ||
+      strstr(buffer, "\"running\": [],") == NULL)
+    result = -1;
+  return result;
+}